@@ -6,7 +6,7 @@
 # Compilador y banderas
 CC = gcc
 CFLAGS = -Iinclude -Wall -Wextra -std=c99
-LDFLAGS = -lm
+LDFLAGS = -lm -pthread
 DEBUG_FLAGS = -g -DDEBUG
 RELEASE_FLAGS = -O2
 
@@ -16,6 +16,7 @@ LIB_DIR = lib
 INCLUDE_DIR = include
 BIN_DIR = bin
 OBJ_DIR = obj
+BENCH_DIR = bench
 
 # Archivos fuente
 MAIN_SRC = $(SRC_DIR)/MainCalculator.c
@@ -26,13 +27,19 @@ MODULE_SRCS := $(filter-out $(MAIN_SRC), $(MODULE_SRCS))
 LIB_SRCS = $(wildcard $(LIB_DIR)/*.c)
 LIB_OBJS = $(patsubst $(LIB_DIR)/%.c, $(OBJ_DIR)/%.o, $(LIB_SRCS))
 
+# Benchmarks (bench_*.c con main, el resto son auxiliares)
+BENCH_SRCS = $(wildcard $(BENCH_DIR)/bench_*.c)
+BENCH_AUX = $(filter-out $(BENCH_SRCS), $(wildcard $(BENCH_DIR)/*.c))
+BENCHMARKS = $(patsubst $(BENCH_DIR)/%.c, $(BIN_DIR)/%, $(BENCH_SRCS))
+
 # Ejecutables
 EXECUTABLES = $(BIN_DIR)/MainCalculator \
               $(BIN_DIR)/PRE-LETTERS \
               $(BIN_DIR)/Infix \
               $(BIN_DIR)/POSTFIX-LETTERS \
               $(BIN_DIR)/PRE-NUM \
-              $(BIN_DIR)/POST-NUM
+              $(BIN_DIR)/POST-NUM \
+              $(BIN_DIR)/Batch
 
 # Colores para mensajes
 RED = \033[0;31m
@@ -51,7 +58,7 @@ MSG_DONE = printf "${GREEN}[+] COMPILACIÓN COMPLETADA${NC}\n"
 # REGLAS PRINCIPALES
 # ===============================================
 
-.PHONY: all debug release clean help run test
+.PHONY: all debug release clean help run test bench
 
 # Compilación por defecto (release)
 all: release
@@ -105,10 +112,25 @@ $(BIN_DIR)/Infix: $(SRC_DIR)/Infix.c $(LIB_OBJS) | $(BIN_DIR)
 	@$(MSG_LINKING) $(notdir $@)
 	@$(CC) $(CFLAGS) $< $(LIB_OBJS) -o $@ $(LDFLAGS)
 
+# Batch (evaluador por lotes con hilos)
+$(BIN_DIR)/Batch: $(SRC_DIR)/Batch.c $(LIB_OBJS) | $(BIN_DIR)
+	@$(MSG_LINKING) $(notdir $@)
+	@$(CC) $(CFLAGS) $< $(LIB_OBJS) -o $@ $(LDFLAGS)
+
+# Benchmarks (siempre optimizados)
+$(BIN_DIR)/bench_%: $(BENCH_DIR)/bench_%.c $(BENCH_AUX) $(LIB_OBJS) | $(BIN_DIR)
+	@$(MSG_LINKING) $(notdir $@)
+	@$(CC) $(CFLAGS) -I$(BENCH_DIR) $< $(BENCH_AUX) $(LIB_OBJS) -o $@ $(LDFLAGS)
+
 # ===============================================
 # REGLAS ADICIONALES
 # ===============================================
 
+# Compilar los benchmarks
+bench: CFLAGS += $(RELEASE_FLAGS)
+bench: $(BENCHMARKS)
+	@$(MSG_DONE)
+
 # Ejecutar el programa principal
 run: $(BIN_DIR)/MainCalculator
 	@echo ""
@@ -149,6 +171,7 @@ help:
 	@echo "  ${GREEN}make release${NC}   - Compilar optimizado"
 	@echo "  ${GREEN}make run${NC}       - Compilar y ejecutar MainCalculator"
 	@echo "  ${GREEN}make test${NC}      - Verificar que todos los módulos se compilaron"
+	@echo "  ${GREEN}make bench${NC}     - Compilar los benchmarks (bench/)"
 	@echo "  ${GREEN}make clean${NC}     - Eliminar archivos generados"
 	@echo "  ${GREEN}make help${NC}      - Mostrar esta ayuda"
 	@echo ""
@@ -0,0 +1,294 @@
+/*
+    bench.c
+*/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "bench.h"
+#include "stats.h"
+
+/*
+    Monotonic clock in nanoseconds
+*/
+unsigned long long bench_now (void) {
+    return stats_now();
+}
+
+/*
+    Resident set size of the process in KB, -1 when unknown
+*/
+long bench_rss_kb (void) {
+#ifdef __linux__
+    FILE *file;
+    long pages, resident;
+
+    if ((file = fopen("/proc/self/statm", "r")) == NULL)
+        return -1;
+
+    if (fscanf(file, "%ld %ld", &pages, &resident) != 2)
+        resident = -1;
+
+    fclose(file);
+
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
+
+/*
+    Open a hardware cache-miss counter for the calling thread
+    Returns -1 when perf_event_open is not available
+*/
+int bench_perf_open (void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/*
+    Reset and start the counter
+*/
+void bench_perf_start (int fd) {
+#ifdef __linux__
+    if (fd < 0)
+        return;
+
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#else
+    (void)fd;
+#endif
+}
+
+/*
+    Stop the counter and read it
+*/
+unsigned long long bench_perf_stop (int fd) {
+#ifdef __linux__
+    unsigned long long count = 0;
+
+    if (fd < 0)
+        return 0;
+
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    if (read(fd, &count, sizeof(count)) != sizeof(count))
+        return 0;
+
+    return count;
+#else
+    (void)fd;
+    return 0;
+#endif
+}
+
+/*
+    Close the counter
+*/
+void bench_perf_close (int fd) {
+#ifdef __linux__
+    if (fd >= 0)
+        close(fd);
+#else
+    (void)fd;
+#endif
+}
+
+/*
+    Initialize a sample set
+*/
+int bench_samples_init (BenchSamples *samples, int capacity) {
+    samples->size = 0;
+    samples->capacity = capacity > 0 ? capacity : 1;
+
+    if ((samples->ns = (unsigned long long *)malloc(samples->capacity * sizeof(unsigned long long))) == NULL)
+        return -1;
+
+    return 0;
+}
+
+/*
+    Destroy a sample set
+*/
+void bench_samples_destroy (BenchSamples *samples) {
+    free(samples->ns);
+    memset(samples, 0, sizeof(BenchSamples));
+}
+
+/*
+    Add a sample, silently dropped when the set is full
+*/
+void bench_samples_add (BenchSamples *samples, unsigned long long ns) {
+    if (samples->size < samples->capacity)
+        samples->ns[samples->size++] = ns;
+}
+
+static int compare_ull (const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+    Percentile p (0-100) of the samples, sorts them in place
+*/
+double bench_percentile (BenchSamples *samples, double p) {
+    int index;
+
+    if (samples->size == 0)
+        return 0.0;
+
+    qsort(samples->ns, samples->size, sizeof(unsigned long long), compare_ull);
+
+    index = (int)(p / 100.0 * (samples->size - 1) + 0.5);
+
+    return (double)samples->ns[index];
+}
+
+/*
+    Load a baseline file, a missing file gives an empty baseline
+*/
+int bench_baseline_load (BenchBaseline *baseline, const char *path) {
+    FILE *file;
+    char key[256];
+    char **keys;
+    double *values;
+    double value;
+    int capacity = 0;
+
+    memset(baseline, 0, sizeof(BenchBaseline));
+
+    if ((file = fopen(path, "r")) == NULL)
+        return -1;
+
+    while (fscanf(file, "%255s %lf", key, &value) == 2) {
+        if (baseline->size == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+
+            // The arrays stay in baseline until both grew, to be freed on failure
+            if ((keys = (char **)realloc(baseline->keys, capacity * sizeof(char *))) != NULL)
+                baseline->keys = keys;
+
+            if (keys == NULL || (values = (double *)realloc(baseline->values, capacity * sizeof(double))) == NULL) {
+                fclose(file);
+                bench_baseline_destroy(baseline);
+                return -1;
+            }
+
+            baseline->values = values;
+        }
+
+        if ((baseline->keys[baseline->size] = (char *)malloc(strlen(key) + 1)) == NULL) {
+            fclose(file);
+            bench_baseline_destroy(baseline);
+            return -1;
+        }
+
+        strcpy(baseline->keys[baseline->size], key);
+        baseline->values[baseline->size++] = value;
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+/*
+    Destroy a baseline
+*/
+void bench_baseline_destroy (BenchBaseline *baseline) {
+    int i;
+
+    for (i = 0; i < baseline->size; i++)
+        free(baseline->keys[i]);
+
+    free(baseline->keys);
+    free(baseline->values);
+    memset(baseline, 0, sizeof(BenchBaseline));
+}
+
+/*
+    Find a value in a baseline
+*/
+int bench_baseline_lookup (const BenchBaseline *baseline, const char *key, double *value) {
+    int i;
+
+    for (i = 0; i < baseline->size; i++) {
+        if (strcmp(baseline->keys[i], key) == 0) {
+            *value = baseline->values[i];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+    State of bench_random, the same numbers for the same seed
+*/
+static unsigned long long bench_state = 0x9E3779B97F4A7C15ULL;
+
+/*
+    Restart bench_random from seed, which must not be 0
+*/
+void bench_seed (unsigned long long seed) {
+    bench_state = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+/*
+    Next xorshift64 number
+*/
+unsigned long long bench_random (void) {
+    bench_state ^= bench_state << 13;
+    bench_state ^= bench_state >> 7;
+    bench_state ^= bench_state << 17;
+
+    return bench_state;
+}
+
+/*
+    Numeric command line option "-name value"
+*/
+long bench_arg (int argc, char **argv, const char *name, long fallback) {
+    const char *value = bench_arg_str(argc, argv, name);
+
+    return value == NULL ? fallback : (long)strtod(value, NULL);
+}
+
+/*
+    String command line option "-name value"
+*/
+const char *bench_arg_str (int argc, char **argv, const char *name) {
+    int i;
+
+    for (i = 1; i < argc - 1; i++) {
+        if (argv[i][0] == '-' && strcmp(argv[i] + 1, name) == 0)
+            return argv[i + 1];
+    }
+
+    return NULL;
+}
@@ -0,0 +1,53 @@
+/*
+    bench.h
+*/
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+/*
+    Latency samples of one measured run
+*/
+typedef struct BenchSamples_ {
+    int size;
+    int capacity;
+    unsigned long long *ns;
+} BenchSamples;
+
+/*
+    Baseline results, one "key value" pair per line
+*/
+typedef struct BenchBaseline_ {
+    int size;
+    char **keys;
+    double *values;
+} BenchBaseline;
+
+/*
+    Public Interfaces
+*/
+unsigned long long bench_now (void);
+long bench_rss_kb (void);
+
+int bench_perf_open (void);
+void bench_perf_start (int fd);
+unsigned long long bench_perf_stop (int fd);
+void bench_perf_close (int fd);
+
+int bench_samples_init (BenchSamples *samples, int capacity);
+void bench_samples_destroy (BenchSamples *samples);
+void bench_samples_add (BenchSamples *samples, unsigned long long ns);
+double bench_percentile (BenchSamples *samples, double p);
+
+int bench_baseline_load (BenchBaseline *baseline, const char *path);
+void bench_baseline_destroy (BenchBaseline *baseline);
+int bench_baseline_lookup (const BenchBaseline *baseline, const char *key, double *value);
+
+void bench_seed (unsigned long long seed);
+unsigned long long bench_random (void);
+
+long bench_arg (int argc, char **argv, const char *name, long fallback);
+const char *bench_arg_str (int argc, char **argv, const char *name);
+
+#endif
@@ -0,0 +1,220 @@
+/*
+    bench_bqueue.c
+    Throughput and wakeups of the blocking queue, one element per call
+    against batches
+
+    Usage: bench_bqueue [-items N] [-producers P] [-consumers C] [-capacity N] [-batch B]
+    P producers enqueue -items unique values in total into a queue
+    bounded to -capacity, C consumers dequeue them; the queue is closed
+    once the producers finish and the consumers drain it. "single" moves
+    one element per call, "batch" uses enqueue_many and dequeue_many
+    with B elements. Every value must be dequeued exactly once.
+    WAITS/ITEM is how often a consumer had to sleep per element
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bqueue.h"
+#include "bench.h"
+
+/*
+    Shared state of one run
+*/
+typedef struct Run_ {
+    BQueue bqueue;
+    int batch;
+    long items;
+    int producers;
+
+    /* Times every value was dequeued, indexed by value - 1 */
+    unsigned char *seen;
+} Run;
+
+typedef struct Worker_ {
+    Run *run;
+    int index;
+    pthread_t thread;
+
+    char pad[64];
+} Worker;
+
+static void *producer_main (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    void *items[256];
+    long value, first, last;
+    int n = 0, done;
+
+    // Each producer owns a contiguous range of values
+    first = run->items * worker->index / run->producers + 1;
+    last = run->items * (worker->index + 1) / run->producers;
+
+    for (value = first; value <= last; value++) {
+        if (run->batch == 1) {
+            bqueue_enqueue(&run->bqueue, (void *)value, -1);
+            continue;
+        }
+
+        items[n++] = (void *)value;
+
+        if (n == run->batch || value == last) {
+            for (done = 0; done < n; )
+                done += bqueue_enqueue_many(&run->bqueue, items + done, n - done, -1);
+            n = 0;
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer_main (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    void *items[256];
+    int i, n;
+
+    while ((n = bqueue_dequeue_many(&run->bqueue, items, run->batch, -1)) > 0) {
+        for (i = 0; i < n; i++)
+            __atomic_fetch_add(&run->seen[(size_t)items[i] - 1], 1, __ATOMIC_RELAXED);
+    }
+
+    return NULL;
+}
+
+/*
+    One run, returns the number of values not dequeued exactly once
+*/
+static long run_queue (long items, int producers, int consumers, int capacity, int batch,
+                       unsigned long long *ns, unsigned long long *consumer_waits,
+                       unsigned long long *producer_waits) {
+    Run run;
+    Worker *workers;
+    unsigned long long start;
+    long i, bad = 0;
+
+    memset(&run, 0, sizeof(Run));
+    run.batch = batch;
+    run.items = items;
+    run.producers = producers;
+
+    workers = (Worker *)calloc(producers + consumers, sizeof(Worker));
+    run.seen = (unsigned char *)calloc(items, 1);
+
+    if (workers == NULL || run.seen == NULL || bqueue_init(&run.bqueue, capacity, NULL) != 0) {
+        free(workers);
+        free(run.seen);
+        return -1;
+    }
+
+    start = bench_now();
+
+    for (i = 0; i < producers + consumers; i++) {
+        workers[i].run = &run;
+        workers[i].index = (int)(i < producers ? i : i - producers);
+        pthread_create(&workers[i].thread, NULL, i < producers ? producer_main : consumer_main,
+                       &workers[i]);
+    }
+
+    for (i = 0; i < producers; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    bqueue_close(&run.bqueue);
+
+    for (i = producers; i < producers + consumers; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    *ns = bench_now() - start;
+    *consumer_waits = run.bqueue.consumer_waits;
+    *producer_waits = run.bqueue.producer_waits;
+
+    for (i = 0; i < items; i++)
+        bad += run.seen[i] != 1;
+
+    bqueue_destroy(&run.bqueue);
+    free(run.seen);
+    free(workers);
+
+    return bad;
+}
+
+/*
+    A dequeue on an empty queue must give up after its timeout, and an
+    enqueue into a closed queue must fail
+*/
+static int check_semantics (void) {
+    BQueue bqueue;
+    void *data;
+    unsigned long long start, ns;
+    int timeout, closed, drained;
+
+    if (bqueue_init(&bqueue, 1, NULL) != 0)
+        return -1;
+
+    start = bench_now();
+    timeout = bqueue_dequeue(&bqueue, &data, 20) == BQUEUE_TIMEOUT;
+    ns = bench_now() - start;
+
+    bqueue_enqueue(&bqueue, (void *)1, 0);
+    timeout &= bqueue_enqueue(&bqueue, (void *)2, 0) == BQUEUE_TIMEOUT;
+
+    bqueue_close(&bqueue);
+    closed = bqueue_enqueue(&bqueue, (void *)3, -1) == -1;
+    drained = bqueue_dequeue(&bqueue, &data, -1) == 0 && data == (void *)1
+              && bqueue_dequeue(&bqueue, &data, -1) == -1;
+
+    bqueue_destroy(&bqueue);
+
+    printf("Timeout %s (%.1f ms), close %s, drain %s\n", timeout ? "OK" : "FAILED", ns / 1e6,
+           closed ? "OK" : "FAILED", drained ? "OK" : "FAILED");
+
+    return timeout && ns >= 19000000ULL && closed && drained ? 0 : -1;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long items = bench_arg(argc, argv, "items", 1000000);
+    int producers = (int)bench_arg(argc, argv, "producers", 2);
+    int consumers = (int)bench_arg(argc, argv, "consumers", 2);
+    int capacity = (int)bench_arg(argc, argv, "capacity", 1024);
+    int batch = (int)bench_arg(argc, argv, "batch", 64);
+    const char *modes[2] = { "single", "batch" };
+    unsigned long long ns, consumer_waits, producer_waits;
+    long bad;
+    int m, failed = 0;
+
+    if (producers < 1 || consumers < 1 || batch < 1 || batch > 256) {
+        fprintf(stderr, "Need at least one producer and consumer, and -batch between 1 and 256\n");
+        return 1;
+    }
+
+    failed |= check_semantics() != 0;
+
+    printf("+--------+-------+----------+-------------+-------------+-------+\n");
+    printf("| %-6s | %5s | %8s | %11s | %11s | %5s |\n", "MODE", "BATCH", "NS/ITEM", "WAITS/ITEM",
+           "FULL/ITEM", "CHECK");
+    printf("+--------+-------+----------+-------------+-------------+-------+\n");
+
+    for (m = 0; m < 2; m++) {
+        if ((bad = run_queue(items, producers, consumers, capacity, m == 0 ? 1 : batch, &ns,
+                             &consumer_waits, &producer_waits)) < 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        printf("| %-6s | %5d | %8.1f | %11.4f | %11.4f | %5s |\n", modes[m], m == 0 ? 1 : batch,
+               (double)ns / items, (double)consumer_waits / items, (double)producer_waits / items,
+               bad == 0 ? "OK" : "LOST");
+
+        failed |= bad != 0;
+    }
+
+    printf("+--------+-------+----------+-------------+-------------+-------+\n");
+
+    return failed;
+}
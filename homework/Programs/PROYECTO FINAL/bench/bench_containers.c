@@ -0,0 +1,436 @@
+/*
+    bench_containers.c
+    Throughput and latency of the list, dlist, stack and queue operations
+
+    Usage: bench_containers [-min N] [-max N] [-save FILE] [-compare FILE]
+    Sizes go from -min to -max in powers of ten (10 .. 10^6 by default,
+    up to 10^8 with -max 1e8). dlist_rem_head/dlist_rem_tail are
+    dlist_remove at either end. The _copy cases store the value inside
+    the node with list_ins_next_copy, dlist_ins_next_copy and
+    queue_enqueue_copy, one aligned line per node, with the lines freed
+    by the removals reused. The ilist and idlist cases malloc and
+    free one element with its embedded link per operation, the same
+    allocations as a List node holding a plain value, and count them
+    as such under ALLOCS/OP. clist stores the value in its node array,
+    growing it by doubling; it has no allocation counter, so its
+    ALLOCS/OP is n/a
+    Baseline: bench/baselines/containers.txt (ns/op per operation/size)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "dlist.h"
+#include "stack.h"
+#include "queue.h"
+#include "ilist.h"
+#include "clist.h"
+#include "stats.h"
+#include "bench.h"
+
+/* Operations timed together for one latency sample */
+#define BATCH 64
+
+/*
+    Containers under test
+*/
+typedef struct Subject_ {
+    List list;
+    DList dlist;
+    Stack stack;
+    Queue queue;
+    IList ilist;
+    IDList idlist;
+    CList clist;
+} Subject;
+
+/*
+    Element of the intrusive lists
+*/
+typedef struct Element_ {
+    long value;
+    ILink link;
+    IDLink dlink;
+} Element;
+
+/*
+    Kind of a case whose allocations are not counted
+*/
+#define NOT_COUNTED STATS_CONTAINERS
+
+/*
+    A pair of operations measured on one container
+*/
+typedef struct Case_ {
+    const char *insert_name;
+    const char *remove_name;
+    StatsContainer kind;
+
+    void (*init) (Subject *subject);
+    void (*destroy) (Subject *subject);
+    int (*insert) (Subject *subject, long i);
+    int (*remove) (Subject *subject);
+} Case;
+
+static void list_case_init (Subject *subject) { list_init(&subject->list, NULL); }
+static void list_case_destroy (Subject *subject) { list_destroy(&subject->list); }
+
+static int list_case_insert (Subject *subject, long i) {
+    return list_ins_next(&subject->list, list_tail(&subject->list), (void *)i);
+}
+
+static int list_case_remove (Subject *subject) {
+    void *data;
+    return list_rem_next(&subject->list, NULL, &data);
+}
+
+static void dlist_case_init (Subject *subject) { dlist_init(&subject->dlist, NULL); }
+static void dlist_case_destroy (Subject *subject) { dlist_destroy(&subject->dlist); }
+
+static int dlist_case_ins_next (Subject *subject, long i) {
+    return dlist_ins_next(&subject->dlist, dlist_tail(&subject->dlist), (void *)i);
+}
+
+static int dlist_case_ins_prev (Subject *subject, long i) {
+    return dlist_ins_prev(&subject->dlist, dlist_head(&subject->dlist), (void *)i);
+}
+
+static int dlist_case_rem_head (Subject *subject) {
+    void *data;
+    return dlist_remove(&subject->dlist, dlist_head(&subject->dlist), &data);
+}
+
+static int dlist_case_rem_tail (Subject *subject) {
+    void *data;
+    return dlist_remove(&subject->dlist, dlist_tail(&subject->dlist), &data);
+}
+
+static void stack_case_init (Subject *subject) { stack_init(&subject->stack, NULL); }
+static void stack_case_destroy (Subject *subject) { stack_destroy(&subject->stack); }
+
+static int stack_case_push (Subject *subject, long i) {
+    return stack_push(&subject->stack, (void *)i);
+}
+
+static int stack_case_pop (Subject *subject) {
+    void *data;
+    return stack_pop(&subject->stack, &data);
+}
+
+static void queue_case_init (Subject *subject) { queue_init(&subject->queue, NULL); }
+static void queue_case_destroy (Subject *subject) { queue_destroy(&subject->queue); }
+
+static int queue_case_enqueue (Subject *subject, long i) {
+    return queue_enqueue(&subject->queue, (void *)i);
+}
+
+static int queue_case_dequeue (Subject *subject) {
+    void *data;
+    return queue_dequeue(&subject->queue, &data);
+}
+
+static int list_case_ins_copy (Subject *subject, long i) {
+    return list_ins_next_copy(&subject->list, list_tail(&subject->list), &i, sizeof(long));
+}
+
+static int list_case_rem_copy (Subject *subject) {
+    long value;
+    return list_rem_next_copy(&subject->list, NULL, &value, sizeof(long));
+}
+
+static int dlist_case_ins_copy (Subject *subject, long i) {
+    return dlist_ins_next_copy(&subject->dlist, dlist_tail(&subject->dlist), &i, sizeof(long));
+}
+
+static int dlist_case_rem_copy (Subject *subject) {
+    long value;
+    return dlist_remove_copy(&subject->dlist, dlist_head(&subject->dlist), &value, sizeof(long));
+}
+
+static int queue_case_enq_copy (Subject *subject, long i) {
+    return queue_enqueue_copy(&subject->queue, &i, sizeof(long));
+}
+
+static int queue_case_deq_copy (Subject *subject) {
+    long value;
+    return queue_dequeue_copy(&subject->queue, &value, sizeof(long));
+}
+
+/*
+    The elements are counted as the nodes of the list and dlist cases
+*/
+static void ilist_free (ILink *link) {
+    stats_free(STATS_LIST);
+    free(ilist_entry(link, Element, link));
+}
+
+static void idlist_free (IDLink *link) {
+    stats_free(STATS_DLIST);
+    free(ilist_entry(link, Element, dlink));
+}
+
+static void ilist_case_init (Subject *subject) { ilist_init(&subject->ilist, ilist_free); }
+static void ilist_case_destroy (Subject *subject) { ilist_destroy(&subject->ilist); }
+
+static int ilist_case_insert (Subject *subject, long i) {
+    Element *element;
+
+    if ((element = (Element *)malloc(sizeof(Element))) == NULL)
+        return -1;
+
+    stats_alloc(STATS_LIST, sizeof(Element));
+    element->value = i;
+    return ilist_ins_next(&subject->ilist, ilist_tail(&subject->ilist), &element->link);
+}
+
+static int ilist_case_remove (Subject *subject) {
+    ILink *link;
+
+    if (ilist_rem_next(&subject->ilist, NULL, &link) != 0)
+        return -1;
+
+    ilist_free(link);
+    return 0;
+}
+
+static void idlist_case_init (Subject *subject) { idlist_init(&subject->idlist, idlist_free); }
+static void idlist_case_destroy (Subject *subject) { idlist_destroy(&subject->idlist); }
+
+static int idlist_case_ins_next (Subject *subject, long i) {
+    Element *element;
+
+    if ((element = (Element *)malloc(sizeof(Element))) == NULL)
+        return -1;
+
+    stats_alloc(STATS_DLIST, sizeof(Element));
+    element->value = i;
+    return idlist_ins_next(&subject->idlist, idlist_tail(&subject->idlist), &element->dlink);
+}
+
+static int idlist_case_rem_head (Subject *subject) {
+    IDLink *link = idlist_head(&subject->idlist);
+
+    if (idlist_remove(&subject->idlist, link) != 0)
+        return -1;
+
+    idlist_free(link);
+    return 0;
+}
+
+static void clist_case_init (Subject *subject) { clist_init(&subject->clist, sizeof(long), 0); }
+static void clist_case_destroy (Subject *subject) { clist_destroy(&subject->clist); }
+
+static int clist_case_ins_next (Subject *subject, long i) {
+    return clist_ins_next(&subject->clist, clist_tail(&subject->clist), &i, NULL);
+}
+
+static int clist_case_rem_head (Subject *subject) {
+    return clist_remove(&subject->clist, clist_head(&subject->clist), NULL);
+}
+
+static const Case cases[] = {
+    { "list_ins_next", "list_rem_next", STATS_LIST,
+      list_case_init, list_case_destroy, list_case_insert, list_case_remove },
+    { "dlist_ins_next", "dlist_rem_head", STATS_DLIST,
+      dlist_case_init, dlist_case_destroy, dlist_case_ins_next, dlist_case_rem_head },
+    { "dlist_ins_prev", "dlist_rem_tail", STATS_DLIST,
+      dlist_case_init, dlist_case_destroy, dlist_case_ins_prev, dlist_case_rem_tail },
+    { "stack_push", "stack_pop", STATS_STACK,
+      stack_case_init, stack_case_destroy, stack_case_push, stack_case_pop },
+    { "queue_enqueue", "queue_dequeue", STATS_QUEUE,
+      queue_case_init, queue_case_destroy, queue_case_enqueue, queue_case_dequeue },
+    { "list_ins_copy", "list_rem_copy", STATS_LIST,
+      list_case_init, list_case_destroy, list_case_ins_copy, list_case_rem_copy },
+    { "dlist_ins_copy", "dlist_rem_copy", STATS_DLIST,
+      dlist_case_init, dlist_case_destroy, dlist_case_ins_copy, dlist_case_rem_copy },
+    { "queue_enq_copy", "queue_deq_copy", STATS_QUEUE,
+      queue_case_init, queue_case_destroy, queue_case_enq_copy, queue_case_deq_copy },
+    { "ilist_ins_next", "ilist_rem_next", STATS_LIST,
+      ilist_case_init, ilist_case_destroy, ilist_case_insert, ilist_case_remove },
+    { "idlist_ins_next", "idlist_rem_head", STATS_DLIST,
+      idlist_case_init, idlist_case_destroy, idlist_case_ins_next, idlist_case_rem_head },
+    { "clist_ins_next", "clist_rem_head", NOT_COUNTED,
+      clist_case_init, clist_case_destroy, clist_case_ins_next, clist_case_rem_head }
+};
+
+/*
+    Allocation counter of a kind, 0 for NOT_COUNTED
+*/
+static unsigned long long case_allocs (StatsContainer kind) {
+    return kind == NOT_COUNTED ? 0 : stats_counters.allocs[kind];
+}
+
+/*
+    Result of one measured operation at one size
+*/
+typedef struct Result_ {
+    double ns_per_op;
+    double p50;
+    double p99;
+    double allocs_per_op;
+    double misses_per_op;
+    long rss_kb;
+} Result;
+
+static FILE *save_file = NULL;
+static BenchBaseline baseline;
+
+/*
+    Print a result row, compared against the baseline when available
+*/
+static void report (const char *name, long n, const Result *result, int perf) {
+    char key[128];
+    double old;
+
+    printf("| %-15s | %10ld | %8.1f | %8.1f | %8.1f | ", name, n, result->ns_per_op, result->p50,
+           result->p99);
+
+    if (result->allocs_per_op >= 0)
+        printf("%9.2f | ", result->allocs_per_op);
+    else
+        printf("%9s | ", "n/a");
+
+    if (perf)
+        printf("%9.3f | ", result->misses_per_op);
+    else
+        printf("%9s | ", "n/a");
+
+    printf("%9ld | ", result->rss_kb);
+
+    sprintf(key, "%s/%ld", name, n);
+
+    if (bench_baseline_lookup(&baseline, key, &old) == 0 && old > 0)
+        printf("%+7.1f%% |\n", (result->ns_per_op - old) / old * 100.0);
+    else
+        printf("%8s |\n", "-");
+
+    if (save_file != NULL)
+        fprintf(save_file, "%s %.3f\n", key, result->ns_per_op);
+}
+
+/*
+    Measure one case at size n
+*/
+static int run_case (const Case *test, long n, int perf_fd) {
+    Subject subject;
+    BenchSamples samples;
+    Result result;
+    unsigned long long start, batch_start, allocs;
+    long i;
+    long batch = n >= BATCH * 8 ? BATCH : 1;
+
+    if (bench_samples_init(&samples, (int)(n / batch) + 1) != 0)
+        return -1;
+
+    test->init(&subject);
+
+    /* Insertion */
+    allocs = case_allocs(test->kind);
+    bench_perf_start(perf_fd);
+    start = batch_start = bench_now();
+
+    for (i = 0; i < n; i++) {
+        if (test->insert(&subject, i) != 0) {
+            fprintf(stderr, "%s failed at %ld\n", test->insert_name, i);
+            break;
+        }
+
+        if ((i + 1) % batch == 0) {
+            unsigned long long now = bench_now();
+            bench_samples_add(&samples, now - batch_start);
+            batch_start = now;
+        }
+    }
+
+    result.ns_per_op = (double)(bench_now() - start) / n;
+    result.misses_per_op = (double)bench_perf_stop(perf_fd) / n;
+    result.allocs_per_op = test->kind == NOT_COUNTED ? -1 : (double)(case_allocs(test->kind) - allocs) / n;
+    result.rss_kb = bench_rss_kb();
+    result.p50 = bench_percentile(&samples, 50.0) / batch;
+    result.p99 = bench_percentile(&samples, 99.0) / batch;
+
+    report(test->insert_name, n, &result, perf_fd >= 0);
+
+    /* Removal */
+    samples.size = 0;
+    allocs = case_allocs(test->kind);
+    bench_perf_start(perf_fd);
+    start = batch_start = bench_now();
+
+    for (i = 0; i < n; i++) {
+        if (test->remove(&subject) != 0) {
+            fprintf(stderr, "%s failed at %ld\n", test->remove_name, i);
+            break;
+        }
+
+        if ((i + 1) % batch == 0) {
+            unsigned long long now = bench_now();
+            bench_samples_add(&samples, now - batch_start);
+            batch_start = now;
+        }
+    }
+
+    result.ns_per_op = (double)(bench_now() - start) / n;
+    result.misses_per_op = (double)bench_perf_stop(perf_fd) / n;
+    result.allocs_per_op = test->kind == NOT_COUNTED ? -1 : (double)(case_allocs(test->kind) - allocs) / n;
+    result.rss_kb = bench_rss_kb();
+    result.p50 = bench_percentile(&samples, 50.0) / batch;
+    result.p99 = bench_percentile(&samples, 99.0) / batch;
+
+    report(test->remove_name, n, &result, perf_fd >= 0);
+
+    test->destroy(&subject);
+    bench_samples_destroy(&samples);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long min = bench_arg(argc, argv, "min", 10);
+    long max = bench_arg(argc, argv, "max", 1000000);
+    const char *save_path = bench_arg_str(argc, argv, "save");
+    const char *compare_path = bench_arg_str(argc, argv, "compare");
+    int perf_fd;
+    unsigned int c;
+    long n;
+
+    stats_init();
+
+    if (compare_path != NULL && bench_baseline_load(&baseline, compare_path) != 0)
+        fprintf(stderr, "Baseline '%s' not found, running without comparison\n", compare_path);
+
+    if (save_path != NULL && (save_file = fopen(save_path, "w")) == NULL) {
+        fprintf(stderr, "Could not create '%s'\n", save_path);
+        return 1;
+    }
+
+    if ((perf_fd = bench_perf_open()) < 0)
+        fprintf(stderr, "perf_event_open not available, cache misses are not reported\n");
+
+    printf("+-----------------+------------+----------+----------+----------+-----------+-----------+-----------+----------+\n");
+    printf("| %-15s | %10s | %8s | %8s | %8s | %9s | %9s | %9s | %8s |\n", "OPERATION", "ELEMENTS",
+           "NS/OP", "P50", "P99", "ALLOCS/OP", "MISSES/OP", "RSS KB", "VS BASE");
+    printf("+-----------------+------------+----------+----------+----------+-----------+-----------+-----------+----------+\n");
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (n = min; n <= max; n *= 10) {
+            if (run_case(&cases[c], n, perf_fd) != 0) {
+                fprintf(stderr, "Out of memory at %ld elements\n", n);
+                break;
+            }
+        }
+        printf("+-----------------+------------+----------+----------+----------+-----------+-----------+-----------+----------+\n");
+    }
+
+    bench_perf_close(perf_fd);
+    bench_baseline_destroy(&baseline);
+
+    if (save_file != NULL)
+        fclose(save_file);
+
+    return 0;
+}
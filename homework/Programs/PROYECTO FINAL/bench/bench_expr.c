@@ -0,0 +1,233 @@
+/*
+    bench_expr.c
+    End-to-end benchmark of the five engines on generated expressions
+
+    Usage: bench_expr [-bin DIR] [-count N] [-min SIZE] [-max SIZE] [-seed N]
+                      [-ops MIX] [-depth N] [-digits N] [-chain PERCENT]
+                      [-engine NAME]
+
+    MIX is the operator mix, one character per operator, repeated to
+    weight it (default: + - * / ^).
+
+    Every engine runs with --headless on a file of generated expressions
+    (POSIX shell needed), with CALC_STATS=json to get the time of each
+    stage. Sizes double from -min to -max; the engines read at most
+    255 characters per line, so -max is capped at 128.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "bench.h"
+#include "exprgen.h"
+
+#define INPUT_FILE "bench_expr.in"
+#define STATS_FILE "bench_expr.json"
+#define MAX_SIZE 128
+
+/*
+    Engines driven by the benchmark
+*/
+typedef struct Engine_ {
+    const char *name;
+    int letters;
+} Engine;
+
+static const Engine engines[] = {
+    { "Infix", 0 },
+    { "PRE-NUM", 0 },
+    { "POST-NUM", 0 },
+    { "PRE-LETTERS", 1 },
+    { "POSTFIX-LETTERS", 1 }
+};
+
+/*
+    Stages reported, in the order of the engines' phases
+*/
+static const StatsPhase stages[] = {
+    STATS_VALIDATE, STATS_TOKENIZE, STATS_CONVERT, STATS_EVALUATE, STATS_RENDER
+};
+
+#define STAGES ((int)(sizeof(stages) / sizeof(stages[0])))
+
+/*
+    Read the nanoseconds of every stage from the engine's JSON dump
+*/
+static int read_stage_ns (unsigned long long *ns) {
+    FILE *file;
+    char text[4096];
+    char key[64];
+    const char *found;
+    size_t size;
+    unsigned long long calls;
+    int i;
+
+    if ((file = fopen(STATS_FILE, "r")) == NULL)
+        return -1;
+
+    size = fread(text, 1, sizeof(text) - 1, file);
+    text[size] = '\0';
+    fclose(file);
+
+    for (i = 0; i < STAGES; i++) {
+        sprintf(key, "\"%s\":", stats_phase_name(stages[i]));
+        ns[i] = 0;
+
+        if ((found = strstr(text, key)) != NULL)
+            sscanf(found + strlen(key), " {\"calls\": %llu, \"ns\": %llu}", &calls, &ns[i]);
+    }
+
+    return 0;
+}
+
+/*
+    Run an engine on the input file, returns the wall time in ns
+*/
+static long long run_engine (const char *bin, const Engine *engine) {
+    char command[1024];
+    unsigned long long start;
+
+    sprintf(command, "CALC_STATS=json CALC_STATS_FILE=%s \"%s/%s\" --headless < %s > /dev/null",
+            STATS_FILE, bin, engine->name, INPUT_FILE);
+
+    start = bench_now();
+
+    if (system(command) != 0)
+        return -1;
+
+    return (long long)(bench_now() - start);
+}
+
+/*
+    Write count generated expressions, returns the total bytes
+*/
+static long write_input (ExprGen *gen, int count) {
+    FILE *file;
+    char expr[MAX_SIZE * 2];
+    long bytes = 0;
+    int i, length;
+
+    if ((file = fopen(INPUT_FILE, "w")) == NULL)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        length = exprgen_generate(gen, expr, sizeof(expr));
+        fprintf(file, "%s\n", expr);
+        bytes += length;
+    }
+
+    fclose(file);
+
+    return bytes;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    const char *bin = bench_arg_str(argc, argv, "bin");
+    const char *only = bench_arg_str(argc, argv, "engine");
+    const char *ops = bench_arg_str(argc, argv, "ops");
+    int count = (int)bench_arg(argc, argv, "count", 500);
+    int min = (int)bench_arg(argc, argv, "min", 8);
+    int max = (int)bench_arg(argc, argv, "max", MAX_SIZE);
+    unsigned long long seed = (unsigned long long)bench_arg(argc, argv, "seed", 1);
+    unsigned long long ns[STAGES];
+    unsigned int e;
+    int size, i;
+
+    if (bin == NULL)
+        bin = "bin";
+
+    if (max > MAX_SIZE)
+        max = MAX_SIZE;
+
+    printf("+-----------------+-------+----------+-----------+");
+    for (i = 0; i < STAGES; i++) printf("------------+");
+    printf("----------+\n");
+    printf("| %-15s | %5s | %8s | %9s |", "ENGINE", "SIZE", "NS/BYTE", "EXPR/S");
+    for (i = 0; i < STAGES; i++) printf(" %10.10s |", stats_phase_name(stages[i]));
+    printf(" %8s |\n", "SCALING");
+    printf("| %-15s | %5s | %8s | %9s |", "", "", "", "");
+    for (i = 0; i < STAGES; i++) printf(" %10s |", "MB/s");
+    printf(" %8s |\n", "");
+    printf("+-----------------+-------+----------+-----------+");
+    for (i = 0; i < STAGES; i++) printf("------------+");
+    printf("----------+\n");
+
+    for (e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        const Engine *engine = &engines[e];
+        long long startup, wall;
+        double previous = 0.0;
+        FILE *empty;
+
+        if (only != NULL && strcmp(only, engine->name) != 0)
+            continue;
+
+        // Process start cost, subtracted from every run
+        if ((empty = fopen(INPUT_FILE, "w")) == NULL) {
+            fprintf(stderr, "Could not write %s\n", INPUT_FILE);
+            continue;
+        }
+        fclose(empty);
+
+        if ((startup = run_engine(bin, engine)) < 0) {
+            fprintf(stderr, "Could not run %s/%s --headless\n", bin, engine->name);
+            continue;
+        }
+
+        for (size = min; size <= max; size *= 2) {
+            ExprGen gen;
+            long bytes;
+            double per_byte;
+
+            exprgen_init(&gen, size, engine->letters, seed);
+
+            if (ops != NULL) gen.operators = ops;
+            gen.max_depth = (int)bench_arg(argc, argv, "depth", gen.max_depth);
+            gen.max_digits = (int)bench_arg(argc, argv, "digits", gen.max_digits);
+            gen.chain_percent = (int)bench_arg(argc, argv, "chain", gen.chain_percent);
+
+            if ((bytes = write_input(&gen, count)) <= 0)
+                break;
+
+            if ((wall = run_engine(bin, engine)) < 0 || read_stage_ns(ns) != 0) {
+                fprintf(stderr, "%s failed at size %d\n", engine->name, size);
+                break;
+            }
+
+            wall = wall > startup ? wall - startup : 1;
+            per_byte = (double)wall / bytes;
+
+            printf("| %-15s | %5ld | %8.1f | %9.0f |", engine->name, bytes / count, per_byte,
+                   count / (wall / 1e9));
+
+            for (i = 0; i < STAGES; i++) {
+                if (ns[i] == 0)
+                    printf(" %10s |", "-");
+                else
+                    printf(" %10.2f |", bytes * 1e3 / ns[i]);
+            }
+
+            // Cost per byte should stay flat as the size doubles
+            if (previous > 0.0 && per_byte > previous * 1.5)
+                printf(" %8s |\n", "SUPERLIN");
+            else if (previous > 0.0)
+                printf(" %7.2fx |\n", per_byte / previous);
+            else
+                printf(" %8s |\n", "-");
+
+            previous = per_byte;
+        }
+    }
+
+    printf("+-----------------+-------+----------+-----------+");
+    for (i = 0; i < STAGES; i++) printf("------------+");
+    printf("----------+\n");
+
+    remove(INPUT_FILE);
+    remove(STATS_FILE);
+
+    return 0;
+}
@@ -0,0 +1,604 @@
+/*
+    bench_fuzz.c
+    Performance fuzzer: looks for inputs whose cost grows faster than
+    their length
+
+    Usage: bench_fuzz [-bin DIR] [-engine NAME] [-iterations N] [-size N]
+                      [-seed N] [-threshold RATIO] [-corpus DIR] [-replay 1]
+
+    The cost of an input is the engine's own work counters (steps, list
+    and dlist nodes allocated, characters rescanned), read from
+    CALC_STATS=json. They are deterministic, unlike the wall time of a
+    short process. The growth of an input e is the cost per byte of
+    (e)+(e) against the cost per byte of e: about 1.0 for linear work,
+    closer to 2.0 for quadratic work. Inputs are mutated to maximize
+    growth, then cost per byte. Inputs growing more than -threshold
+    (1.3 by default) are minimized and appended to DIR/ENGINE.txt, one
+    per line (bench/corpus by default), unless an input of the same
+    shape, the same but for its operands, is there. -replay 1 runs the saved corpus
+    instead and reports both numbers, as a regression benchmark.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "bench.h"
+#include "exprgen.h"
+
+#define INPUT_FILE "bench_fuzz.in"
+#define STATS_FILE "bench_fuzz.json"
+
+/*
+    Engines read at most 255 characters and their spaced output is about
+    twice the input, so (e)+(e) must stay under 128
+*/
+#define MAX_INPUT 60
+#define POPULATION 16
+
+/* Smaller inputs are dominated by the fixed cost of an expression */
+#define MIN_OPERATORS 4
+
+/*
+    Engines fuzzed
+*/
+typedef struct Engine_ {
+    const char *name;
+    int letters;
+} Engine;
+
+static const Engine engines[] = {
+    { "Infix", 0 },
+    { "PRE-NUM", 0 },
+    { "POST-NUM", 0 },
+    { "PRE-LETTERS", 1 },
+    { "POSTFIX-LETTERS", 1 }
+};
+
+/*
+    An input and its measurements
+*/
+typedef struct Input_ {
+    char expr[MAX_INPUT + 1];
+    int length;
+    double cost;
+    double per_byte;
+    double growth;
+} Input;
+
+static const char *bin = "bin";
+static const char *operators = "+-*/^";
+static ExprGen gen;
+static int runs = 0;
+static int crashes = 0;
+
+/*
+    Find an unsigned counter after key in the JSON text
+*/
+static unsigned long long json_counter (const char *text, const char *key) {
+    const char *found = strstr(text, key);
+    unsigned long long value = 0;
+
+    if (found != NULL)
+        sscanf(found + strlen(key), " %llu", &value);
+
+    return value;
+}
+
+/*
+    Cost of one expression, -1 when the engine rejects it or fails
+*/
+static double measure (const Engine *engine, const char *expr) {
+    FILE *file;
+    char command[1024];
+    char text[4096];
+    size_t size;
+    unsigned long long steps;
+    int status;
+
+    if ((file = fopen(INPUT_FILE, "w")) == NULL)
+        return -1;
+
+    fprintf(file, "%s\n", expr);
+    fclose(file);
+
+    sprintf(command, "CALC_STATS=json CALC_STATS_FILE=%s \"%s/%s\" --headless < %s > /dev/null",
+            STATS_FILE, bin, engine->name, INPUT_FILE);
+
+    runs++;
+    remove(STATS_FILE);
+
+    // The shell reports a fatal signal as 128 + signal
+    if ((status = system(command)) != 0) {
+        if (status == -1 || (status >> 8) >= 128)
+            crashes++;
+        return -1;
+    }
+
+    if ((file = fopen(STATS_FILE, "r")) == NULL)
+        return -1;
+
+    size = fread(text, 1, sizeof(text) - 1, file);
+    text[size] = '\0';
+    fclose(file);
+
+    // No steps: the expression did not pass validate_syntax
+    if ((steps = json_counter(text, "\"steps\":")) == 0)
+        return -1;
+
+    // Stack and queue nodes are list nodes, list + dlist counts them once
+    return (double)(steps + json_counter(text, "\"list\": {\"allocs\":") +
+                    json_counter(text, "\"dlist\": {\"allocs\":") + json_counter(text, "\"scanned\":"));
+}
+
+/*
+    Measure an input and its growth, returns -1 when it is not valid
+*/
+static int evaluate (const Engine *engine, Input *input) {
+    char doubled[2 * MAX_INPUT + 8];
+    double cost;
+    int i, operators_found = 0;
+
+    input->length = (int)strlen(input->expr);
+
+    for (i = 0; i < input->length; i++)
+        operators_found += strchr(operators, input->expr[i]) != NULL;
+
+    if (operators_found < MIN_OPERATORS || (input->cost = measure(engine, input->expr)) <= 0)
+        return -1;
+
+    input->per_byte = input->cost / input->length;
+
+    sprintf(doubled, "(%s)+(%s)", input->expr, input->expr);
+
+    if ((cost = measure(engine, doubled)) <= 0)
+        return -1;
+
+    input->growth = cost / strlen(doubled) / input->per_byte;
+
+    return 0;
+}
+
+/*
+    Fitness order: growth first, then cost per byte
+*/
+static int better (const Input *a, const Input *b) {
+    if (a->growth != b->growth)
+        return a->growth > b->growth;
+
+    return a->per_byte > b->per_byte;
+}
+
+/*
+    Operand boundaries: index-th run of letters or digits
+    Returns the number of operands when index is out of range
+*/
+static int find_operand (const char *expr, int index, int *start, int *end) {
+    int count = 0, i = 0;
+
+    while (expr[i] != '\0') {
+        if (isalnum((unsigned char)expr[i])) {
+            int first = i;
+
+            while (isalnum((unsigned char)expr[i]))
+                i++;
+
+            if (count++ == index) {
+                *start = first;
+                *end = i;
+                return -1;
+            }
+        } else {
+            i++;
+        }
+    }
+
+    return count;
+}
+
+/*
+    Parentheses: index-th '(' and the ')' closing it
+    Returns the number of '(' when index is out of range or unmatched
+*/
+static int find_paren (const char *expr, int index, int *open, int *close) {
+    int count = 0, depth, i, j;
+
+    for (i = 0; expr[i] != '\0'; i++) {
+        if (expr[i] != '(' || count++ != index)
+            continue;
+
+        for (depth = 0, j = i; expr[j] != '\0'; j++) {
+            depth += expr[j] == '(' ? 1 : expr[j] == ')' ? -1 : 0;
+
+            if (depth == 0) {
+                *open = i;
+                *close = j;
+                return -1;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*
+    Shape of an input: every operand becomes x, so inputs that only
+    differ in their values have the same shape
+*/
+static void shape (const char *expr, char *out) {
+    while (*expr != '\0') {
+        if (isalnum((unsigned char)*expr)) {
+            while (isalnum((unsigned char)*expr))
+                expr++;
+            *out++ = 'x';
+        } else {
+            *out++ = *expr++;
+        }
+    }
+
+    *out = '\0';
+}
+
+static void random_operand (const Engine *engine, char *out) {
+    int digits, i;
+
+    if (engine->letters) {
+        out[0] = (char)('a' + exprgen_random(&gen, 26));
+        out[1] = '\0';
+        return;
+    }
+
+    digits = 1 + (int)exprgen_random(&gen, 3);
+
+    for (i = 0; i < digits; i++)
+        out[i] = (char)((i == 0 ? '1' : '0') + exprgen_random(&gen, i == 0 ? 9 : 10));
+
+    out[digits] = '\0';
+}
+
+/*
+    Replace text[start, end) by insert, fails when the result is too long
+*/
+static int splice (char *text, int start, int end, const char *insert) {
+    char result[2 * MAX_INPUT + 8];
+    int length = (int)strlen(text);
+    int size = (int)strlen(insert);
+
+    if (length - (end - start) + size > MAX_INPUT)
+        return -1;
+
+    memcpy(result, text, start);
+    memcpy(result + start, insert, size);
+    strcpy(result + start + size, text + end);
+    strcpy(text, result);
+
+    return 0;
+}
+
+/*
+    Apply one random structural mutation, the result may be invalid
+*/
+static int mutate (const Engine *engine, char *expr, const Input *population, int size) {
+    char piece[2 * MAX_INPUT + 8];
+    char value[8];
+    int operands = find_operand(expr, -1, NULL, NULL);
+    int a, b, start, end, start2, end2;
+
+    if (operands == 0)
+        return -1;
+
+    a = (int)exprgen_random(&gen, operands);
+    find_operand(expr, a, &start, &end);
+
+    switch (exprgen_random(&gen, 7)) {
+    case 0:
+        // Change the operator before an operand
+        if (start == 0 || strchr(operators, expr[start - 1]) == NULL)
+            return -1;
+        expr[start - 1] = operators[exprgen_random(&gen, (unsigned int)strlen(operators))];
+        return 0;
+
+    case 1:
+        // Change an operand
+        random_operand(engine, value);
+        return splice(expr, start, end, value);
+
+    case 2:
+        // Append an operator and an operand
+        random_operand(engine, value);
+        sprintf(piece, "%c%s", operators[exprgen_random(&gen, (unsigned int)strlen(operators))], value);
+        return splice(expr, end, end, piece);
+
+    case 3:
+        // Parenthesize a run of operands
+        b = a + (int)exprgen_random(&gen, operands - a);
+        find_operand(expr, b, &start2, &end2);
+        if (b == a)
+            return -1;
+        if (splice(expr, end2, end2, ")") != 0)
+            return -1;
+        return splice(expr, start, start, "(");
+
+    case 4:
+        // Remove an operand and the operator before it
+        if (start == 0 || strchr(operators, expr[start - 1]) == NULL)
+            return -1;
+        return splice(expr, start - 1, end, "");
+
+    case 5:
+        // Replace an operand by another input
+        b = (int)exprgen_random(&gen, size);
+        sprintf(piece, "(%s)", population[b].expr);
+        return splice(expr, start, end, piece);
+
+    default:
+        // Remove a pair of parentheses
+        if ((start = (int)(strchr(expr, '(') ? strchr(expr, '(') - expr : -1)) < 0)
+            return -1;
+        for (end = (int)strlen(expr) - 1; end > start && expr[end] != ')'; end--)
+            ;
+        if (end == start)
+            return -1;
+        splice(expr, end, end + 1, "");
+        return splice(expr, start, start + 1, "");
+    }
+}
+
+/*
+    Shrink an input while it keeps growing faster than threshold
+*/
+static void minimize (const Engine *engine, Input *input, double threshold) {
+    Input candidate;
+    int start, end, changed = 1;
+    int i;
+
+    while (changed) {
+        changed = 0;
+
+        for (i = 0; find_operand(input->expr, i, &start, &end) < 0; i++) {
+            candidate = *input;
+
+            // Drop "op operand" pairs first
+            if (start > 0 && strchr(operators, candidate.expr[start - 1]) != NULL)
+                splice(candidate.expr, start - 1, end, "");
+            else if (end < input->length && strchr(operators, candidate.expr[end]) != NULL)
+                splice(candidate.expr, start, end + 1, "");
+            else
+                continue;
+
+            if (evaluate(engine, &candidate) == 0 && candidate.growth >= threshold) {
+                *input = candidate;
+                changed = 1;
+                break;
+            }
+        }
+
+        // then whole parentheses, such as the ones around one operand
+        for (i = 0; !changed && find_paren(input->expr, i, &start, &end) < 0; i++) {
+            candidate = *input;
+            splice(candidate.expr, end, end + 1, "");
+            splice(candidate.expr, start, start + 1, "");
+
+            if (evaluate(engine, &candidate) == 0 && candidate.growth >= threshold) {
+                *input = candidate;
+                changed = 1;
+            }
+        }
+    }
+}
+
+/*
+    Append an input to the corpus file unless one of the same shape is
+    already there
+*/
+static void save (const char *corpus, const Engine *engine, const Input *input) {
+    FILE *file;
+    char path[512];
+    char line[512];
+    char wanted[MAX_INPUT + 1], found[512];
+
+    sprintf(path, "%s/%s.txt", corpus, engine->name);
+    shape(input->expr, wanted);
+
+    if ((file = fopen(path, "r")) != NULL) {
+        while (fgets(line, sizeof(line), file) != NULL) {
+            line[strcspn(line, "\n")] = '\0';
+            shape(line, found);
+
+            if (strcmp(found, wanted) == 0) {
+                fclose(file);
+                return;
+            }
+        }
+
+        fclose(file);
+    }
+
+    if ((file = fopen(path, "a")) == NULL) {
+        fprintf(stderr, "Could not write '%s'\n", path);
+        return;
+    }
+
+    fprintf(file, "%s\n", input->expr);
+    fclose(file);
+}
+
+/*
+    Index of an expression in a set of inputs, -1 when absent
+*/
+static int find_input (const Input *inputs, int count, const char *expr) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (strcmp(inputs[i].expr, expr) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+    Index of an input of the same shape as expr, -1 when absent
+*/
+static int find_shape (const Input *inputs, int count, const char *expr) {
+    char wanted[MAX_INPUT + 1], found[MAX_INPUT + 1];
+    int i;
+
+    shape(expr, wanted);
+
+    for (i = 0; i < count; i++) {
+        shape(inputs[i].expr, found);
+
+        if (strcmp(found, wanted) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static int compare_inputs (const void *a, const void *b) {
+    return better((const Input *)b, (const Input *)a) - better((const Input *)a, (const Input *)b);
+}
+
+/*
+    Fuzz one engine
+*/
+static void fuzz (const Engine *engine, int iterations, int size, double threshold, const char *corpus) {
+    Input population[POPULATION];
+    Input reported[4];
+    Input child;
+    int count = 0, found = 0;
+    int i, tries;
+
+    // Seed with generated expressions
+    for (tries = 0; count < POPULATION && tries < POPULATION * 4; tries++) {
+        exprgen_init(&gen, size, engine->letters, gen.seed);
+        exprgen_generate(&gen, population[count].expr, MAX_INPUT + 1);
+
+        if (evaluate(engine, &population[count]) == 0)
+            count++;
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "%s rejected every seed input\n", engine->name);
+        return;
+    }
+
+    for (i = 0; i < iterations; i++) {
+        // Parent from a tournament of two
+        int a = (int)exprgen_random(&gen, count);
+        int b = (int)exprgen_random(&gen, count);
+
+        child = population[better(&population[a], &population[b]) ? a : b];
+
+        if (mutate(engine, child.expr, population, count) != 0 ||
+            find_input(population, count, child.expr) >= 0 || evaluate(engine, &child) != 0)
+            continue;
+
+        qsort(population, count, sizeof(Input), compare_inputs);
+
+        if (count < POPULATION)
+            population[count++] = child;
+        else if (better(&child, &population[count - 1]))
+            population[count - 1] = child;
+    }
+
+    qsort(population, count, sizeof(Input), compare_inputs);
+
+    for (i = 0; i < count && i < 4; i++) {
+        Input best = population[i];
+
+        if (best.growth < threshold)
+            continue;
+
+        minimize(engine, &best, threshold);
+
+        if (find_shape(reported, found, best.expr) >= 0)
+            continue;
+
+        reported[found++] = best;
+
+        printf("| %-15s | %-60.60s | %9.1f | %7.2fx |\n", engine->name, best.expr, best.per_byte,
+               best.growth);
+        save(corpus, engine, &best);
+    }
+
+    if (found == 0)
+        printf("| %-15s | %-60s | %9.1f | %7.2fx |\n", engine->name, "(nothing super-linear)",
+               population[0].per_byte, population[0].growth);
+}
+
+/*
+    Measure every saved input of one engine
+*/
+static void replay (const Engine *engine, const char *corpus) {
+    FILE *file;
+    char path[512];
+    Input input;
+
+    sprintf(path, "%s/%s.txt", corpus, engine->name);
+
+    if ((file = fopen(path, "r")) == NULL)
+        return;
+
+    while (fgets(input.expr, sizeof(input.expr), file) != NULL) {
+        input.expr[strcspn(input.expr, "\n")] = '\0';
+
+        if (evaluate(engine, &input) != 0) {
+            printf("| %-15s | %-60.60s | %9s | %8s |\n", engine->name, input.expr, "rejected", "-");
+            continue;
+        }
+
+        printf("| %-15s | %-60.60s | %9.1f | %7.2fx |\n", engine->name, input.expr, input.per_byte,
+               input.growth);
+    }
+
+    fclose(file);
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    const char *only = bench_arg_str(argc, argv, "engine");
+    const char *corpus = bench_arg_str(argc, argv, "corpus");
+    int iterations = (int)bench_arg(argc, argv, "iterations", 300);
+    int size = (int)bench_arg(argc, argv, "size", 24);
+    int replaying = (int)bench_arg(argc, argv, "replay", 0);
+    const char *limit = bench_arg_str(argc, argv, "threshold");
+    double threshold = limit != NULL ? atof(limit) : 1.3;
+    unsigned int e;
+
+    if (bench_arg_str(argc, argv, "bin") != NULL)
+        bin = bench_arg_str(argc, argv, "bin");
+
+    if (corpus == NULL)
+        corpus = "bench/corpus";
+
+    if (size > MAX_INPUT / 2)
+        size = MAX_INPUT / 2;
+
+    exprgen_init(&gen, size, 0, (unsigned long long)bench_arg(argc, argv, "seed", 1));
+
+    printf("+-----------------+--------------------------------------------------------------+-----------+----------+\n");
+    printf("| %-15s | %-60s | %9s | %8s |\n", "ENGINE", "INPUT", "COST/BYTE", "GROWTH");
+    printf("+-----------------+--------------------------------------------------------------+-----------+----------+\n");
+
+    for (e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        if (only != NULL && strcmp(only, engines[e].name) != 0)
+            continue;
+
+        if (replaying)
+            replay(&engines[e], corpus);
+        else
+            fuzz(&engines[e], iterations, size, threshold, corpus);
+    }
+
+    printf("+-----------------+--------------------------------------------------------------+-----------+----------+\n");
+    printf("  %d engine runs, %d crashes\n", runs, crashes);
+
+    remove(INPUT_FILE);
+    remove(STATS_FILE);
+
+    return 0;
+}
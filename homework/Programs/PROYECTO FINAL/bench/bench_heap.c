@@ -0,0 +1,247 @@
+/*
+    bench_heap.c
+    d-ary heap throughput by arity, and a scheduler where interactive
+    jobs should jump ahead of bulk work: FIFO Queue against PQueue
+
+    Usage: bench_heap [-n N] [-updates U] [-jobs J] [-backlog B] [-seed S]
+    insert   N random keys inserted one by one, then all extracted
+    build    the same keys added with heap_build, then all extracted
+    update   U random keys changed in a built heap through their handles,
+             half raised and half lowered, then all extracted
+    CHECK is 1 when every extraction came out in order
+    schedule B bulk jobs queued, then J steps of one job arriving (one
+             in 20 interactive) and one job served; the wait of an
+             interactive job is the number of jobs served before it
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "heap.h"
+#include "pqueue.h"
+#include "queue.h"
+#include "bench.h"
+
+/*
+    A job: interactive ones go first, then by arrival
+*/
+typedef struct Job_ {
+    long arrival;
+    int interactive;
+} Job;
+
+/*
+    Smallest key on top
+*/
+static int compare_keys (const void *key1, const void *key2) {
+    long a = *(const long *)key1, b = *(const long *)key2;
+
+    return a < b ? 1 : a > b ? -1 : 0;
+}
+
+static int compare_jobs (const void *key1, const void *key2) {
+    const Job *a = (const Job *)key1, *b = (const Job *)key2;
+
+    if (a->interactive != b->interactive)
+        return a->interactive - b->interactive;
+
+    return a->arrival < b->arrival ? 1 : a->arrival > b->arrival ? -1 : 0;
+}
+
+static void report (const char *operation, int arity, long ops, unsigned long long ns, int ok) {
+    printf("| %-8s | %5d | %10ld | %8.1f | %5s |\n", operation, arity, ops, (double)ns / ops, ok ? "1" : "0");
+}
+
+/*
+    Extract everything, 1 when it came out in order
+*/
+static int drain (Heap *heap) {
+    void *data;
+    long last = LONG_MIN;
+    int ok = 1;
+
+    while (heap_extract(heap, &data) == 0) {
+        if (*(long *)data < last)
+            ok = 0;
+        last = *(long *)data;
+    }
+
+    return ok;
+}
+
+static int run_arity (int arity, long n, long updates, unsigned long long start_seed) {
+    Heap heap;
+    long *keys, i;
+    void **data;
+    int *handles, ok, k;
+    unsigned long long start, ns;
+
+    keys = (long *)malloc(n * sizeof(long));
+    data = (void **)malloc(n * sizeof(void *));
+    handles = (int *)malloc(n * sizeof(int));
+
+    if (keys == NULL || data == NULL || handles == NULL) {
+        free(keys);
+        free(data);
+        free(handles);
+        return -1;
+    }
+
+    bench_seed(start_seed);
+
+    for (i = 0; i < n; i++) {
+        keys[i] = (long)(bench_random() % 1000000000);
+        data[i] = &keys[i];
+    }
+
+    heap_init(&heap, arity, compare_keys, NULL);
+    start = bench_now();
+
+    for (i = 0; i < n; i++)
+        heap_insert(&heap, data[i], NULL);
+
+    ok = drain(&heap);
+    ns = bench_now() - start;
+    report("insert", arity, n, ns, ok);
+
+    start = bench_now();
+    heap_build(&heap, data, (int)n, NULL);
+    ok = drain(&heap);
+    ns = bench_now() - start;
+    report("build", arity, n, ns, ok);
+
+    heap_build(&heap, data, (int)n, handles);
+    start = bench_now();
+
+    for (i = 0; i < updates; i++) {
+        k = (int)(bench_random() % n);
+
+        if (i & 1)
+            keys[k] -= (long)(bench_random() % 1000000);
+        else
+            keys[k] += (long)(bench_random() % 1000000);
+
+        heap_update(&heap, handles[k]);
+    }
+
+    ns = bench_now() - start;
+    ok = drain(&heap);
+    report("update", arity, updates, ns, ok);
+
+    heap_destroy(&heap);
+    free(keys);
+    free(data);
+    free(handles);
+
+    return 0;
+}
+
+/*
+    schedule: the same arrivals for both queues
+*/
+static int run_schedule (long jobs, long backlog, unsigned long long start_seed) {
+    Job *all, *job;
+    Queue queue;
+    PQueue pqueue;
+    BenchSamples waits[2];
+    long i, served, created;
+    int kind;
+
+    if ((all = (Job *)malloc((jobs + backlog) * sizeof(Job))) == NULL)
+        return -1;
+
+    bench_seed(start_seed);
+
+    for (i = 0; i < jobs + backlog; i++) {
+        all[i].arrival = i;
+        all[i].interactive = i >= backlog && bench_random() % 20 == 0;
+    }
+
+    for (kind = 0; kind < 2; kind++) {
+        if (bench_samples_init(&waits[kind], (int)(jobs / 10 + 16)) != 0)
+            return -1;
+
+        queue_init(&queue, NULL);
+        pqueue_init(&pqueue, 4, compare_jobs, NULL);
+        served = 0;
+
+        for (created = 0; created < backlog; created++) {
+            if (kind == 0)
+                queue_enqueue(&queue, &all[created]);
+            else
+                pqueue_insert(&pqueue, &all[created], NULL);
+        }
+
+        for (i = 0; i < jobs; i++, created++) {
+            if (kind == 0) {
+                queue_enqueue(&queue, &all[created]);
+                queue_dequeue(&queue, (void **)&job);
+            } else {
+                pqueue_insert(&pqueue, &all[created], NULL);
+                pqueue_extract(&pqueue, (void **)&job);
+            }
+
+            // Jobs served since it arrived, at step arrival - backlog
+            if (job->interactive)
+                bench_samples_add(&waits[kind], (unsigned long long)(served - (job->arrival - backlog)));
+
+            served++;
+        }
+
+        queue_destroy(&queue);
+        pqueue_destroy(&pqueue);
+    }
+
+    printf("+----------+------------+--------------+--------------+--------------+\n");
+    printf("| %-8s | %-10s | %12s | %12s | %12s |\n", "SCHEDULE", "QUEUE", "INTERACTIVE", "WAIT P50", "WAIT P99");
+    printf("+----------+------------+--------------+--------------+--------------+\n");
+
+    for (kind = 0; kind < 2; kind++) {
+        printf("| %-8s | %-10s | %12d | %12.0f | %12.0f |\n", "jobs", kind == 0 ? "Queue" : "PQueue",
+               waits[kind].size, bench_percentile(&waits[kind], 50), bench_percentile(&waits[kind], 99));
+        bench_samples_destroy(&waits[kind]);
+    }
+
+    printf("+----------+------------+--------------+--------------+--------------+\n");
+    free(all);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 1000000);
+    long updates = bench_arg(argc, argv, "updates", 1000000);
+    long jobs = bench_arg(argc, argv, "jobs", 1000000);
+    long backlog = bench_arg(argc, argv, "backlog", 10000);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+    int arity;
+
+    if (n < 1 || n > 0x7FFFFFFF || updates < 0 || jobs < 1 || backlog < 0) {
+        fprintf(stderr, "-n and -jobs must be positive\n");
+        return 1;
+    }
+
+    printf("+----------+-------+------------+----------+-------+\n");
+    printf("| %-8s | %5s | %10s | %8s | %5s |\n", "OP", "ARITY", "OPS", "NS/OP", "CHECK");
+    printf("+----------+-------+------------+----------+-------+\n");
+
+    for (arity = 2; arity <= 8; arity *= 2) {
+        if (run_arity(arity, n, updates, start_seed) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    printf("+----------+-------+------------+----------+-------+\n");
+
+    if (run_schedule(jobs, backlog, start_seed) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    return 0;
+}
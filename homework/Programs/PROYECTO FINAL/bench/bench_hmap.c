@@ -0,0 +1,260 @@
+/*
+    bench_hmap.c
+    Symbol lookups in HMap against a linear search of a List, and
+    an expression cache in front of expr_evaluate
+
+    Usage: bench_hmap [-ops K] [-lines N] [-distinct D] [-seed S]
+    symbols  V variable bindings for V = 16, 256, 4096, 65536, then K
+             lookups of names that are bound (hit) and that are not
+             (miss); the List is searched with strcmp from the head,
+             with fewer lookups as V grows
+    cache    N lines drawn from D distinct generated expressions:
+             tokenized and evaluated every time, or once per distinct
+             text with the result kept in an HMap
+    CHECK counts the hits among the lookups both do, and is the sum of
+    the results for cache; it must match between the two. The times
+    include making the name or the text with sprintf
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hmap.h"
+#include "list.h"
+#include "expr.h"
+#include "bench.h"
+
+#define NAME_SIZE 16
+#define TEXT_SIZE 64
+
+/*
+    A variable binding, the name first so that the hmap string helpers
+    see it as the key
+*/
+typedef struct Binding_ {
+    char name[NAME_SIZE];
+    double value;
+} Binding;
+
+/*
+    A cached result, keyed by the text of the expression
+*/
+typedef struct CacheEntry_ {
+    char text[TEXT_SIZE];
+    double result;
+    int status;
+} CacheEntry;
+
+static void report (const char *workload, const char *container, long size, long ops, unsigned long long ns,
+                    double check) {
+    printf("| %-10s | %-10s | %8ld | %10ld | %10.1f | %16.0f |\n", workload, container, size, ops,
+           (double)ns / ops, check);
+}
+
+static Binding *list_find (List *list, const char *name) {
+    ListNode *node;
+
+    for (node = list_head(list); node != NULL; node = list_next(node)) {
+        if (strcmp(((Binding *)list_data(node))->name, name) == 0)
+            return (Binding *)list_data(node);
+    }
+
+    return NULL;
+}
+
+/*
+    symbols: bound names are "v0" to "v<V-1>", missing ones "w..."
+*/
+static int run_symbols (long size, long ops) {
+    Binding *bindings, *found;
+    HMap map;
+    List list;
+    char name[NAME_SIZE];
+    void *data;
+    unsigned long long start, ns;
+    long i, hits, list_ops;
+    int miss;
+
+    if ((bindings = (Binding *)malloc(size * sizeof(Binding))) == NULL)
+        return -1;
+
+    if (hmap_init(&map, 0, hmap_hash_string, hmap_match_string, NULL) != 0) {
+        free(bindings);
+        return -1;
+    }
+
+    list_init(&list, NULL);
+
+    for (i = 0; i < size; i++) {
+        sprintf(bindings[i].name, "v%ld", i);
+        bindings[i].value = (double)i;
+        hmap_insert(&map, &bindings[i]);
+        list_ins_next(&list, list_tail(&list), &bindings[i]);
+    }
+
+    // A linear search of 65536 names is slow, keep the List runs short
+    list_ops = ops * 16 / size;
+    list_ops = list_ops < 1000 ? 1000 : list_ops > ops ? ops : list_ops;
+
+    for (miss = 0; miss < 2; miss++) {
+        bench_seed(0x9E3779B97F4A7C15ULL);
+        hits = 0;
+        start = bench_now();
+
+        for (i = 0; i < ops; i++) {
+            sprintf(name, "%c%lu", miss ? 'w' : 'v', (unsigned long)(bench_random() % size));
+            data = name;
+            if (hmap_lookup(&map, &data) == 0 && i < list_ops)
+                hits++;
+        }
+
+        ns = bench_now() - start;
+        report(miss ? "sym miss" : "sym hit", "HMap", size, ops, ns, (double)hits);
+
+        bench_seed(0x9E3779B97F4A7C15ULL);
+        hits = 0;
+        start = bench_now();
+
+        for (i = 0; i < list_ops; i++) {
+            sprintf(name, "%c%lu", miss ? 'w' : 'v', (unsigned long)(bench_random() % size));
+            if ((found = list_find(&list, name)) != NULL)
+                hits++;
+        }
+
+        ns = bench_now() - start;
+        report(miss ? "sym miss" : "sym hit", "List", size, list_ops, ns, (double)hits);
+    }
+
+    hmap_destroy(&map);
+    list_destroy(&list);
+    free(bindings);
+
+    return 0;
+}
+
+/*
+    Text of distinct expression number index
+*/
+static void make_expression (char *text, unsigned long long index) {
+    bench_seed(index * 2654435761ULL + 1);
+    sprintf(text, "(%d+%d.%d)*%d-%d/(%d^2)", (int)(bench_random() % 100), (int)(bench_random() % 100),
+            (int)(bench_random() % 10), (int)(bench_random() % 50), (int)(bench_random() % 1000),
+            (int)(bench_random() % 9 + 1));
+
+    return;
+}
+
+static int evaluate (const char *text, double *result) {
+    ExprToken tokens[TEXT_SIZE];
+    int count = expr_tokenize(text, tokens, TEXT_SIZE);
+
+    if (count < 0 || expr_validate(tokens, count) != 0)
+        return -1;
+
+    return expr_evaluate(tokens, count, result);
+}
+
+/*
+    cache: the same sequence of lines both ways
+*/
+static int run_cache (long lines, long distinct, unsigned long long start_seed) {
+    CacheEntry *entries, *entry;
+    HMap map;
+    char text[TEXT_SIZE];
+    void *data;
+    unsigned long long start, ns, line_seed;
+    double sum, result;
+    long i, used = 0;
+
+    if ((entries = (CacheEntry *)malloc(distinct * sizeof(CacheEntry))) == NULL)
+        return -1;
+
+    if (hmap_init(&map, (int)distinct, hmap_hash_string, hmap_match_string, NULL) != 0) {
+        free(entries);
+        return -1;
+    }
+
+    line_seed = start_seed;
+    sum = 0;
+    start = bench_now();
+
+    for (i = 0; i < lines; i++) {
+        bench_seed(line_seed);
+        line_seed = bench_random();
+        make_expression(text, line_seed % distinct);
+
+        if (evaluate(text, &result) == 0)
+            sum += result;
+    }
+
+    ns = bench_now() - start;
+    report("cache", "none", distinct, lines, ns, sum);
+
+    line_seed = start_seed;
+    sum = 0;
+    start = bench_now();
+
+    for (i = 0; i < lines; i++) {
+        bench_seed(line_seed);
+        line_seed = bench_random();
+        make_expression(text, line_seed % distinct);
+        data = text;
+
+        if (hmap_lookup(&map, &data) == 0) {
+            entry = (CacheEntry *)data;
+        } else {
+            entry = &entries[used++];
+            strcpy(entry->text, text);
+            entry->status = evaluate(text, &entry->result);
+            hmap_insert(&map, entry);
+        }
+
+        if (entry->status == 0)
+            sum += entry->result;
+    }
+
+    ns = bench_now() - start;
+    report("cache", "HMap", distinct, lines, ns, sum);
+
+    hmap_destroy(&map);
+    free(entries);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long ops = bench_arg(argc, argv, "ops", 1000000);
+    long lines = bench_arg(argc, argv, "lines", 1000000);
+    long distinct = bench_arg(argc, argv, "distinct", 1000);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+    long size;
+
+    if (ops < 1 || lines < 1 || distinct < 1 || distinct > 1L << 28) {
+        fprintf(stderr, "-ops, -lines and -distinct must be positive\n");
+        return 1;
+    }
+
+    printf("+------------+------------+----------+------------+------------+------------------+\n");
+    printf("| %-10s | %-10s | %8s | %10s | %10s | %16s |\n", "WORKLOAD", "CONTAINER", "SIZE", "OPS", "NS/OP",
+           "CHECK");
+    printf("+------------+------------+----------+------------+------------+------------------+\n");
+
+    for (size = 16; size <= 65536; size *= 16) {
+        if (run_symbols(size, ops) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    if (run_cache(lines, distinct, start_seed) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("+------------+------------+----------+------------+------------+------------------+\n");
+
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*
+    bench_lfstack.c
+    Stress test and throughput of the lock-free stack against the list
+    Stack behind a mutex
+
+    Usage: bench_lfstack [-ops N] [-min THREADS] [-max THREADS] [-rounds N]
+    Every thread runs -ops random pushes and pops (1 .. 64 threads by
+    default, doubling). Pushed values are unique; after the run the
+    stack is drained and every value must have been popped exactly
+    once. -rounds repeats each run, to stress reclamation longer.
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "stack.h"
+#include "lfstack.h"
+#include "bench.h"
+
+/*
+    Stack under test
+*/
+typedef struct Subject_ {
+    const char *name;
+
+    void (*init) (struct Subject_ *subject);
+    void (*destroy) (struct Subject_ *subject);
+    int (*push) (struct Subject_ *subject, const void *data);
+    int (*pop) (struct Subject_ *subject, void **data);
+
+    LFStack lfstack;
+
+    Stack stack;
+    pthread_mutex_t mutex;
+} Subject;
+
+static void lf_case_init (Subject *subject) { lfstack_init(&subject->lfstack, NULL); }
+
+static void lf_case_destroy (Subject *subject) {
+    lfstack_destroy(&subject->lfstack);
+    lfstack_quiesce();
+}
+
+static int lf_case_push (Subject *subject, const void *data) {
+    return lfstack_push(&subject->lfstack, data);
+}
+
+static int lf_case_pop (Subject *subject, void **data) {
+    return lfstack_pop(&subject->lfstack, data);
+}
+
+static void mutex_case_init (Subject *subject) {
+    stack_init(&subject->stack, NULL);
+    pthread_mutex_init(&subject->mutex, NULL);
+}
+
+static void mutex_case_destroy (Subject *subject) {
+    stack_destroy(&subject->stack);
+    pthread_mutex_destroy(&subject->mutex);
+}
+
+static int mutex_case_push (Subject *subject, const void *data) {
+    int retval;
+
+    pthread_mutex_lock(&subject->mutex);
+    retval = stack_push(&subject->stack, data);
+    pthread_mutex_unlock(&subject->mutex);
+
+    return retval;
+}
+
+static int mutex_case_pop (Subject *subject, void **data) {
+    int retval;
+
+    pthread_mutex_lock(&subject->mutex);
+    retval = stack_pop(&subject->stack, data);
+    pthread_mutex_unlock(&subject->mutex);
+
+    return retval;
+}
+
+/*
+    Shared state of one run
+*/
+typedef struct Run_ {
+    Subject *subject;
+    long ops;
+    int start;
+
+    /* Times every value was popped, indexed by value - 1 */
+    unsigned char *seen;
+} Run;
+
+/*
+    Per-thread state, padded so threads do not share cache lines
+*/
+typedef struct Worker_ {
+    Run *run;
+    int index;
+    pthread_t thread;
+
+    unsigned long long seed;
+    long empty;
+
+    char pad[64];
+} Worker;
+
+static void record_pop (Run *run, void *data) {
+    __atomic_fetch_add(&run->seen[(size_t)data - 1], 1, __ATOMIC_RELAXED);
+}
+
+/*
+    Random pushes and pops, pushes slightly more likely so the stack is
+    rarely empty
+*/
+static void *worker_main (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    Subject *subject = run->subject;
+    void *data;
+    long i, value = (long)worker->index * run->ops;
+
+    while (!__atomic_load_n(&run->start, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    for (i = 0; i < run->ops; i++) {
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 7;
+        worker->seed ^= worker->seed << 17;
+
+        if (worker->seed % 8 < 5) {
+            if (subject->push(subject, (void *)(++value)) != 0)
+                fprintf(stderr, "%s: out of memory\n", subject->name);
+        } else if (subject->pop(subject, &data) == 0) {
+            record_pop(run, data);
+        } else {
+            worker->empty++;
+        }
+    }
+
+    // Values this worker never pushed are marked as popped
+    for (value++; value <= (long)(worker->index + 1) * run->ops; value++)
+        record_pop(run, (void *)value);
+
+    lfstack_thread_exit();
+
+    return NULL;
+}
+
+/*
+    One run, returns the number of values not popped exactly once
+*/
+static long run_subject (Subject *subject, long ops, int threads, unsigned long long *ns, long *empty) {
+    Run run;
+    Worker *workers;
+    unsigned long long start;
+    void *data;
+    long i, bad = 0;
+
+    if ((workers = (Worker *)calloc(threads, sizeof(Worker))) == NULL)
+        return -1;
+
+    if ((run.seen = (unsigned char *)calloc((size_t)ops * threads, 1)) == NULL) {
+        free(workers);
+        return -1;
+    }
+
+    subject->init(subject);
+    run.subject = subject;
+    run.ops = ops;
+    run.start = 0;
+
+    for (i = 0; i < threads; i++) {
+        workers[i].run = &run;
+        workers[i].index = (int)i;
+        workers[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+
+    start = bench_now();
+    __atomic_store_n(&run.start, 1, __ATOMIC_RELEASE);
+
+    for (i = 0; i < threads; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    *ns = bench_now() - start;
+    *empty = 0;
+
+    for (i = 0; i < threads; i++)
+        *empty += workers[i].empty;
+
+    // Drain and check
+    while (subject->pop(subject, &data) == 0)
+        record_pop(&run, data);
+
+    for (i = 0; i < ops * threads; i++)
+        bad += run.seen[i] != 1;
+
+    subject->destroy(subject);
+    free(run.seen);
+    free(workers);
+
+    return bad;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long ops = bench_arg(argc, argv, "ops", 200000);
+    int min = (int)bench_arg(argc, argv, "min", 1);
+    int max = (int)bench_arg(argc, argv, "max", 64);
+    int rounds = (int)bench_arg(argc, argv, "rounds", 1);
+    Subject subjects[2];
+    unsigned long long ns, total;
+    long bad, empty, empty_total;
+    int threads, s, r, failed = 0;
+
+    memset(subjects, 0, sizeof(subjects));
+
+    subjects[0].name = "lfstack";
+    subjects[0].init = lf_case_init;
+    subjects[0].destroy = lf_case_destroy;
+    subjects[0].push = lf_case_push;
+    subjects[0].pop = lf_case_pop;
+
+    subjects[1].name = "stack+mutex";
+    subjects[1].init = mutex_case_init;
+    subjects[1].destroy = mutex_case_destroy;
+    subjects[1].push = mutex_case_push;
+    subjects[1].pop = mutex_case_pop;
+
+    printf("+--------------+---------+----------+----------+-----------+-------+\n");
+    printf("| %-12s | %7s | %8s | %8s | %9s | %5s |\n", "STACK", "THREADS", "NS/OP", "MOPS/S",
+           "EMPTY/OP", "CHECK");
+    printf("+--------------+---------+----------+----------+-----------+-------+\n");
+
+    for (threads = min; threads <= max; threads *= 2) {
+        for (s = 0; s < 2; s++) {
+            total = 0;
+            empty_total = 0;
+            bad = 0;
+
+            for (r = 0; r < rounds && bad == 0; r++) {
+                if ((bad = run_subject(&subjects[s], ops, threads, &ns, &empty)) < 0) {
+                    fprintf(stderr, "Out of memory\n");
+                    return 1;
+                }
+
+                total += ns;
+                empty_total += empty;
+            }
+
+            printf("| %-12s | %7d | %8.1f | %8.2f | %9.3f | %5s |\n", subjects[s].name, threads,
+                   (double)total / ((double)ops * threads * r), ops * threads * r / (total / 1e3),
+                   (double)empty_total / ((double)ops * threads * r), bad == 0 ? "OK" : "LOST");
+
+            failed |= bad != 0;
+        }
+    }
+
+    printf("+--------------+---------+----------+----------+-----------+-------+\n");
+
+    return failed;
+}
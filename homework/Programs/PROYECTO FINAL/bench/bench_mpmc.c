@@ -0,0 +1,279 @@
+/*
+    bench_mpmc.c
+    Contention benchmark of the lock-free MPMC queue against the list
+    Queue behind a mutex
+
+    Usage: bench_mpmc [-items N] [-capacity N] [-min THREADS] [-max THREADS]
+    Each run starts THREADS producers and THREADS consumers (1 .. 64 by
+    default, doubling) that move -items pointers through a queue of
+    -capacity cells. FULL/OP and EMPTY/OP are the failed try calls per
+    item, a measure of contention and backpressure. Every run checks
+    that each item arrived exactly once.
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "queue.h"
+#include "mpmc_queue.h"
+#include "bench.h"
+
+/* Failed tries before a waiting thread yields */
+#define SPINS 64
+
+/*
+    Queue under test, behind try calls that fail when full or empty
+*/
+typedef struct Subject_ {
+    const char *name;
+
+    int (*init) (struct Subject_ *subject, size_t capacity);
+    void (*destroy) (struct Subject_ *subject);
+    int (*try_enqueue) (struct Subject_ *subject, const void *data);
+    int (*try_dequeue) (struct Subject_ *subject, void **data);
+
+    MPMCQueue mpmc;
+
+    Queue queue;
+    size_t capacity;
+    pthread_mutex_t mutex;
+} Subject;
+
+static int mpmc_case_init (Subject *subject, size_t capacity) {
+    return mpmc_queue_init(&subject->mpmc, capacity);
+}
+
+static void mpmc_case_destroy (Subject *subject) { mpmc_queue_destroy(&subject->mpmc); }
+
+static int mpmc_case_enqueue (Subject *subject, const void *data) {
+    return mpmc_queue_try_enqueue(&subject->mpmc, data);
+}
+
+static int mpmc_case_dequeue (Subject *subject, void **data) {
+    return mpmc_queue_try_dequeue(&subject->mpmc, data);
+}
+
+static int mutex_case_init (Subject *subject, size_t capacity) {
+    queue_init(&subject->queue, NULL);
+    subject->capacity = capacity;
+
+    return pthread_mutex_init(&subject->mutex, NULL) == 0 ? 0 : -1;
+}
+
+static void mutex_case_destroy (Subject *subject) {
+    queue_destroy(&subject->queue);
+    pthread_mutex_destroy(&subject->mutex);
+}
+
+static int mutex_case_enqueue (Subject *subject, const void *data) {
+    int retval = -1;
+
+    pthread_mutex_lock(&subject->mutex);
+
+    if ((size_t)queue_size(&subject->queue) < subject->capacity)
+        retval = queue_enqueue(&subject->queue, data);
+
+    pthread_mutex_unlock(&subject->mutex);
+
+    return retval;
+}
+
+static int mutex_case_dequeue (Subject *subject, void **data) {
+    int retval;
+
+    pthread_mutex_lock(&subject->mutex);
+    retval = queue_dequeue(&subject->queue, data);
+    pthread_mutex_unlock(&subject->mutex);
+
+    return retval;
+}
+
+/*
+    Shared state of one run
+*/
+typedef struct Run_ {
+    Subject *subject;
+    long items;
+    int producers;
+
+    int start;
+    long claimed;
+} Run;
+
+/*
+    Per-thread counters, padded so threads do not share cache lines
+*/
+typedef struct Worker_ {
+    Run *run;
+    int index;
+    pthread_t thread;
+
+    unsigned long long failures;
+    unsigned long long sum;
+    long count;
+
+    char pad[MPMC_CACHE_LINE];
+} Worker;
+
+static void wait_start (Run *run) {
+    while (!__atomic_load_n(&run->start, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+/*
+    Producer: items index, index + producers, ...
+*/
+static void *producer (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    long i;
+    int spins = 0;
+
+    wait_start(run);
+
+    for (i = worker->index; i < run->items; i += run->producers) {
+        while (run->subject->try_enqueue(run->subject, (void *)(i + 1)) != 0) {
+            worker->failures++;
+
+            if (++spins >= SPINS) {
+                sched_yield();
+                spins = 0;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    Consumer: claims a ticket for every item it takes, so the consumers
+    stop exactly when all the items are taken
+*/
+static void *consumer (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    void *data;
+    int spins = 0;
+
+    wait_start(run);
+
+    while (__atomic_fetch_add(&run->claimed, 1, __ATOMIC_RELAXED) < run->items) {
+        while (run->subject->try_dequeue(run->subject, &data) != 0) {
+            worker->failures++;
+
+            if (++spins >= SPINS) {
+                sched_yield();
+                spins = 0;
+            }
+        }
+
+        worker->sum += (unsigned long long)(size_t)data;
+        worker->count++;
+    }
+
+    return NULL;
+}
+
+/*
+    Run threads producers and threads consumers on a subject
+*/
+static int run_subject (Subject *subject, long items, size_t capacity, int threads) {
+    Run run;
+    Worker *workers;
+    unsigned long long start, ns, full = 0, empty = 0, sum = 0;
+    unsigned long long expected = (unsigned long long)items * (items + 1) / 2;
+    long count = 0;
+    int i, ok;
+
+    if ((workers = (Worker *)calloc(2 * threads, sizeof(Worker))) == NULL)
+        return -1;
+
+    if (subject->init(subject, capacity) != 0) {
+        free(workers);
+        return -1;
+    }
+
+    run.subject = subject;
+    run.items = items;
+    run.producers = threads;
+    run.start = 0;
+    run.claimed = 0;
+
+    for (i = 0; i < 2 * threads; i++) {
+        workers[i].run = &run;
+        workers[i].index = i % threads;
+        pthread_create(&workers[i].thread, NULL, i < threads ? producer : consumer, &workers[i]);
+    }
+
+    start = bench_now();
+    __atomic_store_n(&run.start, 1, __ATOMIC_RELEASE);
+
+    for (i = 0; i < 2 * threads; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    ns = bench_now() - start;
+
+    for (i = 0; i < threads; i++) {
+        full += workers[i].failures;
+        empty += workers[threads + i].failures;
+        sum += workers[threads + i].sum;
+        count += workers[threads + i].count;
+    }
+
+    ok = (count == items && sum == expected);
+
+    printf("| %-12s | %7d | %8.1f | %8.2f | %9.2f | %9.2f | %5s |\n", subject->name, threads,
+           (double)ns / items, items / (ns / 1e3), (double)full / items, (double)empty / items,
+           ok ? "OK" : "LOST");
+
+    subject->destroy(subject);
+    free(workers);
+
+    return ok ? 0 : -1;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long items = bench_arg(argc, argv, "items", 1000000);
+    size_t capacity = (size_t)bench_arg(argc, argv, "capacity", 1024);
+    int min = (int)bench_arg(argc, argv, "min", 1);
+    int max = (int)bench_arg(argc, argv, "max", 64);
+    Subject subjects[2];
+    int threads, s, failed = 0;
+
+    memset(subjects, 0, sizeof(subjects));
+
+    subjects[0].name = "mpmc_queue";
+    subjects[0].init = mpmc_case_init;
+    subjects[0].destroy = mpmc_case_destroy;
+    subjects[0].try_enqueue = mpmc_case_enqueue;
+    subjects[0].try_dequeue = mpmc_case_dequeue;
+
+    subjects[1].name = "queue+mutex";
+    subjects[1].init = mutex_case_init;
+    subjects[1].destroy = mutex_case_destroy;
+    subjects[1].try_enqueue = mutex_case_enqueue;
+    subjects[1].try_dequeue = mutex_case_dequeue;
+
+    printf("+--------------+---------+----------+----------+-----------+-----------+-------+\n");
+    printf("| %-12s | %7s | %8s | %8s | %9s | %9s | %5s |\n", "QUEUE", "THREADS", "NS/OP",
+           "MOPS/S", "FULL/OP", "EMPTY/OP", "CHECK");
+    printf("+--------------+---------+----------+----------+-----------+-----------+-------+\n");
+
+    for (threads = min; threads <= max; threads *= 2) {
+        for (s = 0; s < 2; s++) {
+            if (run_subject(&subjects[s], items, capacity, threads) != 0)
+                failed = 1;
+        }
+    }
+
+    printf("+--------------+---------+----------+----------+-----------+-----------+-------+\n");
+
+    return failed;
+}
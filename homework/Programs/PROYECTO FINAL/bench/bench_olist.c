@@ -0,0 +1,181 @@
+/*
+    bench_olist.c
+    Positional access and edits on DList and the order-statistic OList
+
+    Usage: bench_olist [-n N] [-ops K] [-seed S]
+    A sequence of N tokens, then K operations at random positions:
+    at       read the token at a position
+    insert   insert a token at a position
+    remove   remove the token at a position
+    scan     one walk over the whole sequence, head to tail
+    DList walks from the nearer end, OList descends the tree. Both see
+    the same positions; CHECK sums what was read or removed, and must
+    match between the two
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlist.h"
+#include "olist.h"
+#include "bench.h"
+
+static void report (const char *operation, const char *list, long ops, unsigned long long ns, long check) {
+    printf("| %-8s | %-6s | %10ld | %12.1f | %16ld |\n", operation, list, ops, (double)ns / ops, check);
+}
+
+/*
+    Node at position index, walking from the nearer end
+*/
+static DListNode *dlist_walk (DList *list, int index) {
+    DListNode *node;
+    int i;
+
+    if (index < dlist_size(list) / 2) {
+        for (node = dlist_head(list), i = 0; i < index; i++)
+            node = dlist_next(node);
+    } else {
+        for (node = dlist_tail(list), i = dlist_size(list) - 1; i > index; i--)
+            node = dlist_prev(node);
+    }
+
+    return node;
+}
+
+static void run_dlist (long n, long ops, unsigned long long start_seed) {
+    DList list;
+    DListNode *node;
+    unsigned long long start, ns;
+    void *data;
+    long i, check;
+    int index;
+
+    dlist_init(&list, NULL);
+
+    for (i = 0; i < n; i++)
+        dlist_ins_next(&list, dlist_tail(&list), (void *)i);
+
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < ops; i++)
+        check += (long)dlist_data(dlist_walk(&list, (int)(bench_random() % dlist_size(&list))));
+
+    ns = bench_now() - start;
+    report("at", "DList", ops, ns, check);
+
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        index = (int)(bench_random() % (dlist_size(&list) + 1));
+
+        if (index == dlist_size(&list))
+            dlist_ins_next(&list, dlist_tail(&list), (void *)(n + i));
+        else
+            dlist_ins_prev(&list, dlist_walk(&list, index), (void *)(n + i));
+    }
+
+    ns = bench_now() - start;
+    report("insert", "DList", ops, ns, dlist_size(&list));
+
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        dlist_remove(&list, dlist_walk(&list, (int)(bench_random() % dlist_size(&list))), &data);
+        check += (long)data;
+    }
+
+    ns = bench_now() - start;
+    report("remove", "DList", ops, ns, check);
+
+    check = 0;
+    start = bench_now();
+
+    for (node = dlist_head(&list); node != NULL; node = dlist_next(node))
+        check += (long)dlist_data(node);
+
+    ns = bench_now() - start;
+    report("scan", "DList", dlist_size(&list), ns, check);
+
+    dlist_destroy(&list);
+}
+
+static void run_olist (long n, long ops, unsigned long long start_seed) {
+    OList list;
+    OListNode *node;
+    unsigned long long start, ns;
+    void *data;
+    long i, check;
+
+    olist_init(&list, NULL);
+
+    for (i = 0; i < n; i++)
+        olist_ins_at(&list, olist_size(&list), (void *)i);
+
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < ops; i++)
+        check += (long)olist_data(olist_at(&list, (int)(bench_random() % olist_size(&list))));
+
+    ns = bench_now() - start;
+    report("at", "OList", ops, ns, check);
+
+    start = bench_now();
+
+    for (i = 0; i < ops; i++)
+        olist_ins_at(&list, (int)(bench_random() % (olist_size(&list) + 1)), (void *)(n + i));
+
+    ns = bench_now() - start;
+    report("insert", "OList", ops, ns, olist_size(&list));
+
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        olist_remove_at(&list, (int)(bench_random() % olist_size(&list)), &data);
+        check += (long)data;
+    }
+
+    ns = bench_now() - start;
+    report("remove", "OList", ops, ns, check);
+
+    check = 0;
+    start = bench_now();
+
+    for (node = olist_head(&list); node != NULL; node = olist_next(node))
+        check += (long)olist_data(node);
+
+    ns = bench_now() - start;
+    report("scan", "OList", olist_size(&list), ns, check);
+
+    olist_destroy(&list);
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 1000000);
+    long ops = bench_arg(argc, argv, "ops", 10000);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+
+    if (n < 1 || ops < 1 || n + ops > 0x7FFFFFFF) {
+        fprintf(stderr, "-n and -ops must be positive and fit an int together\n");
+        return 1;
+    }
+
+    printf("+----------+--------+------------+--------------+------------------+\n");
+    printf("| %-8s | %-6s | %10s | %12s | %16s |\n", "OP", "LIST", "OPS", "NS/OP", "CHECK");
+    printf("+----------+--------+------------+--------------+------------------+\n");
+
+    run_dlist(n, ops, start_seed);
+    printf("+----------+--------+------------+--------------+------------------+\n");
+    run_olist(n, ops, start_seed);
+    printf("+----------+--------+------------+--------------+------------------+\n");
+
+    return 0;
+}
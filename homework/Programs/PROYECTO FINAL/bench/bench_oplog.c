@@ -0,0 +1,216 @@
+/*
+    bench_oplog.c
+    Saving operations as INFIX used to, opening the file in append mode
+    and closing it for every record, against an OpLog kept open with a
+    large buffer, group commit and a sidecar index; and finding a saved
+    operation through that index against reading the text
+
+    Usage: bench_oplog [-n N] [-lookups K] [-steps S] [-seed S]
+    fopen    N records, one fopen and fclose each
+    oplog    N records with groups of 1 and 64, then N / 10 with fsync
+             on every commit
+    hash     K lookups of a random expression in the index
+    scan     K / 100 lookups of a random expression reading the text
+    time     K lookups of the records of a random minute in the index
+    Records look like the ones INFIX writes, with S steps; the files
+    are bench_oplog.log and its index in the current directory, removed
+    at the end. CHECK is the records found
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oplog.h"
+#include "bench.h"
+
+#define LOG_FILE "bench_oplog.log"
+#define INDEX_FILE "bench_oplog.log.idx"
+
+/*
+    Time of the first record, one is saved every second
+*/
+#define START_TIME 1700000000LL
+
+static void report (const char *workload, int group, const char *sync, long ops, unsigned long long ns, long check) {
+    printf("| %-8s | %5d | %-5s | %9ld | %12.1f | %10ld |\n", workload, group, sync, ops, (double)ns / ops, check);
+}
+
+static void write_record (FILE *file, long i, int steps) {
+    int k;
+
+    fprintf(file, "==============================================\n");
+    fprintf(file, "SAVED OPERATION: record %ld\n", i);
+    fprintf(file, "Expression: e%ld\n", i);
+    fprintf(file, "----------------------------------------------\n");
+    fprintf(file, "Evaluation steps:\n");
+
+    for (k = 0; k < steps; k++)
+        fprintf(file, "Step %d: %.4f + %.4f = %.4f\n", k + 1, (double)k, (double)i, (double)(k + i));
+
+    fprintf(file, "----------------------------------------------\n");
+    fprintf(file, "FINAL RESULT: %.4f\n", (double)i);
+    fprintf(file, "==============================================\n\n");
+}
+
+static void remove_log (void) {
+    remove(LOG_FILE);
+    remove(INDEX_FILE);
+}
+
+static int save_records (long n, int steps, int group, int sync) {
+    OpLog log;
+    FILE *file;
+    char key[32];
+    long i;
+
+    remove_log();
+
+    if (oplog_open(&log, LOG_FILE, 1 << 20, group, sync, 0) != 0)
+        return -1;
+
+    for (i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "e%ld", i);
+
+        if ((file = oplog_begin(&log, (time_t)(START_TIME + i), key)) == NULL)
+            return -1;
+
+        write_record(file, i, steps);
+
+        if (oplog_end(&log) != 0)
+            return -1;
+    }
+
+    return oplog_close(&log);
+}
+
+static int count_entry (const OpLogEntry *entry, void *data) {
+
+    (void)entry;
+    (*(long *)data)++;
+
+    return 0;
+}
+
+static int run (long n, long lookups, int steps) {
+    static const int groups[2] = {1, 64};
+    char key[32], line[128], want[64];
+    unsigned long long start, ns;
+    long i, found, ops;
+    FILE *file;
+    int g;
+
+    // fopen, as save_operations_to_file did
+    remove_log();
+    start = bench_now();
+
+    for (i = 0; i < n; i++) {
+        if ((file = fopen(LOG_FILE, "a")) == NULL)
+            return -1;
+
+        write_record(file, i, steps);
+        fclose(file);
+    }
+
+    ns = bench_now() - start;
+    report("fopen", 1, "no", n, ns, n);
+
+    // oplog, synced with fewer records
+    for (g = 0; g < 4; g++) {
+        ops = g < 2 ? n : (n / 10 > 0 ? n / 10 : 1);
+        start = bench_now();
+
+        if (save_records(ops, steps, groups[g % 2], g < 2 ? OPLOG_SYNC_NONE : OPLOG_SYNC_COMMIT) != 0)
+            return -1;
+
+        ns = bench_now() - start;
+        report("oplog", groups[g % 2], g < 2 ? "no" : "yes", ops, ns, ops);
+    }
+
+    if (save_records(n, steps, 64, OPLOG_SYNC_NONE) != 0)
+        return -1;
+
+    // hash
+    found = 0;
+    start = bench_now();
+
+    for (i = 0; i < lookups; i++) {
+        snprintf(key, sizeof(key), "e%ld", (long)(bench_random() % n));
+
+        if (oplog_find_hash(LOG_FILE, oplog_hash(key), count_entry, &found) < 0)
+            return -1;
+    }
+
+    ns = bench_now() - start;
+    report("hash", 64, "no", lookups, ns, found);
+
+    // scan
+    ops = lookups / 100 > 0 ? lookups / 100 : 1;
+    found = 0;
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        snprintf(want, sizeof(want), "Expression: e%ld\n", (long)(bench_random() % n));
+
+        if ((file = fopen(LOG_FILE, "r")) == NULL)
+            return -1;
+
+        while (fgets(line, sizeof(line), file) != NULL) {
+            if (strcmp(line, want) == 0)
+                found++;
+        }
+
+        fclose(file);
+    }
+
+    ns = bench_now() - start;
+    report("scan", 64, "no", ops, ns, found);
+
+    // time
+    found = 0;
+    start = bench_now();
+
+    for (i = 0; i < lookups; i++) {
+        long long since = START_TIME + (long long)(bench_random() % n);
+
+        if (oplog_find_time(LOG_FILE, since, since + 59, count_entry, &found) < 0)
+            return -1;
+    }
+
+    ns = bench_now() - start;
+    report("time", 64, "no", lookups, ns, found);
+
+    remove_log();
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 100000);
+    long lookups = bench_arg(argc, argv, "lookups", 1000);
+    long steps = bench_arg(argc, argv, "steps", 6);
+
+    bench_seed((unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1);
+
+    if (n < 1 || lookups < 1 || steps < 0 || steps > 1000) {
+        fprintf(stderr, "-n and -lookups must be positive and -steps at most 1000\n");
+        return 1;
+    }
+
+    printf("+----------+-------+-------+-----------+--------------+------------+\n");
+    printf("| %-8s | %5s | %-5s | %9s | %12s | %10s |\n", "WORKLOAD", "GROUP", "FSYNC", "OPS", "NS/OP", "CHECK");
+    printf("+----------+-------+-------+-----------+--------------+------------+\n");
+
+    if (run(n, lookups, (int)steps) != 0) {
+        fprintf(stderr, "Could not write %s\n", LOG_FILE);
+        remove_log();
+        return 1;
+    }
+
+    printf("+----------+-------+-------+-----------+--------------+------------+\n");
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+/*
+    bench_pstack.c
+    Keeping the stack of every step of a trace: PStack versions against
+    a copy of a Stack per step, and reading a stack for the table by
+    walking it against popping it out and back
+
+    Usage: bench_pstack [-steps N] [-depth D] [-seed S]
+    snapshot N pushes and pops that keep the stack between D/2 and D
+             deep, the stack of every step is kept until the end; the
+             Stack copies are limited to 2^24 nodes, fewer steps as D
+             grows. NODES is the nodes allocated for the whole trace
+    read     the stack of every step collected top first: in place for
+             PStack, popped onto a temporary Stack and pushed back for
+             Stack, as print_stack did
+    CHECK is the sum of the tops of the kept stacks, and of the elements
+    read; it must match between the two
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pstack.h"
+#include "stack.h"
+#include "bench.h"
+
+static void report (const char *workload, const char *container, long depth, long steps, unsigned long long ns,
+                    long nodes, double check) {
+    printf("| %-8s | %-10s | %6ld | %9ld | %10.1f | %11ld | %14.0f |\n", workload, container, depth, steps,
+           (double)ns / steps, nodes, check);
+}
+
+/*
+    Steps: 1 to push values[step], 0 to pop. The first depth are pushes
+*/
+static void make_steps (char *push, long steps, long depth) {
+    long i, size = 0;
+
+    for (i = 0; i < steps; i++) {
+        if (size < depth / 2 + 1)
+            push[i] = 1;
+        else if (size >= depth)
+            push[i] = 0;
+        else
+            push[i] = (char)(bench_random() & 1);
+
+        size += push[i] ? 1 : -1;
+    }
+
+    return;
+}
+
+/*
+    A copy of stack, bottom first so that the order is kept
+*/
+static int stack_copy (Stack *to, Stack *from) {
+    ListNode *node;
+
+    stack_init(to, NULL);
+
+    for (node = list_head(from); node != NULL; node = list_next(node)) {
+        if (list_ins_next(to, list_tail(to), list_data(node)) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static long read_pstack (const PStack *stack, long *elements) {
+    PStackNode *node;
+    long count = 0;
+
+    for (node = pstack_head(stack); node != NULL; node = pstack_next(node))
+        elements[count++] = *(long *)pstack_data(node);
+
+    return count;
+}
+
+static long read_stack (Stack *stack, long *elements) {
+    Stack temp;
+    void *data;
+    long count = 0;
+
+    stack_init(&temp, NULL);
+
+    while (stack_size(stack) > 0) {
+        stack_pop(stack, &data);
+        elements[count++] = *(long *)data;
+        stack_push(&temp, data);
+    }
+
+    while (stack_size(&temp) > 0) {
+        stack_pop(&temp, &data);
+        stack_push(stack, data);
+    }
+
+    return count;
+}
+
+static int run_depth (long depth, long steps, const long *values) {
+    PStack *versions;
+    Stack *copies, stack;
+    char *push;
+    long *elements, i, k, count, copy_steps, nodes;
+    double check;
+    void *data;
+    unsigned long long start, ns;
+
+    copy_steps = (1L << 24) / depth;
+    copy_steps = copy_steps < steps ? copy_steps : steps;
+
+    push = (char *)malloc(steps);
+    versions = (PStack *)malloc(steps * sizeof(PStack));
+    copies = (Stack *)malloc(copy_steps * sizeof(Stack));
+    elements = (long *)malloc((depth + 1) * sizeof(long));
+
+    if (push == NULL || versions == NULL || copies == NULL || elements == NULL) {
+        free(push);
+        free(versions);
+        free(copies);
+        free(elements);
+        return -1;
+    }
+
+    make_steps(push, steps, depth);
+
+    // snapshot, PStack: every step is one more version
+    start = bench_now();
+    nodes = 0;
+
+    for (i = 0; i < steps; i++) {
+        pstack_init(&versions[i], NULL);
+
+        if (push[i]) {
+            pstack_push(&versions[i], i > 0 ? &versions[i - 1] : &versions[i], &values[i]);
+            nodes++;
+        } else {
+            pstack_pop(&versions[i], &versions[i - 1], &data);
+        }
+    }
+
+    ns = bench_now() - start;
+
+    for (check = 0, i = 0; i < copy_steps; i++)
+        check += pstack_size(&versions[i]) > 0 ? *(long *)pstack_peek(&versions[i]) : 0;
+
+    report("snapshot", "PStack", depth, steps, ns, nodes, check);
+
+    // read, PStack
+    start = bench_now();
+
+    for (check = 0, i = 0; i < copy_steps; i++) {
+        count = read_pstack(&versions[i], elements);
+
+        for (k = 0; k < count; k++)
+            check += elements[k];
+    }
+
+    ns = bench_now() - start;
+    report("read", "PStack", depth, copy_steps, ns, 0, check);
+
+    for (i = 0; i < steps; i++)
+        pstack_destroy(&versions[i]);
+
+    // snapshot, Stack: one working stack copied after every step
+    stack_init(&stack, NULL);
+    start = bench_now();
+    nodes = 0;
+
+    for (i = 0; i < copy_steps; i++) {
+        if (push[i])
+            stack_push(&stack, &values[i]);
+        else
+            stack_pop(&stack, &data);
+
+        if (stack_copy(&copies[i], &stack) != 0)
+            return -1;
+
+        nodes += stack_size(&stack) + push[i];
+    }
+
+    ns = bench_now() - start;
+
+    for (check = 0, i = 0; i < copy_steps; i++)
+        check += stack_size(&copies[i]) > 0 ? *(long *)stack_peek(&copies[i]) : 0;
+
+    report("snapshot", "Stack", depth, copy_steps, ns, nodes, check);
+
+    // read, Stack
+    start = bench_now();
+
+    for (check = 0, i = 0; i < copy_steps; i++) {
+        count = read_stack(&copies[i], elements);
+
+        for (k = 0; k < count; k++)
+            check += elements[k];
+    }
+
+    ns = bench_now() - start;
+    report("read", "Stack", depth, copy_steps, ns, 0, check);
+
+    for (i = 0; i < copy_steps; i++)
+        stack_destroy(&copies[i]);
+
+    stack_destroy(&stack);
+    free(push);
+    free(versions);
+    free(copies);
+    free(elements);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long steps = bench_arg(argc, argv, "steps", 1000000);
+    long max_depth = bench_arg(argc, argv, "depth", 4096);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+    long *values, depth, i;
+
+    if (steps < 1 || max_depth < 2 || max_depth > 1L << 24) {
+        fprintf(stderr, "-steps must be positive and -depth at least 2\n");
+        return 1;
+    }
+
+    if ((values = (long *)malloc(steps * sizeof(long))) == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    bench_seed(start_seed);
+
+    for (i = 0; i < steps; i++)
+        values[i] = (long)(bench_random() % 1000);
+
+    printf("+----------+------------+--------+-----------+------------+-------------+----------------+\n");
+    printf("| %-8s | %-10s | %6s | %9s | %10s | %11s | %14s |\n", "WORKLOAD", "CONTAINER", "DEPTH", "STEPS",
+           "NS/STEP", "NODES", "CHECK");
+    printf("+----------+------------+--------+-----------+------------+-------------+----------------+\n");
+
+    for (depth = 8; depth <= max_depth; depth *= 8) {
+        if (run_depth(depth, steps, values) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    printf("+----------+------------+--------+-----------+------------+-------------+----------------+\n");
+    free(values);
+
+    return 0;
+}
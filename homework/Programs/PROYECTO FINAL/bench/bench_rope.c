@@ -0,0 +1,246 @@
+/*
+    bench_rope.c
+    Editing a generated multi-megabyte expression in one flat buffer and
+    in a Rope, then tokenizing it again
+
+    Usage: bench_rope [-bytes N] [-edits K] [-seed S]
+    build      the expression, about N bytes, appended term by term
+    edit       K edits at random offsets, half inserting a short term
+               and half deleting a few bytes
+    substr     K reads of 64 bytes at random offsets
+    tokenize   the whole text once: the flat buffer through
+               expr_tokenize, the rope chunk by chunk through the
+               tokenizer state, and the rope copied out first
+    Both see the same edits; CHECK is the length for build and edit and
+    the token count for tokenize, and must match between the two
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rope.h"
+#include "expr.h"
+#include "bench.h"
+
+#define SUBSTR_BYTES 64
+
+/*
+    Next term of the expression, "(12.5+3)*" or "7-"
+*/
+static int make_term (char *term) {
+    unsigned long long r = bench_random();
+
+    if (r & 1)
+        return sprintf(term, "(%d.%d+%d)%c", (int)(r >> 8 & 99), (int)(r >> 16 & 9), (int)(r >> 24 & 999),
+                       "+-*/"[r >> 40 & 3]);
+
+    return sprintf(term, "%d%c", (int)(r >> 8 & 9999), "+-*/"[r >> 40 & 3]);
+}
+
+static void report (const char *operation, const char *text, long ops, unsigned long long ns, long check) {
+    printf("| %-8s | %-12s | %10ld | %12.1f | %12ld |\n", operation, text, ops, (double)ns / ops, check);
+}
+
+/*
+    Flat buffer, grown by doubling, edited with memmove
+*/
+typedef struct Flat_ {
+    char *text;
+    size_t length;
+    size_t capacity;
+} Flat;
+
+static int flat_insert (Flat *flat, size_t offset, const char *text, size_t length) {
+    char *grown;
+
+    if (flat->length + length + 1 > flat->capacity) {
+        if ((grown = (char *)realloc(flat->text, (flat->length + length + 1) * 2)) == NULL)
+            return -1;
+
+        flat->text = grown;
+        flat->capacity = (flat->length + length + 1) * 2;
+    }
+
+    memmove(flat->text + offset + length, flat->text + offset, flat->length - offset + 1);
+    memcpy(flat->text + offset, text, length);
+    flat->length += length;
+
+    return 0;
+}
+
+static void flat_delete (Flat *flat, size_t offset, size_t length) {
+    memmove(flat->text + offset, flat->text + offset + length, flat->length - offset - length + 1);
+    flat->length -= length;
+
+    return;
+}
+
+static int tokenizer_visit (void *arg, const char *text, size_t length) {
+    return expr_tokenizer_feed((ExprTokenizer *)arg, text, length);
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long bytes = bench_arg(argc, argv, "bytes", 4000000);
+    long edits = bench_arg(argc, argv, "edits", 100000);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+    unsigned long long start, ns;
+    Flat flat = {NULL, 0, 0};
+    Rope rope;
+    ExprTokenizer tokenizer;
+    ExprToken *tokens;
+    char term[64], window[SUBSTR_BYTES + 1], *copy;
+    size_t offset, length;
+    long i, check, capacity;
+    int count;
+
+    if (bytes < 1 || edits < 1) {
+        fprintf(stderr, "-bytes and -edits must be positive\n");
+        return 1;
+    }
+
+    // One token per byte at most, with room for the inserted terms
+    capacity = bytes + edits * 16;
+    tokens = (ExprToken *)malloc(capacity * sizeof(ExprToken));
+    rope_init(&rope);
+
+    if (tokens == NULL || flat_insert(&flat, 0, "", 0) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Fault the tokens in now, not in the first tokenize timed
+    memset(tokens, 0, capacity * sizeof(ExprToken));
+
+    printf("+----------+--------------+------------+--------------+--------------+\n");
+    printf("| %-8s | %-12s | %10s | %12s | %12s |\n", "OP", "TEXT", "OPS", "NS/OP", "CHECK");
+    printf("+----------+--------------+------------+--------------+--------------+\n");
+
+    // build
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; flat.length < (size_t)bytes; i++) {
+        count = make_term(term);
+        flat_insert(&flat, flat.length, term, (size_t)count);
+    }
+
+    flat_insert(&flat, flat.length, "1", 1);
+    ns = bench_now() - start;
+    report("build", "flat", i, ns, (long)flat.length);
+
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; rope_length(&rope) < (size_t)bytes; i++) {
+        count = make_term(term);
+        rope_insert(&rope, rope_length(&rope), term, (size_t)count);
+    }
+
+    rope_insert(&rope, rope_length(&rope), "1", 1);
+    ns = bench_now() - start;
+    report("build", "rope", i, ns, (long)rope_length(&rope));
+
+    // edit
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; i < edits; i++) {
+        offset = (size_t)(bench_random() % flat.length);
+
+        if (i & 1) {
+            length = (size_t)(bench_random() % 8);
+            if (length > flat.length - offset)
+                length = flat.length - offset;
+            flat_delete(&flat, offset, length);
+        } else {
+            count = make_term(term);
+            flat_insert(&flat, offset, term, (size_t)count);
+        }
+    }
+
+    ns = bench_now() - start;
+    report("edit", "flat", edits, ns, (long)flat.length);
+
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; i < edits; i++) {
+        offset = (size_t)(bench_random() % rope_length(&rope));
+
+        if (i & 1) {
+            length = (size_t)(bench_random() % 8);
+            if (length > rope_length(&rope) - offset)
+                length = rope_length(&rope) - offset;
+            rope_delete(&rope, offset, length);
+        } else {
+            count = make_term(term);
+            rope_insert(&rope, offset, term, (size_t)count);
+        }
+    }
+
+    ns = bench_now() - start;
+    report("edit", "rope", edits, ns, (long)rope_length(&rope));
+
+    // substr
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < edits; i++) {
+        offset = (size_t)(bench_random() % (flat.length - SUBSTR_BYTES));
+        memcpy(window, flat.text + offset, SUBSTR_BYTES);
+        window[SUBSTR_BYTES] = '\0';
+        check += window[i % SUBSTR_BYTES];
+    }
+
+    ns = bench_now() - start;
+    report("substr", "flat", edits, ns, check);
+
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < edits; i++) {
+        offset = (size_t)(bench_random() % (rope_length(&rope) - SUBSTR_BYTES));
+        rope_substr(&rope, offset, SUBSTR_BYTES, window);
+        check += window[i % SUBSTR_BYTES];
+    }
+
+    ns = bench_now() - start;
+    report("substr", "rope", edits, ns, check);
+
+    // tokenize
+    start = bench_now();
+    count = expr_tokenize(flat.text, tokens, (int)capacity);
+    ns = bench_now() - start;
+    report("tokenize", "flat", 1, ns, count);
+
+    start = bench_now();
+    expr_tokenizer_init(&tokenizer, tokens, (int)capacity);
+    rope_foreach_chunk(&rope, tokenizer_visit, &tokenizer);
+    count = expr_tokenizer_finish(&tokenizer);
+    ns = bench_now() - start;
+    report("tokenize", "rope chunks", 1, ns, count);
+
+    start = bench_now();
+
+    if ((copy = (char *)malloc(rope_length(&rope) + 1)) != NULL) {
+        rope_substr(&rope, 0, rope_length(&rope), copy);
+        count = expr_tokenize(copy, tokens, (int)capacity);
+        free(copy);
+    }
+
+    ns = bench_now() - start;
+    report("tokenize", "rope copied", 1, ns, count);
+
+    printf("+----------+--------------+------------+--------------+--------------+\n");
+
+    rope_destroy(&rope);
+    free(flat.text);
+    free(tokens);
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+    bench_sdlist.c
+    Insert/remove-heavy workloads on DList and the sentinel SDList
+
+    Usage: bench_sdlist [-ops N] [-lists K] [-length M] [-seed S]
+    mixed    -ops random inserts and removes at either end, the list
+             stays a few elements long so the empty, head and tail
+             cases change from call to call
+    churn    -ops inserts at the tail each followed by a remove at the
+             head, the list goes empty every time
+    concat   K lists of M elements joined into one: sdlist_concat
+             relinks them, DList has to move node by node
+    DList also updates the allocation counters; build the library with
+    -DSTATS_DISABLE to compare the lists alone
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlist.h"
+#include "sdlist.h"
+#include "bench.h"
+
+static void report (const char *workload, const char *list, long ops, unsigned long long ns,
+                    long check) {
+    printf("| %-8s | %-8s | %10ld | %8.2f | %14ld |\n", workload, list, ops, (double)ns / ops, check);
+}
+
+/*
+    mixed: the same random sequence for both lists
+*/
+static void run_mixed (long ops, unsigned long long start_seed) {
+    DList dlist;
+    SDList sdlist;
+    unsigned long long start, r;
+    void *data;
+    long i;
+
+    dlist_init(&dlist, NULL);
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        r = bench_random();
+
+        // Grow while short, shrink while long, otherwise either
+        if (dlist_size(&dlist) < 2 || (dlist_size(&dlist) < 8 && (r & 4))) {
+            if (r & 1)
+                dlist_ins_next(&dlist, dlist_tail(&dlist), (void *)i);
+            else
+                dlist_ins_prev(&dlist, dlist_head(&dlist), (void *)i);
+        } else {
+            dlist_remove(&dlist, (r & 1) ? dlist_tail(&dlist) : dlist_head(&dlist), &data);
+        }
+    }
+
+    report("mixed", "DList", ops, bench_now() - start, dlist_size(&dlist));
+    dlist_destroy(&dlist);
+
+    sdlist_init(&sdlist, NULL);
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        r = bench_random();
+
+        if (sdlist_size(&sdlist) < 2 || (sdlist_size(&sdlist) < 8 && (r & 4))) {
+            if (r & 1)
+                sdlist_ins_prev(&sdlist, sdlist_end(&sdlist), (void *)i);
+            else
+                sdlist_ins_next(&sdlist, sdlist_end(&sdlist), (void *)i);
+        } else {
+            sdlist_remove(&sdlist, (r & 1) ? sdlist_tail(&sdlist) : sdlist_head(&sdlist), &data);
+        }
+    }
+
+    report("mixed", "SDList", ops, bench_now() - start, sdlist_size(&sdlist));
+    sdlist_destroy(&sdlist);
+}
+
+/*
+    churn: every insert finds the list empty, every remove empties it
+*/
+static void run_churn (long ops) {
+    DList dlist;
+    SDList sdlist;
+    unsigned long long start;
+    void *data;
+    long i, sum = 0;
+
+    dlist_init(&dlist, NULL);
+    start = bench_now();
+
+    for (i = 0; i < ops; i++) {
+        dlist_ins_next(&dlist, dlist_tail(&dlist), (void *)i);
+        dlist_remove(&dlist, dlist_head(&dlist), &data);
+        sum += (long)data;
+    }
+
+    report("churn", "DList", ops, bench_now() - start, sum);
+    dlist_destroy(&dlist);
+
+    sdlist_init(&sdlist, NULL);
+    start = bench_now();
+    sum = 0;
+
+    for (i = 0; i < ops; i++) {
+        sdlist_ins_prev(&sdlist, sdlist_end(&sdlist), (void *)i);
+        sdlist_remove(&sdlist, sdlist_head(&sdlist), &data);
+        sum += (long)data;
+    }
+
+    report("churn", "SDList", ops, bench_now() - start, sum);
+    sdlist_destroy(&sdlist);
+}
+
+/*
+    concat: K lists built first, only the joining is timed
+*/
+static int run_concat (long lists, long length) {
+    DList *dlists, dlist;
+    SDList *sdlists, sdlist;
+    unsigned long long start;
+    void *data;
+    long k, i;
+
+    dlists = (DList *)malloc(lists * sizeof(DList));
+    sdlists = (SDList *)malloc(lists * sizeof(SDList));
+
+    if (dlists == NULL || sdlists == NULL) {
+        free(dlists);
+        free(sdlists);
+        return -1;
+    }
+
+    dlist_init(&dlist, NULL);
+
+    for (k = 0; k < lists; k++) {
+        dlist_init(&dlists[k], NULL);
+        for (i = 0; i < length; i++)
+            dlist_ins_next(&dlists[k], dlist_tail(&dlists[k]), (void *)i);
+    }
+
+    start = bench_now();
+
+    for (k = 0; k < lists; k++) {
+        while (dlist_size(&dlists[k]) > 0) {
+            dlist_remove(&dlists[k], dlist_head(&dlists[k]), &data);
+            dlist_ins_next(&dlist, dlist_tail(&dlist), data);
+        }
+    }
+
+    report("concat", "DList", lists, bench_now() - start, dlist_size(&dlist));
+    dlist_destroy(&dlist);
+
+    sdlist_init(&sdlist, NULL);
+
+    for (k = 0; k < lists; k++) {
+        sdlist_init(&sdlists[k], NULL);
+        for (i = 0; i < length; i++)
+            sdlist_ins_prev(&sdlists[k], sdlist_end(&sdlists[k]), (void *)i);
+    }
+
+    start = bench_now();
+
+    for (k = 0; k < lists; k++)
+        sdlist_concat(&sdlist, &sdlists[k]);
+
+    report("concat", "SDList", lists, bench_now() - start, sdlist_size(&sdlist));
+    sdlist_destroy(&sdlist);
+
+    for (k = 0; k < lists; k++) {
+        dlist_destroy(&dlists[k]);
+        sdlist_destroy(&sdlists[k]);
+    }
+
+    free(dlists);
+    free(sdlists);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long ops = bench_arg(argc, argv, "ops", 10000000);
+    long lists = bench_arg(argc, argv, "lists", 10000);
+    long length = bench_arg(argc, argv, "length", 100);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+
+    printf("+----------+----------+------------+----------+----------------+\n");
+    printf("| %-8s | %-8s | %10s | %8s | %14s |\n", "WORKLOAD", "LIST", "OPS", "NS/OP", "CHECK");
+    printf("+----------+----------+------------+----------+----------------+\n");
+
+    run_mixed(ops, start_seed);
+    run_churn(ops);
+
+    if (run_concat(lists, length) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("+----------+----------+------------+----------+----------------+\n");
+
+    return 0;
+}
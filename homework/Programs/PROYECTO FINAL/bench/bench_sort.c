@@ -0,0 +1,253 @@
+/*
+    bench_sort.c
+    Sorting List and DList in place against copying to an array, qsort
+    and copying back, plus reverse and concat
+
+    Usage: bench_sort [-n N] [-seed S]
+    N nodes (10^7 by default) with random keys, a quarter as many keys
+    as nodes so there are ties. Each value is key << 24 | position, the
+    comparator only looks at the key, so a stable sort leaves the values
+    in increasing order; CHECK says whether it did
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "dlist.h"
+#include "bench.h"
+
+#define POSITION_BITS 24
+
+static int compare_keys (const void *key1, const void *key2) {
+    size_t a = (size_t)key1 >> POSITION_BITS, b = (size_t)key2 >> POSITION_BITS;
+
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/*
+    qsort passes pointers to the array slots
+*/
+static int compare_slots (const void *slot1, const void *slot2) {
+    return compare_keys(*(void * const *)slot1, *(void * const *)slot2);
+}
+
+static void *make_value (long position, long n) {
+    size_t key = (size_t)(bench_random() % (unsigned long long)(n / 4 + 1));
+
+    return (void *)(key << POSITION_BITS | (size_t)position);
+}
+
+static void report (const char *operation, const char *list, long n, unsigned long long ns, int ok) {
+    printf("| %-16s | %-5s | %10ld | %8.1f | %8.3f | %5s |\n", operation, list, n, (double)ns / n,
+           ns / 1e9, ok ? "OK" : "WRONG");
+}
+
+/*
+    List
+*/
+static void list_build (List *list, long n, unsigned long long start_seed) {
+    long i;
+
+    bench_seed(start_seed);
+    list_init(list, NULL);
+
+    for (i = 0; i < n; i++)
+        list_ins_next(list, list_tail(list), make_value(i, n));
+}
+
+static int list_sorted (List *list, long n) {
+    ListNode *node;
+    long count = 0;
+
+    for (node = list_head(list); node != NULL; node = list_next(node), count++) {
+        if (list_next(node) != NULL && (size_t)list_data(node) > (size_t)list_data(list_next(node)))
+            return 0;
+    }
+
+    return count == n && list_size(list) == n && list_next(list_tail(list)) == NULL;
+}
+
+static int list_sort_array (List *list) {
+    ListNode *node;
+    void **items;
+    long i;
+
+    if ((items = (void **)malloc(list_size(list) * sizeof(void *))) == NULL)
+        return -1;
+
+    for (i = 0, node = list_head(list); node != NULL; node = list_next(node))
+        items[i++] = list_data(node);
+
+    qsort(items, list_size(list), sizeof(void *), compare_slots);
+
+    for (i = 0, node = list_head(list); node != NULL; node = list_next(node))
+        node->data = items[i++];
+
+    free(items);
+
+    return 0;
+}
+
+static void run_list (List *lists, long n) {
+    List other;
+    unsigned long long start, ns;
+    int ok;
+
+    start = bench_now();
+    ok = list_sort_array(&lists[0]) == 0;
+    ns = bench_now() - start;
+    report("array+qsort", "List", n, ns, ok && list_sorted(&lists[0], n));
+
+    start = bench_now();
+    list_sort(&lists[1], compare_keys);
+    ns = bench_now() - start;
+    report("sort", "List", n, ns, list_sorted(&lists[1], n));
+
+    start = bench_now();
+    list_sort_bottom_up(&lists[2], compare_keys);
+    ns = bench_now() - start;
+    report("sort_bottom_up", "List", n, ns, list_sorted(&lists[2], n));
+
+    start = bench_now();
+    list_reverse(&lists[2]);
+    list_reverse(&lists[2]);
+    ns = bench_now() - start;
+    report("reverse x2", "List", n, ns, list_sorted(&lists[2], n));
+
+    list_init(&other, NULL);
+    start = bench_now();
+    list_concat(&other, &lists[2]);
+    ns = bench_now() - start;
+    report("concat", "List", n, ns, list_sorted(&other, n) && list_size(&lists[2]) == 0);
+
+    list_destroy(&other);
+}
+
+/*
+    DList
+*/
+static void dlist_build (DList *list, long n, unsigned long long start_seed) {
+    long i;
+
+    bench_seed(start_seed);
+    dlist_init(list, NULL);
+
+    for (i = 0; i < n; i++)
+        dlist_ins_next(list, dlist_tail(list), make_value(i, n));
+}
+
+/*
+    Sorted both ways, so the prev links are checked too
+*/
+static int dlist_sorted (DList *list, long n) {
+    DListNode *node;
+    long count = 0;
+
+    for (node = dlist_head(list); node != NULL; node = dlist_next(node), count++) {
+        if (dlist_next(node) != NULL && (size_t)dlist_data(node) > (size_t)dlist_data(dlist_next(node)))
+            return 0;
+    }
+
+    for (node = dlist_tail(list); node != NULL; node = dlist_prev(node))
+        count--;
+
+    return count == 0 && dlist_size(list) == n;
+}
+
+static int dlist_sort_array (DList *list) {
+    DListNode *node;
+    void **items;
+    long i;
+
+    if ((items = (void **)malloc(dlist_size(list) * sizeof(void *))) == NULL)
+        return -1;
+
+    for (i = 0, node = dlist_head(list); node != NULL; node = dlist_next(node))
+        items[i++] = dlist_data(node);
+
+    qsort(items, dlist_size(list), sizeof(void *), compare_slots);
+
+    for (i = 0, node = dlist_head(list); node != NULL; node = dlist_next(node))
+        node->data = items[i++];
+
+    free(items);
+
+    return 0;
+}
+
+static void run_dlist (DList *lists, long n) {
+    DList other;
+    unsigned long long start, ns;
+    int ok;
+
+    start = bench_now();
+    ok = dlist_sort_array(&lists[0]) == 0;
+    ns = bench_now() - start;
+    report("array+qsort", "DList", n, ns, ok && dlist_sorted(&lists[0], n));
+
+    start = bench_now();
+    dlist_sort(&lists[1], compare_keys);
+    ns = bench_now() - start;
+    report("sort", "DList", n, ns, dlist_sorted(&lists[1], n));
+
+    start = bench_now();
+    dlist_sort_bottom_up(&lists[2], compare_keys);
+    ns = bench_now() - start;
+    report("sort_bottom_up", "DList", n, ns, dlist_sorted(&lists[2], n));
+
+    start = bench_now();
+    dlist_reverse(&lists[2]);
+    dlist_reverse(&lists[2]);
+    ns = bench_now() - start;
+    report("reverse x2", "DList", n, ns, dlist_sorted(&lists[2], n));
+
+    dlist_init(&other, NULL);
+    start = bench_now();
+    dlist_concat(&other, &lists[2]);
+    ns = bench_now() - start;
+    report("concat", "DList", n, ns, dlist_sorted(&other, n) && dlist_size(&lists[2]) == 0);
+
+    dlist_destroy(&other);
+}
+
+/*
+    Main
+    Every list is built before anything is timed: ListNode and DListNode
+    share a malloc size class, and a list built from nodes freed in
+    sorted order would be scattered in memory and slower to walk
+*/
+int main (int argc, char **argv) {
+    List lists[3];
+    DList dlists[3];
+    int i;
+    long n = bench_arg(argc, argv, "n", 10000000);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+
+    if (n < 1 || n >= 1L << POSITION_BITS) {
+        fprintf(stderr, "-n must be between 1 and %ld\n", (1L << POSITION_BITS) - 1);
+        return 1;
+    }
+
+    for (i = 0; i < 3; i++) {
+        list_build(&lists[i], n, start_seed);
+        dlist_build(&dlists[i], n, start_seed);
+    }
+
+    printf("+------------------+-------+------------+----------+----------+-------+\n");
+    printf("| %-16s | %-5s | %10s | %8s | %8s | %5s |\n", "OPERATION", "LIST", "NODES", "NS/NODE",
+           "SECONDS", "CHECK");
+    printf("+------------------+-------+------------+----------+----------+-------+\n");
+
+    run_list(lists, n);
+    printf("+------------------+-------+------------+----------+----------+-------+\n");
+    run_dlist(dlists, n);
+    printf("+------------------+-------+------------+----------+----------+-------+\n");
+
+    for (i = 0; i < 3; i++) {
+        list_destroy(&lists[i]);
+        dlist_destroy(&dlists[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+    bench_stepcode.c
+    INFIX steps kept as plain records in a StepTrace against the same
+    trace with stepcode sealing every full chunk: the memory per step,
+    what appending, reading and saving cost with the codec
+
+    Usage: bench_stepcode [-n N] [-lookups K] [-depth D] [-seed S]
+    append   N steps of a two stack evaluator: numbers of 1 to 3
+             digits, the four operators and their applications, the
+             stack between 1 and D deep, started afresh when it is
+             back to one number
+    scan     every step read in order
+    at       K reads of a random step, each sealed chunk read is
+             decoded again unless it was the last one read
+    save     the trace written to a temporary file
+    MEMORY is the bytes the records take, the Queue counts one cache
+    line per node as INFIX used to. BYTES/STEP is MEMORY over N, or the
+    file size for save. CHECK is the sum of the results read, it must
+    match between the containers
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "steptrace.h"
+#include "stepcode.h"
+#include "bench.h"
+
+/*
+    The evaluator, numbers bottom first
+*/
+typedef struct Evaluator_ {
+    int depth;
+    int capacity;
+    double *number;
+} Evaluator;
+
+static void report (const char *workload, const char *container, long ops, unsigned long long ns, size_t memory,
+                    long n, double check) {
+    printf("| %-8s | %-9s | %9ld | %10.1f | %12lu | %10.2f | %16.10g |\n", workload, container, ops,
+           (double)ns / ops, (unsigned long)memory, (double)memory / n, check);
+}
+
+/*
+    The next step, or two when an operator is pushed before it applies
+*/
+static int next_steps (Evaluator *evaluator, StepRecord *steps, int depth) {
+    static const char operators[4] = {'+', '-', '*', '/'};
+    StepRecord *step = steps;
+    double a, b;
+
+    memset(steps, 0, 2 * sizeof(StepRecord));
+
+    if (evaluator->depth == 1 && (bench_random() % 8) == 0)
+        evaluator->depth = 0;
+
+    if (evaluator->depth < 2 || (evaluator->depth < depth && (bench_random() & 1))) {
+        step->kind = 'N';
+        step->result = (double)(bench_random() % (bench_random() & 1 ? 10 : 1000));
+        evaluator->number[evaluator->depth++] = step->result;
+
+        return 1;
+    }
+
+    a = evaluator->number[evaluator->depth - 2];
+    b = evaluator->number[evaluator->depth - 1];
+
+    step->kind = 'O';
+    step->operator = operators[bench_random() % 4];
+    step[1] = step[0];
+    step++;
+
+    step->kind = 'A';
+    step->operand1 = a;
+    step->operand2 = b;
+
+    switch (step->operator) {
+        case '+': step->result = a + b; break;
+        case '-': step->result = a - b; break;
+        case '*': step->result = a * b; break;
+        default: step->result = b != 0 ? a / b : 0; break;
+    }
+
+    evaluator->depth--;
+    evaluator->number[evaluator->depth - 1] = step->result;
+
+    return 2;
+}
+
+static size_t trace_memory (const StepTrace *trace) {
+    size_t memory = 0;
+    int i;
+
+    for (i = 0; i < trace->chunk_count; i++)
+        memory += trace->lengths != NULL && trace->lengths[i] != 0 ? trace->lengths[i]
+                  : (size_t)STEPTRACE_CHUNK * trace->record_size;
+
+    return memory;
+}
+
+static int run (long n, long lookups, int depth, unsigned long long start_seed) {
+    StepTrace trace;
+    Evaluator evaluator;
+    StepRecord steps[2], *found;
+    unsigned long long start, ns;
+    long i, appended, file_size;
+    double check;
+    int coded, count, j;
+    FILE *file;
+
+    evaluator.capacity = depth;
+
+    if ((evaluator.number = (double *)malloc(depth * sizeof(double))) == NULL)
+        return -1;
+
+    for (coded = 0; coded <= 1; coded++) {
+        const char *container = coded ? "StepCode" : "Plain";
+
+        // append
+        steptrace_init(&trace, sizeof(StepRecord), 64);
+
+        if (coded && steptrace_set_codec(&trace, stepcode_encode, stepcode_decode, STEPCODE_MAX) != 0)
+            return -1;
+
+        evaluator.depth = 0;
+        bench_seed(start_seed);
+        check = 0;
+        start = bench_now();
+
+        for (appended = 0; appended < n; appended += count) {
+            count = next_steps(&evaluator, steps, depth);
+
+            for (j = 0; j < count && appended + j < n; j++) {
+                if (steptrace_append(&trace, &steps[j]) != 0)
+                    return -1;
+
+                check += steps[j].result;
+            }
+        }
+
+        ns = bench_now() - start;
+
+        if (!coded)
+            report("append", "Queue", n, 0, (size_t)n * LIST_CACHE_LINE, n, check);
+
+        report("append", container, n, ns, trace_memory(&trace), n, check);
+
+        // scan
+        check = 0;
+        start = bench_now();
+
+        for (i = 0; i < n; i++) {
+            if ((found = (StepRecord *)steptrace_at(&trace, (int)i)) == NULL)
+                return -1;
+
+            check += found->result;
+        }
+
+        ns = bench_now() - start;
+        report("scan", container, n, ns, trace_memory(&trace), n, check);
+
+        // at
+        bench_seed(start_seed);
+        check = 0;
+        start = bench_now();
+
+        for (i = 0; i < lookups; i++) {
+            if ((found = (StepRecord *)steptrace_at(&trace, (int)(bench_random() % n))) == NULL)
+                return -1;
+
+            check += found->result;
+        }
+
+        ns = bench_now() - start;
+        report("at", container, lookups, ns, trace_memory(&trace), n, check);
+
+        // save
+        if ((file = tmpfile()) == NULL)
+            return -1;
+
+        start = bench_now();
+
+        if (steptrace_save(&trace, file) != 0 || fflush(file) != 0)
+            return -1;
+
+        ns = bench_now() - start;
+        file_size = ftell(file);
+        fclose(file);
+        report("save", container, n, ns, (size_t)file_size, n, 0);
+
+        steptrace_destroy(&trace);
+    }
+
+    free(evaluator.number);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 1000000);
+    long lookups = bench_arg(argc, argv, "lookups", 100000);
+    long depth = bench_arg(argc, argv, "depth", 16);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+
+    if (n < 1 || n > 0x7FFFFFFF || lookups < 1 || depth < 2 || depth > 1 << 20) {
+        fprintf(stderr, "-n and -lookups must be positive and -depth at least 2\n");
+        return 1;
+    }
+
+    printf("+----------+-----------+-----------+------------+--------------+------------+------------------+\n");
+    printf("| %-8s | %-9s | %9s | %10s | %12s | %10s | %16s |\n", "WORKLOAD", "CONTAINER", "OPS", "NS/OP",
+           "MEMORY", "BYTES/STEP", "CHECK");
+    printf("+----------+-----------+-----------+------------+--------------+------------+------------------+\n");
+
+    if (run(n, lookups, (int)depth, start_seed) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("+----------+-----------+-----------+------------+--------------+------------+------------------+\n");
+
+    return 0;
+}
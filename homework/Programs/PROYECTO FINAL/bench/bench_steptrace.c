@@ -0,0 +1,269 @@
+/*
+    bench_steptrace.c
+    A trace of stack machine steps kept in a Queue of copies, as INFIX
+    did, against a StepTrace: appending, reading step k, and rebuilding
+    the stack after step k
+
+    Usage: bench_steptrace [-n N] [-lookups K] [-depth D] [-seed S]
+    append   N steps that push a number or add the two on top, the
+             stack between 1 and D deep
+    at       K reads of a random step: the Queue is walked from its
+             head, with fewer lookups since each is O(N)
+    state    K stacks rebuilt after a random step, from the nearest
+             checkpoint for intervals 16, 64 and 256, and from the
+             first step for the Queue
+    MEMORY is the bytes allocated for the trace with its checkpoints.
+    CHECK is the sum of what was read, it must match between the two
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+#include "steptrace.h"
+#include "bench.h"
+
+/*
+    A step: 'N' pushes value, 'A' replaces the two on top by their sum
+*/
+typedef struct MachineStep_ {
+    char kind;
+    double value;
+} MachineStep;
+
+/*
+    The stack machine, bottom first
+*/
+typedef struct Machine_ {
+    int depth;
+    int capacity;
+    double *stack;
+} Machine;
+
+static void report (const char *workload, const char *container, int interval, long ops, unsigned long long ns,
+                    size_t memory, double check) {
+    printf("| %-8s | %-9s | %8d | %9ld | %10.1f | %12lu | %16.0f |\n", workload, container, interval, ops,
+           (double)ns / ops, (unsigned long)memory, check);
+}
+
+static int restore_machine (void *state, const void *checkpoint, size_t length) {
+    Machine *machine = (Machine *)state;
+
+    machine->depth = (int)(length / sizeof(double));
+
+    if (machine->depth > machine->capacity)
+        return -1;
+
+    if (checkpoint != NULL)
+        memcpy(machine->stack, checkpoint, length);
+
+    return 0;
+}
+
+static int apply_machine (void *state, const void *record) {
+    Machine *machine = (Machine *)state;
+    const MachineStep *step = (const MachineStep *)record;
+
+    if (step->kind == 'N') {
+        if (machine->depth == machine->capacity)
+            return -1;
+
+        machine->stack[machine->depth++] = step->value;
+    } else {
+        if (machine->depth < 2)
+            return -1;
+
+        machine->depth--;
+        machine->stack[machine->depth - 1] += machine->stack[machine->depth];
+    }
+
+    return 0;
+}
+
+static double machine_top (const Machine *machine) {
+    return machine->depth > 0 ? machine->stack[machine->depth - 1] : 0;
+}
+
+/*
+    The next step of the run, the machine is kept in step
+*/
+static void next_step (Machine *machine, MachineStep *step, int depth) {
+
+    if (machine->depth < 2 || (machine->depth < depth && (bench_random() & 1))) {
+        step->kind = 'N';
+        step->value = (double)(bench_random() % 100);
+    } else {
+        step->kind = 'A';
+        step->value = 0;
+    }
+
+    apply_machine(machine, step);
+
+    return;
+}
+
+static ListNode *queue_at (Queue *queue, long index) {
+    ListNode *node = list_head(queue);
+
+    while (index-- > 0)
+        node = list_next(node);
+
+    return node;
+}
+
+static int run (long n, long lookups, int depth, unsigned long long start_seed) {
+    Queue queue;
+    StepTrace trace;
+    Machine machine;
+    MachineStep step, *found;
+    unsigned long long start, ns;
+    long i, k, queue_lookups;
+    size_t memory;
+    double check;
+    int interval;
+
+    machine.capacity = depth;
+    machine.depth = 0;
+
+    if ((machine.stack = (double *)malloc(depth * sizeof(double))) == NULL)
+        return -1;
+
+    queue_lookups = lookups * 1000 / n;
+    queue_lookups = queue_lookups < 100 ? 100 : queue_lookups > lookups ? lookups : queue_lookups;
+
+    // append, Queue: one node and one copy per step
+    queue_init(&queue, NULL);
+    bench_seed(start_seed);
+    start = bench_now();
+
+    for (i = 0; i < n; i++) {
+        next_step(&machine, &step, depth);
+        queue_enqueue_copy(&queue, &step, sizeof(MachineStep));
+    }
+
+    ns = bench_now() - start;
+    memory = (size_t)n * LIST_CACHE_LINE;
+    report("append", "Queue", 0, n, ns, memory, machine_top(&machine));
+
+    // at, Queue
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < queue_lookups; i++)
+        check += ((MachineStep *)list_data(queue_at(&queue, (long)(bench_random() % n))))->value;
+
+    ns = bench_now() - start;
+    report("at", "Queue", 0, queue_lookups, ns, 0, check);
+
+    // state, Queue: replay from the first step
+    bench_seed(start_seed);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < queue_lookups; i++) {
+        ListNode *node = list_head(&queue);
+
+        k = (long)(bench_random() % n);
+        machine.depth = 0;
+
+        for (; k >= 0; k--, node = list_next(node))
+            apply_machine(&machine, list_data(node));
+
+        check += machine_top(&machine);
+    }
+
+    ns = bench_now() - start;
+    report("state", "Queue", 0, queue_lookups, ns, 0, check);
+    queue_destroy(&queue);
+
+    for (interval = 16; interval <= 256; interval *= 4) {
+        // append, StepTrace: a copy of the stack every interval steps
+        steptrace_init(&trace, sizeof(MachineStep), interval);
+        machine.depth = 0;
+        bench_seed(start_seed);
+        start = bench_now();
+
+        for (i = 0; i < n; i++) {
+            next_step(&machine, &step, depth);
+
+            if (steptrace_append(&trace, &step) != 0)
+                return -1;
+
+            if (steptrace_due(&trace) && steptrace_checkpoint(&trace, machine.stack,
+                    machine.depth * sizeof(double)) != 0)
+                return -1;
+        }
+
+        ns = bench_now() - start;
+        memory = (size_t)trace.chunk_count * STEPTRACE_CHUNK * sizeof(MachineStep);
+
+        for (i = 0; i < trace.checkpoint_count; i++)
+            memory += trace.checkpoints[i].length + sizeof(StepCheckpoint);
+
+        report("append", "StepTrace", interval, n, ns, memory, machine_top(&machine));
+
+        // at, StepTrace
+        bench_seed(start_seed);
+        check = 0;
+        start = bench_now();
+
+        for (i = 0; i < queue_lookups; i++) {
+            k = (long)(bench_random() % n);
+            found = (MachineStep *)steptrace_at(&trace, k);
+            check += found->value;
+        }
+
+        ns = bench_now() - start;
+        report("at", "StepTrace", interval, queue_lookups, ns, 0, check);
+
+        // state, StepTrace
+        bench_seed(start_seed);
+        check = 0;
+        start = bench_now();
+
+        for (i = 0; i < queue_lookups; i++) {
+            if (steptrace_state(&trace, (int)(bench_random() % n), &machine, restore_machine, apply_machine) != 0)
+                return -1;
+
+            check += machine_top(&machine);
+        }
+
+        ns = bench_now() - start;
+        report("state", "StepTrace", interval, queue_lookups, ns, 0, check);
+        steptrace_destroy(&trace);
+    }
+
+    free(machine.stack);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 1000000);
+    long lookups = bench_arg(argc, argv, "lookups", 100000);
+    long depth = bench_arg(argc, argv, "depth", 64);
+    unsigned long long start_seed = (unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1;
+
+    if (n < 1 || n > 0x7FFFFFFF || lookups < 1 || depth < 2 || depth > 1 << 20) {
+        fprintf(stderr, "-n and -lookups must be positive and -depth at least 2\n");
+        return 1;
+    }
+
+    printf("+----------+-----------+----------+-----------+------------+--------------+------------------+\n");
+    printf("| %-8s | %-9s | %8s | %9s | %10s | %12s | %16s |\n", "WORKLOAD", "CONTAINER", "INTERVAL", "OPS",
+           "NS/OP", "MEMORY", "CHECK");
+    printf("+----------+-----------+----------+-----------+------------+--------------+------------------+\n");
+
+    if (run(n, lookups, (int)depth, start_seed) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("+----------+-----------+----------+-----------+------------+--------------+------------------+\n");
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+    bench_stepview.c
+    A step table written out whole, as show_steps does, against a
+    StepView that renders only the page on screen, for a trace of N
+    binary operations kept encoded by stepcode
+
+    Usage: bench_stepview [-n N] [-pages K] [-height H] [-seed S]
+    table    every row formatted and written, once
+    page     K jumps to a random row, each drawing H rows
+    search   a search for the text of a random row, found by rendering
+             the rows after the last one found, K / 1000 times
+    Output goes to /dev/null. MS is the total time: a page costs the
+    same for any N, a search up to N rows but nothing is kept of them.
+    CHECK is the sum of the rows reached
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "steptrace.h"
+#include "stepcode.h"
+#include "stepview.h"
+#include "bench.h"
+
+static void report (const char *workload, long rows, long ops, unsigned long long ns, double check) {
+    printf("| %-8s | %9ld | %9ld | %12.1f | %10.2f | %16.0f |\n", workload, rows, ops, (double)ns / ops,
+           (double)ns / 1e6, check);
+}
+
+/*
+    A row of the table is the record of the same index
+*/
+static int render_row (void *data, int row, char *line, int size) {
+    StepRecord *step = (StepRecord *)steptrace_at((StepTrace *)data, row);
+
+    if (step == NULL)
+        return -1;
+
+    snprintf(line, size, "| %-6d | %-15.4f | %-10c | %-15.4f | %-15.4f |", row + 1, step->operand1,
+             step->operator, step->operand2, step->result);
+
+    return 0;
+}
+
+static int run (long n, long pages, int height, FILE *out) {
+    static const char operators[4] = {'+', '-', '*', '/'};
+    StepTrace trace;
+    StepView view;
+    StepRecord step;
+    char line[STEPVIEW_LINE], query[STEPVIEW_QUERY];
+    unsigned long long start, ns;
+    long i, searches;
+    double check;
+
+    steptrace_init(&trace, sizeof(StepRecord), 64);
+
+    if (steptrace_set_codec(&trace, stepcode_encode, stepcode_decode, STEPCODE_MAX) != 0)
+        return -1;
+
+    memset(&step, 0, sizeof(StepRecord));
+    step.kind = 'A';
+
+    for (i = 0; i < n; i++) {
+        step.operator = operators[bench_random() % 4];
+        step.operand1 = step.result;
+        step.operand2 = (double)(bench_random() % 1000);
+        step.result = (double)(bench_random() % 100000);
+
+        if (steptrace_append(&trace, &step) != 0)
+            return -1;
+    }
+
+    // table: the whole of it, as show_steps
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < n; i++) {
+        if (render_row(&trace, (int)i, line, STEPVIEW_LINE) != 0)
+            return -1;
+
+        fprintf(out, "%s\n", line);
+        check += line[2];
+    }
+
+    fflush(out);
+    ns = bench_now() - start;
+    report("table", n, 1, ns, check);
+
+    // page
+    stepview_init(&view, (int)n, height, render_row, &trace);
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < pages; i++) {
+        stepview_goto(&view, (int)(bench_random() % n));
+
+        if (stepview_draw(&view, out) < 0)
+            return -1;
+
+        check += stepview_top(&view);
+    }
+
+    fflush(out);
+    ns = bench_now() - start;
+    report("page", n, pages, ns, check);
+
+    // search
+    searches = pages / 1000 > 0 ? pages / 1000 : 1;
+    check = 0;
+    start = bench_now();
+
+    for (i = 0; i < searches; i++) {
+        if (render_row(&trace, (int)(bench_random() % n), line, STEPVIEW_LINE) != 0)
+            return -1;
+
+        // the operands and the result, not the row number
+        strncpy(query, strchr(line + 1, '|'), STEPVIEW_QUERY - 1);
+        query[STEPVIEW_QUERY - 1] = '\0';
+        check += stepview_search(&view, query);
+    }
+
+    ns = bench_now() - start;
+    report("search", n, searches, ns, check);
+
+    steptrace_destroy(&trace);
+
+    return 0;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 1000000);
+    long pages = bench_arg(argc, argv, "pages", 10000);
+    long height = bench_arg(argc, argv, "height", 20);
+    FILE *out;
+
+    bench_seed((unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1);
+
+    if (n < 1 || n > 0x7FFFFFFF || pages < 1 || height < 1) {
+        fprintf(stderr, "-n, -pages and -height must be positive\n");
+        return 1;
+    }
+
+    if ((out = fopen("/dev/null", "w")) == NULL) {
+        fprintf(stderr, "Could not open /dev/null\n");
+        return 1;
+    }
+
+    printf("+----------+-----------+-----------+--------------+------------+------------------+\n");
+    printf("| %-8s | %9s | %9s | %12s | %10s | %16s |\n", "WORKLOAD", "ROWS", "OPS", "NS/OP", "MS", "CHECK");
+    printf("+----------+-----------+-----------+--------------+------------+------------------+\n");
+
+    if (run(n, pages, (int)height, out) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        fclose(out);
+        return 1;
+    }
+
+    printf("+----------+-----------+-----------+--------------+------------+------------------+\n");
+    fclose(out);
+
+    return 0;
+}
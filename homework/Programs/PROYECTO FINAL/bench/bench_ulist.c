@@ -0,0 +1,333 @@
+/*
+    bench_ulist.c
+    Scan and update speed of the unrolled list against List and a flat
+    array of pointers
+
+    Usage: bench_ulist [-n N] [-every K] [-seed S]
+    Each container is built with N appends (10^7 by default) and then:
+    scan        sum of every element, nodes in allocation order
+    scan_aged   the same after relinking the nodes in random order, as
+                in a heap that has been in use for a while
+    insert      one insertion after every K-th element during a scan
+                (array: copied into a new one, the way arrays grow)
+    remove      removal of every other element during a scan
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "ulist.h"
+#include "bench.h"
+
+typedef struct Array_ {
+    void **data;
+    long size;
+    long capacity;
+} Array;
+
+static void report (const char *operation, const char *container, long n, unsigned long long ns,
+                    unsigned long long check) {
+    printf("| %-10s | %-9s | %10ld | %8.2f | %9ld | %20llu |\n", operation, container, n,
+           (double)ns / n, bench_rss_kb(), check);
+}
+
+/*
+    Shuffle an array of n pointers
+*/
+static void shuffle (void **items, long n) {
+    void *swap;
+    long i, j;
+
+    for (i = n - 1; i > 0; i--) {
+        j = (long)(bench_random() % (unsigned long long)(i + 1));
+        swap = items[i];
+        items[i] = items[j];
+        items[j] = swap;
+    }
+}
+
+/*
+    List
+*/
+static unsigned long long list_scan (List *list) {
+    ListNode *node;
+    unsigned long long sum = 0;
+
+    for (node = list_head(list); node != NULL; node = list_next(node))
+        sum += (size_t)list_data(node);
+
+    return sum;
+}
+
+/*
+    Relink the nodes in random order, keeping each value in place
+*/
+static int list_age (List *list) {
+    ListNode **nodes, *node;
+    void **values;
+    long i, n = list_size(list);
+
+    nodes = (ListNode **)malloc(n * sizeof(ListNode *));
+    values = (void **)malloc(n * sizeof(void *));
+
+    if (nodes == NULL || values == NULL) {
+        free(nodes);
+        free(values);
+        return -1;
+    }
+
+    for (i = 0, node = list_head(list); node != NULL; node = list_next(node), i++) {
+        nodes[i] = node;
+        values[i] = node->data;
+    }
+
+    shuffle((void **)nodes, n);
+
+    for (i = 0; i < n; i++) {
+        nodes[i]->data = values[i];
+        nodes[i]->next = i + 1 < n ? nodes[i + 1] : NULL;
+    }
+
+    list->head = nodes[0];
+    list->tail = nodes[n - 1];
+
+    free(nodes);
+    free(values);
+
+    return 0;
+}
+
+static void run_list (long n, long every) {
+    List list;
+    ListNode *node;
+    unsigned long long start, check;
+    void *data;
+    long i;
+
+    list_init(&list, NULL);
+
+    start = bench_now();
+    for (i = 1; i <= n; i++)
+        list_ins_next(&list, list_tail(&list), (void *)i);
+    report("build", "List", n, bench_now() - start, list_size(&list));
+
+    start = bench_now();
+    check = list_scan(&list);
+    report("scan", "List", n, bench_now() - start, check);
+
+    if (list_age(&list) == 0) {
+        start = bench_now();
+        check = list_scan(&list);
+        report("scan_aged", "List", n, bench_now() - start, check);
+    }
+
+    start = bench_now();
+    for (i = 1, node = list_head(&list); node != NULL; node = list_next(node), i++) {
+        if (i % every == 0) {
+            list_ins_next(&list, node, (void *)0);
+            node = list_next(node);
+        }
+    }
+    report("insert", "List", n, bench_now() - start, list_size(&list));
+
+    start = bench_now();
+    for (node = list_head(&list); node != NULL && list_next(node) != NULL; node = list_next(node))
+        list_rem_next(&list, node, &data);
+    report("remove", "List", n, bench_now() - start, list_size(&list));
+
+    list_destroy(&list);
+}
+
+/*
+    UList
+*/
+static unsigned long long ulist_scan (UList *list) {
+    UListNode *node;
+    unsigned long long sum = 0;
+    void *data;
+    int i;
+
+    ulist_foreach(list, node, i, data)
+        sum += (size_t)data;
+
+    return sum;
+}
+
+/*
+    Move the node contents to the same blocks taken in random order
+*/
+static int ulist_age (UList *list) {
+    UListNode **blocks, *contents, *node;
+    long i, count = 0;
+
+    for (node = list->head; node != NULL; node = node->next)
+        count++;
+
+    blocks = (UListNode **)malloc(count * sizeof(UListNode *));
+    contents = (UListNode *)malloc(count * sizeof(UListNode));
+
+    if (blocks == NULL || contents == NULL) {
+        free(blocks);
+        free(contents);
+        return -1;
+    }
+
+    for (i = 0, node = list->head; node != NULL; node = node->next, i++) {
+        blocks[i] = node;
+        contents[i] = *node;
+    }
+
+    shuffle((void **)blocks, count);
+
+    for (i = 0; i < count; i++) {
+        *blocks[i] = contents[i];
+        blocks[i]->next = i + 1 < count ? blocks[i + 1] : NULL;
+    }
+
+    list->head = blocks[0];
+    list->tail = blocks[count - 1];
+
+    free(blocks);
+    free(contents);
+
+    return 0;
+}
+
+static void run_ulist (long n, long every) {
+    UList list;
+    UListPos pos;
+    unsigned long long start, check;
+    void *data;
+    long i;
+    int more;
+
+    ulist_init(&list, NULL);
+
+    start = bench_now();
+    for (i = 1; i <= n; i++) {
+        if (ulist_tail(&list, &pos) == 0)
+            ulist_ins_next(&list, &pos, (void *)i);
+        else
+            ulist_ins_next(&list, NULL, (void *)i);
+    }
+    report("build", "UList", n, bench_now() - start, ulist_size(&list));
+
+    start = bench_now();
+    check = ulist_scan(&list);
+    report("scan", "UList", n, bench_now() - start, check);
+
+    if (ulist_age(&list) == 0) {
+        start = bench_now();
+        check = ulist_scan(&list);
+        report("scan_aged", "UList", n, bench_now() - start, check);
+    }
+
+    start = bench_now();
+    for (i = 1, more = ulist_head(&list, &pos) == 0; more; more = ulist_next(&pos) == 0, i++) {
+        if (i % every == 0) {
+            ulist_ins_next(&list, &pos, (void *)0);
+
+            // Find the element again after a possible split, then skip the new one
+            if (pos.index >= pos.node->count) {
+                pos.index -= pos.node->count;
+                pos.node = pos.node->next;
+            }
+            ulist_next(&pos);
+        }
+    }
+    report("insert", "UList", n, bench_now() - start, ulist_size(&list));
+
+    start = bench_now();
+    for (more = ulist_head(&list, &pos) == 0; more; more = ulist_next(&pos) == 0) {
+        if (ulist_rem_next(&list, &pos, &data) != 0)
+            break;
+    }
+    report("remove", "UList", n, bench_now() - start, ulist_size(&list));
+
+    ulist_destroy(&list);
+}
+
+/*
+    Flat array
+*/
+static void run_array (long n, long every) {
+    Array array, grown;
+    unsigned long long start, check = 0;
+    void **data;
+    long i, j;
+
+    array.size = 0;
+    array.capacity = 16;
+    array.data = (void **)malloc(array.capacity * sizeof(void *));
+
+    start = bench_now();
+    for (i = 1; i <= n && array.data != NULL; i++) {
+        if (array.size == array.capacity) {
+            array.capacity *= 2;
+            if ((data = (void **)realloc(array.data, array.capacity * sizeof(void *))) == NULL)
+                break;
+            array.data = data;
+        }
+        array.data[array.size++] = (void *)i;
+    }
+    report("build", "array", n, bench_now() - start, array.size);
+
+    start = bench_now();
+    for (i = 0; i < array.size; i++)
+        check += (size_t)array.data[i];
+    report("scan", "array", n, bench_now() - start, check);
+
+    grown.capacity = array.size + array.size / every + 1;
+    grown.size = 0;
+
+    if ((grown.data = (void **)malloc(grown.capacity * sizeof(void *))) != NULL) {
+        start = bench_now();
+        for (i = 0; i < array.size; i++) {
+            grown.data[grown.size++] = array.data[i];
+            if ((i + 1) % every == 0)
+                grown.data[grown.size++] = (void *)0;
+        }
+        report("insert", "array", n, bench_now() - start, grown.size);
+
+        free(array.data);
+        array = grown;
+    }
+
+    start = bench_now();
+    for (i = 0, j = 0; i < array.size; i += 2)
+        array.data[j++] = array.data[i];
+    array.size = j;
+    report("remove", "array", n, bench_now() - start, array.size);
+
+    free(array.data);
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long n = bench_arg(argc, argv, "n", 10000000);
+    long every = bench_arg(argc, argv, "every", 16);
+
+    bench_seed((unsigned long long)bench_arg(argc, argv, "seed", 12345) | 1);
+
+    if (n < 2 || every < 1) {
+        fprintf(stderr, "Need -n of at least 2 and -every of at least 1\n");
+        return 1;
+    }
+
+    printf("+------------+-----------+------------+----------+-----------+----------------------+\n");
+    printf("| %-10s | %-9s | %10s | %8s | %9s | %20s |\n", "OPERATION", "CONTAINER", "ELEMENTS",
+           "NS/ELEM", "RSS KB", "CHECK");
+    printf("+------------+-----------+------------+----------+-----------+----------------------+\n");
+
+    run_array(n, every);
+    printf("+------------+-----------+------------+----------+-----------+----------------------+\n");
+    run_ulist(n, every);
+    printf("+------------+-----------+------------+----------+-----------+----------------------+\n");
+    run_list(n, every);
+    printf("+------------+-----------+------------+----------+-----------+----------------------+\n");
+
+    return 0;
+}
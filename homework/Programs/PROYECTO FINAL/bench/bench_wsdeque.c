@@ -0,0 +1,413 @@
+/*
+    bench_wsdeque.c
+    Stress test and throughput of the work-stealing deque against a
+    DList behind a mutex
+
+    Usage: bench_wsdeque [-ops N] [-min THREADS] [-max THREADS] [-depth D] [-rounds N]
+    Two workloads per thread count (1 .. 64 by default, doubling):
+    steal   one owner runs -ops random pushes and pops of unique values
+            while the other threads steal; every value must be taken
+            exactly once
+    tree    every thread owns a deque and evaluates a binary tree of
+            depth -depth, pushing both subtrees of each node and
+            stealing when its deque runs dry; every leaf must be counted
+            exactly once
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dlist.h"
+#include "wsdeque.h"
+#include "bench.h"
+
+/*
+    Deque under test, one per owner thread
+*/
+typedef struct Deque_ {
+    WSDeque wsdeque;
+
+    DList dlist;
+    pthread_mutex_t mutex;
+} Deque;
+
+typedef struct Subject_ {
+    const char *name;
+
+    int (*init) (Deque *deque);
+    void (*destroy) (Deque *deque);
+    int (*push) (Deque *deque, const void *data);
+    int (*pop) (Deque *deque, void **data);
+    int (*steal) (Deque *deque, void **data);
+} Subject;
+
+static int ws_case_init (Deque *deque) { return wsdeque_init(&deque->wsdeque, 64, NULL); }
+static void ws_case_destroy (Deque *deque) { wsdeque_destroy(&deque->wsdeque); }
+
+static int ws_case_push (Deque *deque, const void *data) {
+    return wsdeque_push(&deque->wsdeque, data);
+}
+
+static int ws_case_pop (Deque *deque, void **data) {
+    return wsdeque_pop(&deque->wsdeque, data);
+}
+
+static int ws_case_steal (Deque *deque, void **data) {
+    return wsdeque_steal(&deque->wsdeque, data);
+}
+
+static int mutex_case_init (Deque *deque) {
+    dlist_init(&deque->dlist, NULL);
+    return pthread_mutex_init(&deque->mutex, NULL) == 0 ? 0 : -1;
+}
+
+static void mutex_case_destroy (Deque *deque) {
+    dlist_destroy(&deque->dlist);
+    pthread_mutex_destroy(&deque->mutex);
+}
+
+static int mutex_case_push (Deque *deque, const void *data) {
+    int retval;
+
+    pthread_mutex_lock(&deque->mutex);
+    retval = dlist_ins_next(&deque->dlist, dlist_tail(&deque->dlist), data);
+    pthread_mutex_unlock(&deque->mutex);
+
+    return retval;
+}
+
+static int mutex_case_pop (Deque *deque, void **data) {
+    int retval;
+
+    pthread_mutex_lock(&deque->mutex);
+    retval = dlist_remove(&deque->dlist, dlist_tail(&deque->dlist), data);
+    pthread_mutex_unlock(&deque->mutex);
+
+    return retval;
+}
+
+static int mutex_case_steal (Deque *deque, void **data) {
+    int retval;
+
+    pthread_mutex_lock(&deque->mutex);
+    retval = dlist_remove(&deque->dlist, dlist_head(&deque->dlist), data);
+    pthread_mutex_unlock(&deque->mutex);
+
+    return retval;
+}
+
+/*
+    Shared state of one run
+*/
+typedef struct Run_ {
+    const Subject *subject;
+    Deque *deques;
+    int threads;
+    long ops;
+    int depth;
+
+    int start;
+    int done;
+    long pending;
+
+    /* steal: times every value was taken, indexed by value - 1 */
+    unsigned char *seen;
+} Run;
+
+/*
+    Per-thread state, padded so threads do not share cache lines
+*/
+typedef struct Worker_ {
+    Run *run;
+    int index;
+    pthread_t thread;
+
+    unsigned long long seed;
+    long leaves;
+    long steals;
+    long aborts;
+
+    char pad[64];
+} Worker;
+
+static unsigned long long next_random (Worker *worker) {
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 7;
+    worker->seed ^= worker->seed << 17;
+
+    return worker->seed;
+}
+
+static void wait_start (Run *run) {
+    while (!__atomic_load_n(&run->start, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+static void record_take (Run *run, void *data) {
+    __atomic_fetch_add(&run->seen[(size_t)data - 1], 1, __ATOMIC_RELAXED);
+}
+
+/*
+    steal: thread 0 owns the only deque, pushes slightly more likely
+*/
+static void *steal_main (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    const Subject *subject = run->subject;
+    Deque *deque = &run->deques[0];
+    void *data;
+    long i, value = 0;
+    int retval;
+
+    wait_start(run);
+
+    if (worker->index == 0) {
+        for (i = 0; i < run->ops; i++) {
+            if (next_random(worker) % 8 < 5) {
+                if (subject->push(deque, (void *)(++value)) != 0)
+                    fprintf(stderr, "%s: out of memory\n", subject->name);
+            } else if (subject->pop(deque, &data) == 0) {
+                record_take(run, data);
+            }
+        }
+
+        __atomic_store_n(&run->pending, value, __ATOMIC_RELEASE);
+        __atomic_store_n(&run->done, 1, __ATOMIC_RELEASE);
+
+        return NULL;
+    }
+
+    while (1) {
+        if ((retval = subject->steal(deque, &data)) == 0) {
+            record_take(run, data);
+            worker->steals++;
+        } else if (retval == WSDEQUE_ABORT) {
+            worker->aborts++;
+        } else if (__atomic_load_n(&run->done, __ATOMIC_ACQUIRE)) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    tree: a task is the depth of its subtree plus one
+*/
+static void run_task (Worker *worker, Deque *deque, long depth) {
+    Run *run = worker->run;
+
+    if (depth == 0) {
+        worker->leaves++;
+    } else {
+        __atomic_fetch_add(&run->pending, 2, __ATOMIC_RELAXED);
+
+        if (run->subject->push(deque, (void *)depth) != 0
+            || run->subject->push(deque, (void *)depth) != 0)
+            fprintf(stderr, "%s: out of memory\n", run->subject->name);
+    }
+
+    __atomic_fetch_sub(&run->pending, 1, __ATOMIC_RELEASE);
+
+    return;
+}
+
+static void *tree_main (void *arg) {
+    Worker *worker = (Worker *)arg;
+    Run *run = worker->run;
+    const Subject *subject = run->subject;
+    Deque *own = &run->deques[worker->index];
+    void *data;
+    int victim, retval;
+
+    wait_start(run);
+
+    while (__atomic_load_n(&run->pending, __ATOMIC_ACQUIRE) > 0) {
+        if (subject->pop(own, &data) == 0) {
+            run_task(worker, own, (long)data - 1);
+            continue;
+        }
+
+        if (run->threads == 1)
+            continue;
+
+        victim = (int)(next_random(worker) % (unsigned)(run->threads - 1));
+        victim += victim >= worker->index;
+
+        if ((retval = subject->steal(&run->deques[victim], &data)) == 0) {
+            worker->steals++;
+            run_task(worker, own, (long)data - 1);
+        } else {
+            if (retval == WSDEQUE_ABORT)
+                worker->aborts++;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    One run, returns the number of values or leaves not taken exactly once
+*/
+static long run_subject (const Subject *subject, int tree, long ops, int depth, int threads,
+                         unsigned long long *ns, long *steals, long *aborts) {
+    Run run;
+    Worker *workers;
+    unsigned long long start;
+    void *data;
+    long i, leaves = 0, bad = 0;
+
+    memset(&run, 0, sizeof(Run));
+    run.subject = subject;
+    run.threads = threads;
+    run.ops = ops;
+    run.depth = depth;
+
+    workers = (Worker *)calloc(threads, sizeof(Worker));
+    run.deques = (Deque *)calloc(threads, sizeof(Deque));
+    run.seen = (unsigned char *)calloc(tree ? 1 : (size_t)ops, 1);
+
+    if (workers == NULL || run.deques == NULL || run.seen == NULL) {
+        free(workers);
+        free(run.deques);
+        free(run.seen);
+        return -1;
+    }
+
+    for (i = 0; i < threads; i++) {
+        if (subject->init(&run.deques[i]) != 0)
+            return -1;
+    }
+
+    // The root goes to the first deque before any thread starts
+    if (tree) {
+        run.pending = 1;
+        subject->push(&run.deques[0], (void *)((long)depth + 1));
+    }
+
+    for (i = 0; i < threads; i++) {
+        workers[i].run = &run;
+        workers[i].index = (int)i;
+        workers[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&workers[i].thread, NULL, tree ? tree_main : steal_main, &workers[i]);
+    }
+
+    start = bench_now();
+    __atomic_store_n(&run.start, 1, __ATOMIC_RELEASE);
+
+    for (i = 0; i < threads; i++)
+        pthread_join(workers[i].thread, NULL);
+
+    *ns = bench_now() - start;
+    *steals = 0;
+    *aborts = 0;
+
+    for (i = 0; i < threads; i++) {
+        *steals += workers[i].steals;
+        *aborts += workers[i].aborts;
+        leaves += workers[i].leaves;
+    }
+
+    if (tree) {
+        bad = labs(leaves - (1L << depth));
+    } else {
+        // Drain as the owner and check
+        while (subject->pop(&run.deques[0], &data) == 0)
+            record_take(&run, data);
+
+        for (i = 0; i < run.pending; i++)
+            bad += run.seen[i] != 1;
+    }
+
+    for (i = 0; i < threads; i++)
+        subject->destroy(&run.deques[i]);
+
+    free(run.seen);
+    free(run.deques);
+    free(workers);
+
+    return bad;
+}
+
+/*
+    Main
+*/
+int main (int argc, char **argv) {
+    long ops = bench_arg(argc, argv, "ops", 1000000);
+    int min = (int)bench_arg(argc, argv, "min", 1);
+    int max = (int)bench_arg(argc, argv, "max", 64);
+    int depth = (int)bench_arg(argc, argv, "depth", 20);
+    int rounds = (int)bench_arg(argc, argv, "rounds", 1);
+    const char *workloads[2] = { "steal", "tree" };
+    Subject subjects[2];
+    unsigned long long ns, total;
+    long bad, steals, aborts, steals_total, aborts_total, units;
+    int threads, w, s, r, failed = 0;
+
+    if (depth < 1 || depth > 30) {
+        fprintf(stderr, "-depth must be between 1 and 30\n");
+        return 1;
+    }
+
+    subjects[0].name = "wsdeque";
+    subjects[0].init = ws_case_init;
+    subjects[0].destroy = ws_case_destroy;
+    subjects[0].push = ws_case_push;
+    subjects[0].pop = ws_case_pop;
+    subjects[0].steal = ws_case_steal;
+
+    subjects[1].name = "dlist+mutex";
+    subjects[1].init = mutex_case_init;
+    subjects[1].destroy = mutex_case_destroy;
+    subjects[1].push = mutex_case_push;
+    subjects[1].pop = mutex_case_pop;
+    subjects[1].steal = mutex_case_steal;
+
+    printf("+----------+--------------+---------+----------+-----------+-----------+-------+\n");
+    printf("| %-8s | %-12s | %7s | %8s | %9s | %9s | %5s |\n", "WORKLOAD", "DEQUE", "THREADS",
+           "NS/OP", "STEALS", "ABORTS", "CHECK");
+    printf("+----------+--------------+---------+----------+-----------+-----------+-------+\n");
+
+    for (w = 0; w < 2; w++) {
+        // Operations of one round: owner calls, or tree nodes
+        units = w == 0 ? ops : (2L << depth) - 1;
+
+        for (threads = min; threads <= max; threads *= 2) {
+            for (s = 0; s < 2; s++) {
+                total = 0;
+                steals_total = 0;
+                aborts_total = 0;
+                bad = 0;
+
+                for (r = 0; r < rounds && bad == 0; r++) {
+                    if ((bad = run_subject(&subjects[s], w, ops, depth, threads, &ns, &steals,
+                                           &aborts)) < 0) {
+                        fprintf(stderr, "Out of memory\n");
+                        return 1;
+                    }
+
+                    total += ns;
+                    steals_total += steals;
+                    aborts_total += aborts;
+                }
+
+                printf("| %-8s | %-12s | %7d | %8.1f | %9ld | %9ld | %5s |\n", workloads[w],
+                       subjects[s].name, threads, (double)total / ((double)units * r),
+                       steals_total / r, aborts_total / r, bad == 0 ? "OK" : "LOST");
+
+                failed |= bad != 0;
+            }
+        }
+    }
+
+    printf("+----------+--------------+---------+----------+-----------+-----------+-------+\n");
+
+    return failed;
+}
@@ -0,0 +1,151 @@
+/*
+    exprgen.c
+    Random valid infix expressions for the benchmarks and the fuzzer
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "exprgen.h"
+
+/*
+    Output being built, never grows past capacity - 1
+*/
+typedef struct Output_ {
+    char *text;
+    int size;
+    int capacity;
+} Output;
+
+static void put (Output *out, char c) {
+    if (out->size < out->capacity - 1)
+        out->text[out->size++] = c;
+}
+
+/*
+    Initialize the generator with the default mix
+*/
+void exprgen_init (ExprGen *gen, int size, int letters, unsigned long long seed) {
+    gen->size = size;
+    gen->max_depth = 4;
+    gen->paren_percent = 15;
+    gen->operators = "+-*/^";
+    gen->chain_percent = 50;
+    gen->min_digits = 1;
+    gen->max_digits = 3;
+    gen->letters = letters;
+    gen->seed = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+/*
+    Random number in [0, bound), xorshift64*
+*/
+unsigned int exprgen_random (ExprGen *gen, unsigned int bound) {
+    gen->seed ^= gen->seed >> 12;
+    gen->seed ^= gen->seed << 25;
+    gen->seed ^= gen->seed >> 27;
+
+    if (bound == 0)
+        return 0;
+
+    return (unsigned int)((gen->seed * 0x2545F4914F6CDD1DULL) >> 33) % bound;
+}
+
+/*
+    Plain operand, at most budget characters
+    Divisors never start with 0. Exponents are a single digit 0-2, so
+    chains like 2^2^2^2 stay cheap in the integer power() loops
+*/
+static void gen_value (ExprGen *gen, Output *out, int budget, char after) {
+    int digits, i;
+
+    if (gen->letters) {
+        put(out, (char)('a' + exprgen_random(gen, 26)));
+        return;
+    }
+
+    if (after == '^') {
+        put(out, (char)('0' + exprgen_random(gen, 3)));
+        return;
+    }
+
+    digits = gen->min_digits + (int)exprgen_random(gen, gen->max_digits - gen->min_digits + 1);
+
+    if (digits > budget)
+        digits = budget > 0 ? budget : 1;
+
+    for (i = 0; i < digits; i++) {
+        if (i == 0 && (after == '/' || digits > 1))
+            put(out, (char)('1' + exprgen_random(gen, 9)));
+        else
+            put(out, (char)('0' + exprgen_random(gen, 10)));
+    }
+}
+
+static void gen_expr (ExprGen *gen, Output *out, int depth, int budget);
+
+/*
+    Operand: a value or a parenthesized subexpression
+*/
+static void gen_operand (ExprGen *gen, Output *out, int depth, int budget, char after) {
+    int inner;
+
+    if (after != '/' && after != '^' && depth < gen->max_depth && budget >= 5 &&
+        (int)exprgen_random(gen, 100) < gen->paren_percent) {
+        inner = 3 + (int)exprgen_random(gen, budget - 4);
+
+        put(out, '(');
+        gen_expr(gen, out, depth + 1, inner);
+        put(out, ')');
+        return;
+    }
+
+    gen_value(gen, out, budget, after);
+}
+
+/*
+    Expression of roughly budget characters with at least one operator
+*/
+static void gen_expr (ExprGen *gen, Output *out, int depth, int budget) {
+    int start = out->size;
+    int ops = (int)strlen(gen->operators);
+    char op;
+
+    gen_operand(gen, out, depth, budget / 4 > 1 ? budget / 4 : 1, '\0');
+
+    while (out->size - start + 2 <= budget && out->size < out->capacity - 3) {
+        op = gen->operators[exprgen_random(gen, ops)];
+
+        put(out, op);
+        gen_operand(gen, out, depth, budget - (out->size - start), op);
+
+        // Right-associative chains: a^b^c^d
+        while (op == '^' && out->size - start + 2 <= budget &&
+               (int)exprgen_random(gen, 100) < gen->chain_percent) {
+            put(out, '^');
+            gen_value(gen, out, 1, '^');
+        }
+
+        if (depth > 0 && exprgen_random(gen, 3) == 0)
+            break;
+    }
+}
+
+/*
+    Write a random valid expression of about gen->size characters
+    Returns its length
+*/
+int exprgen_generate (ExprGen *gen, char *expr, int capacity) {
+    Output out;
+
+    out.text = expr;
+    out.size = 0;
+    out.capacity = capacity;
+
+    if (capacity < 4)
+        return -1;
+
+    gen_expr(gen, &out, 0, gen->size < 3 ? 3 : gen->size);
+    out.text[out.size] = '\0';
+
+    return out.size;
+}
@@ -0,0 +1,30 @@
+/*
+    exprgen.h
+*/
+#ifndef EXPRGEN_H
+#define EXPRGEN_H
+
+/*
+    Settings of the random expression generator
+*/
+typedef struct ExprGen_ {
+    int size;               /* target length in characters */
+    int max_depth;          /* maximum parenthesis nesting */
+    int paren_percent;      /* chance of an operand being a subexpression */
+    const char *operators;  /* operator mix, repeat a character to weight it */
+    int chain_percent;      /* chance of extending a ^ chain (a^b^c...) */
+    int min_digits;
+    int max_digits;
+    int letters;            /* 1 = single letter operands, 0 = numbers */
+
+    unsigned long long seed;
+} ExprGen;
+
+/*
+    Public Interfaces
+*/
+void exprgen_init (ExprGen *gen, int size, int letters, unsigned long long seed);
+int exprgen_generate (ExprGen *gen, char *expr, int capacity);
+unsigned int exprgen_random (ExprGen *gen, unsigned int bound);
+
+#endif
@@ -9,6 +9,15 @@ gcc -c source\list.c -Iinclude -o list.o
 gcc -c source\dlist.c -Iinclude -o dlist.o
 gcc -c source\stack.c -Iinclude -o stack.o
 gcc -c source\queue.c -Iinclude -o queue.o
+gcc -c source\stats.c -Iinclude -o stats.o
+gcc -c source\trace.c -Iinclude -o trace.o
+gcc -c source\expr.c -Iinclude -o expr.o
+gcc -c source\spsc_ring.c -Iinclude -o spsc_ring.o
+gcc -c source\steptrace.c -Iinclude -o steptrace.o
+gcc -c source\pstack.c -Iinclude -o pstack.o
+gcc -c source\stepcode.c -Iinclude -o stepcode.o
+gcc -c source\stepview.c -Iinclude -o stepview.o
+gcc -c source\oplog.c -Iinclude -o oplog.o
 
 echo.
 echo [2] Compiling main modules...
@@ -16,25 +25,29 @@ echo.
 
 echo  2.1 PRE-LETTERS...
 gcc -c main\PRE-LETTERS.c -Iinclude -o PRE-LETTERS.o
-gcc PRE-LETTERS.o list.o dlist.o stack.o -o PRE-LETTERS.exe -lm
+gcc PRE-LETTERS.o list.o dlist.o stack.o stats.o trace.o -o PRE-LETTERS.exe -lm
 
 echo  2.2 Infix...
 gcc -c main\Infix.c -Iinclude -o Infix.o
-gcc Infix.o list.o dlist.o stack.o queue.o -o Infix.exe -lm
+gcc Infix.o list.o dlist.o stack.o steptrace.o stepcode.o stepview.o oplog.o stats.o trace.o -o Infix.exe -lm
 
 echo  2.3 POSTFIX-LETTERS...
 gcc -c main\POSTFIX-LETTERS.c -Iinclude -o POSTFIX-LETTERS.o
-gcc POSTFIX-LETTERS.o list.o dlist.o stack.o -o POSTFIX-LETTERS.exe -lm
+gcc POSTFIX-LETTERS.o list.o dlist.o stack.o stats.o trace.o -o POSTFIX-LETTERS.exe -lm
 
 echo  2.4 PRE-NUM...
 gcc -c main\PRE-NUM.c -Iinclude -o PRE-NUM.o
-gcc PRE-NUM.o list.o dlist.o stack.o -o PRE-NUM.exe -lm
+gcc PRE-NUM.o list.o dlist.o stack.o stats.o trace.o -o PRE-NUM.exe -lm
 
 echo  2.5 POST-NUM...
 gcc -c main\POST-NUM.c -Iinclude -o POST-NUM.o
-gcc POST-NUM.o list.o dlist.o stack.o -o POST-NUM.exe -lm
+gcc POST-NUM.o list.o dlist.o stack.o pstack.o stats.o trace.o -o POST-NUM.exe -lm
 
-echo  2.6 MainCalculator...
+echo  2.6 Batch...
+gcc -c main\Batch.c -Iinclude -o Batch.o
+gcc Batch.o expr.o spsc_ring.o stats.o trace.o -o Batch.exe -lm -pthread
+
+echo  2.7 MainCalculator...
 gcc main\MainCalculator.c -o MainCalculator.exe
 
 echo.
@@ -49,6 +62,7 @@ echo   Infix.exe             - Infix evaluator
 echo   POSTFIX-LETTERS.exe   - Postfix with letters
 echo   PRE-NUM.exe           - Prefix with numbers
 echo   POST-NUM.exe          - Postfix with numbers
+echo   Batch.exe             - Pipelined batch evaluator
 echo.
 echo To run the program: MainCalculator
 echo.
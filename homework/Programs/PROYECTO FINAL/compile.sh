@@ -82,6 +82,60 @@ if [ $? -ne 0 ]; then
     exit 1
 fi
 
+gcc -c lib/stats.c -Iinclude -Wall -Wextra -o stats.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando stats.c"
+    exit 1
+fi
+
+gcc -c lib/trace.c -Iinclude -Wall -Wextra -o trace.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando trace.c"
+    exit 1
+fi
+
+gcc -c lib/expr.c -Iinclude -Wall -Wextra -o expr.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando expr.c"
+    exit 1
+fi
+
+gcc -c lib/spsc_ring.c -Iinclude -Wall -Wextra -o spsc_ring.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando spsc_ring.c"
+    exit 1
+fi
+
+gcc -c lib/steptrace.c -Iinclude -Wall -Wextra -o steptrace.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando steptrace.c"
+    exit 1
+fi
+
+gcc -c lib/pstack.c -Iinclude -Wall -Wextra -o pstack.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando pstack.c"
+    exit 1
+fi
+
+gcc -c lib/stepcode.c -Iinclude -Wall -Wextra -o stepcode.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando stepcode.c"
+    exit 1
+fi
+
+gcc -c lib/stepview.c -Iinclude -Wall -Wextra -o stepview.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando stepview.c"
+    exit 1
+fi
+
+gcc -c lib/oplog.c -Iinclude -Wall -Wextra -o oplog.o
+if [ $? -ne 0 ]; then
+    print_error "Error compilando oplog.c"
+    exit 1
+fi
+
 print_message "Estructuras de datos compiladas exitosamente"
 echo ""
 
@@ -100,7 +154,7 @@ fi
 
 # 2. PRE-LETTERS
 print_warning "Compilando PRE-LETTERS..."
-gcc src/PRE-LETTERS.c list.o dlist.o stack.o -Iinclude -o bin/PRE-LETTERS -lm -Wall -Wextra
+gcc src/PRE-LETTERS.c list.o dlist.o stack.o stats.o trace.o -Iinclude -o bin/PRE-LETTERS -lm -Wall -Wextra
 if [ $? -ne 0 ]; then
     print_error "Error compilando PRE-LETTERS"
     exit 1
@@ -108,7 +162,7 @@ fi
 
 # 3. Infix
 print_warning "Compilando Infix..."
-gcc src/Infix.c list.o dlist.o stack.o queue.o -Iinclude -o bin/Infix -lm -Wall -Wextra
+gcc src/Infix.c list.o dlist.o stack.o steptrace.o stepcode.o stepview.o oplog.o stats.o trace.o -Iinclude -o bin/Infix -lm -Wall -Wextra
 if [ $? -ne 0 ]; then
     print_error "Error compilando Infix"
     exit 1
@@ -116,7 +170,7 @@ fi
 
 # 4. POSTFIX-LETTERS
 print_warning "Compilando POSTFIX-LETTERS..."
-gcc src/POSTFIX-LETTERS.c list.o dlist.o stack.o -Iinclude -o bin/POSTFIX-LETTERS -lm -Wall -Wextra
+gcc src/POSTFIX-LETTERS.c list.o dlist.o stack.o stats.o trace.o -Iinclude -o bin/POSTFIX-LETTERS -lm -Wall -Wextra
 if [ $? -ne 0 ]; then
     print_error "Error compilando POSTFIX-LETTERS"
     exit 1
@@ -124,7 +178,7 @@ fi
 
 # 5. PRE-NUM
 print_warning "Compilando PRE-NUM..."
-gcc src/PRE-NUM.c list.o dlist.o stack.o -Iinclude -o bin/PRE-NUM -lm -Wall -Wextra
+gcc src/PRE-NUM.c list.o dlist.o stack.o stats.o trace.o -Iinclude -o bin/PRE-NUM -lm -Wall -Wextra
 if [ $? -ne 0 ]; then
     print_error "Error compilando PRE-NUM"
     exit 1
@@ -132,12 +186,20 @@ fi
 
 # 6. POST-NUM
 print_warning "Compilando POST-NUM..."
-gcc src/POST-NUM.c list.o dlist.o stack.o -Iinclude -o bin/POST-NUM -lm -Wall -Wextra
+gcc src/POST-NUM.c list.o dlist.o stack.o pstack.o stats.o trace.o -Iinclude -o bin/POST-NUM -lm -Wall -Wextra
 if [ $? -ne 0 ]; then
     print_error "Error compilando POST-NUM"
     exit 1
 fi
 
+# 7. Batch
+print_warning "Compilando Batch..."
+gcc src/Batch.c expr.o spsc_ring.o stats.o trace.o -Iinclude -o bin/Batch -lm -pthread -Wall -Wextra
+if [ $? -ne 0 ]; then
+    print_error "Error compilando Batch"
+    exit 1
+fi
+
 # Limpiar archivos objeto
 rm -f *.o
 
@@ -180,6 +242,7 @@ echo "     ${BLUE}./bin/PRE-LETTERS${NC}  # Prefijo con letras"
 echo "     ${BLUE}./bin/POSTFIX-LETTERS${NC} # Postfijo con letras"
 echo "     ${BLUE}./bin/PRE-NUM${NC}      # Prefijo con números"
 echo "     ${BLUE}./bin/POST-NUM${NC}     # Postfijo con números"
+echo "     ${BLUE}./bin/Batch${NC} entrada.txt  # Evaluador por lotes (una expresión por línea)"
 echo ""
 echo "  3. Para recompilar:"
 echo "     ${BLUE}./compile.sh${NC}"
@@ -0,0 +1,65 @@
+/*
+    bqueue.h
+*/
+#ifndef BQUEUE_H
+#define BQUEUE_H
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "queue.h"
+
+/*
+    Struct for the blocking queue, a Queue behind a mutex
+    capacity bounds the queue, 0 for unbounded. Threads only sleep on a
+    condition variable and are only signaled when someone is waiting.
+    The batch calls move many elements under one lock with a single
+    wakeup, a consumer in dequeue_many wakes once per batch and leaves
+    the rest for the next waiting consumer.
+    Once closed, enqueues fail and dequeues drain what is left
+*/
+typedef struct BQueue_ {
+    Queue queue;
+    int capacity;
+    int closed;
+
+    int waiting_consumers;
+    int waiting_producers;
+
+    /* Times a consumer or producer went to sleep */
+    unsigned long long consumer_waits;
+    unsigned long long producer_waits;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} BQueue;
+
+/*
+    Public Interfaces
+    timeout_ms: -1 waits forever, 0 does not wait
+    enqueue and dequeue return 0, BQUEUE_TIMEOUT, or -1 when closed
+    (dequeue: closed and drained). The batch calls return the number
+    of elements moved, 0 on timeout, or -1 when closed
+*/
+int bqueue_init (BQueue *bqueue, int capacity, void (*destroy)(void *data));
+void bqueue_destroy (BQueue *bqueue);
+
+int bqueue_enqueue (BQueue *bqueue, const void *data, long timeout_ms);
+int bqueue_dequeue (BQueue *bqueue, void **data, long timeout_ms);
+
+int bqueue_enqueue_many (BQueue *bqueue, void **items, int count, long timeout_ms);
+int bqueue_dequeue_many (BQueue *bqueue, void **items, int max, long timeout_ms);
+
+void bqueue_close (BQueue *bqueue);
+int bqueue_size (BQueue *bqueue);
+
+/*
+    Macros
+*/
+#define BQUEUE_TIMEOUT 1
+
+#define bqueue_capacity(bqueue) ((bqueue)->capacity)
+#define bqueue_is_closed(bqueue) __atomic_load_n(&(bqueue)->closed, __ATOMIC_ACQUIRE)
+
+#endif
@@ -0,0 +1,83 @@
+/*
+    clist.h
+*/
+#ifndef CLIST_H
+#define CLIST_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+    Handle of a node, its index in the node array
+*/
+typedef uint32_t CListHandle;
+
+#define CLIST_NIL ((CListHandle)0xFFFFFFFF)
+
+/*
+    Node header, followed in the array by a copy of the element
+*/
+typedef struct CListLink_ {
+    CListHandle prev;
+    CListHandle next;
+} CListLink;
+
+/*
+    Struct for the compact doubly linked list
+    Nodes live in one growable array and link by 32-bit handles, so the
+    list holds no pointers: it can be moved, saved and loaded with a
+    single memcpy. Removed nodes go to a free list threaded through next
+    and are reused before the array grows. Elements are stored by value,
+    elem_size bytes each
+*/
+typedef struct CList_ {
+    int size;
+
+    size_t elem_size;
+    size_t stride;
+
+    CListHandle head;
+    CListHandle tail;
+    CListHandle free;
+
+    /* Nodes in use or freed, and nodes allocated */
+    uint32_t used;
+    uint32_t capacity;
+
+    unsigned char *nodes;
+} CList;
+
+/*
+    Public Interfaces
+    Same rules as dlist.h: CLIST_NIL inserts only into an empty list.
+    The new node's handle is stored in handle when it is not NULL, and
+    clist_remove copies the element to data when it is not NULL
+*/
+int clist_init (CList *list, size_t elem_size, uint32_t capacity);
+void clist_destroy (CList *list);
+
+int clist_ins_next (CList *list, CListHandle node, const void *data, CListHandle *handle);
+int clist_ins_prev (CList *list, CListHandle node, const void *data, CListHandle *handle);
+int clist_remove (CList *list, CListHandle node, void *data);
+
+size_t clist_image_size (const CList *list);
+void clist_save (const CList *list, void *image);
+int clist_load (CList *list, const void *image, size_t bytes);
+
+/*
+    Macros
+*/
+#define clist_link(list, node) ((CListLink *)((list)->nodes + (size_t)(node) * (list)->stride))
+
+#define clist_size(list) ((list)->size)
+#define clist_head(list) ((list)->head)
+#define clist_tail(list) ((list)->tail)
+
+#define clist_is_head(list, node) (clist_link((list), (node))->prev == CLIST_NIL ? 1 : 0)
+#define clist_is_tail(list, node) (clist_link((list), (node))->next == CLIST_NIL ? 1 : 0)
+
+#define clist_data(list, node) ((void *)(clist_link((list), (node)) + 1))
+#define clist_next(list, node) (clist_link((list), (node))->next)
+#define clist_prev(list, node) (clist_link((list), (node))->prev)
+
+#endif
@@ -6,13 +6,19 @@
 
 #include <stdlib.h>
 
+#define DLIST_CACHE_LINE 64
+
 /*
     Doubled linked list node
+    Nodes made by dlist_ins_next_copy carry their element in payload,
+    the node and the copy share one cache-line aligned block
 */
 typedef struct DListNode_ {
     void *data;
     struct DListNode_ *next;
     struct DListNode_ *prev;
+
+    char payload[];
 } DListNode;
 
 /*
@@ -37,6 +43,26 @@ int dlist_ins_next (DList *list, DListNode *node, const void *data);
 int dlist_ins_prev (DList *list, DListNode *node, const void *data);
 int dlist_remove (DList *list, DListNode *node, void **data);
 
+int dlist_ins_next_copy (DList *list, DListNode *node, const void *data, size_t size);
+int dlist_remove_copy (DList *list, DListNode *node, void *data, size_t size);
+
+/*
+    Same as list_spare_release, for the dlist nodes
+*/
+void dlist_spare_release (void);
+
+/*
+    Bulk operations, none of them allocates
+    Same as the list.h ones: stable merge sorts, and dlist_splice puts
+    other after node, or at the head when node is NULL
+*/
+void dlist_sort (DList *list, int (*compare)(const void *key1, const void *key2));
+void dlist_sort_bottom_up (DList *list, int (*compare)(const void *key1, const void *key2));
+
+void dlist_splice (DList *list, DListNode *node, DList *other);
+void dlist_concat (DList *list, DList *other);
+void dlist_reverse (DList *list);
+
 /*
     Macros
 */
@@ -51,5 +77,8 @@ int dlist_remove (DList *list, DListNode *node, void **data);
 #define dlist_next(node) ((node)->next)
 #define dlist_prev(node) ((node)->prev)
 
+#define DLIST_INLINE_MAX (DLIST_CACHE_LINE - sizeof(DListNode))
+#define dlist_is_inline(node) ((node)->data == (void *)(node)->payload ? 1 : 0)
+
 #endif
     
\ No newline at end of file
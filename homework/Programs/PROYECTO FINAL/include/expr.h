@@ -0,0 +1,57 @@
+/*
+    expr.h
+*/
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <stdlib.h>
+
+/*
+    Token of an infix expression
+    type: 'N' number, 'O' binary operator, 'U' unary sign, 'P' parenthesis
+*/
+typedef struct ExprToken_ {
+    char type;
+    char op;
+    double value;
+} ExprToken;
+
+/*
+    State of a tokenizer fed one piece of text at a time, so text kept
+    in chunks (a rope) is tokenized without being copied out. A number
+    may be split across pieces
+*/
+typedef struct ExprTokenizer_ {
+    ExprToken *tokens;
+    int capacity;
+    int count;
+
+    int expect_operand;
+    int error;
+
+    int in_number;
+    int number_length;
+    char number[64];
+} ExprTokenizer;
+
+/*
+    Public Interfaces
+    Quiet counterparts of the Infix engine's tokenize, validate_syntax
+    and evaluate_expression, for batch processing. Same grammar: numbers
+    with an optional decimal point, + - * / ^ (^ right associative),
+    parentheses and a leading sign on an operand
+*/
+int expr_tokenize (const char *text, ExprToken *tokens, int capacity);
+int expr_validate (const ExprToken *tokens, int count);
+int expr_evaluate (const ExprToken *tokens, int count, double *result);
+
+/*
+    expr_tokenize in pieces: feed returns -1 once the text so far is
+    invalid or the tokens are full, finish returns the number of tokens
+    or -1
+*/
+void expr_tokenizer_init (ExprTokenizer *tokenizer, ExprToken *tokens, int capacity);
+int expr_tokenizer_feed (ExprTokenizer *tokenizer, const char *text, size_t length);
+int expr_tokenizer_finish (ExprTokenizer *tokenizer);
+
+#endif
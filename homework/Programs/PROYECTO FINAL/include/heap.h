@@ -0,0 +1,66 @@
+/*
+    heap.h
+*/
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdlib.h>
+
+/*
+    Heap slot, the element and the handle that finds it
+*/
+typedef struct HeapEntry_ {
+    void *data;
+    int handle;
+} HeapEntry;
+
+/*
+    Struct for the d-ary heap
+    Every node has arity children, tree[i * arity + 1 ..]; a wider node
+    makes the heap shallower and its children share cache lines.
+    where[handle] is the slot of the element inserted with that handle,
+    handles of removed elements are chained from free_handle through
+    where and used again
+*/
+typedef struct Heap_ {
+    int size;
+    int arity;
+    int capacity;
+
+    int (*compare) (const void *key1, const void *key2);
+    void (*destroy) (void *data);
+
+    HeapEntry *tree;
+    int *where;
+    int handles;
+    int free_handle;
+} Heap;
+
+/*
+    Public Interfaces
+    As Loudon's heap: the top is the element that compares greatest,
+    compare returns > 0 when key1 goes before key2. heap_insert gives
+    the element's handle in *handle when it is not NULL; after changing
+    the priority of an element, heap_update moves it to its place, in
+    either direction. heap_build adds count elements at once and
+    restores the heap in O(n), their handles go to handles when it is
+    not NULL
+*/
+int heap_init (Heap *heap, int arity, int (*compare)(const void *key1, const void *key2),
+               void (*destroy)(void *data));
+void heap_destroy (Heap *heap);
+
+int heap_insert (Heap *heap, const void *data, int *handle);
+int heap_extract (Heap *heap, void **data);
+int heap_update (Heap *heap, int handle);
+int heap_remove (Heap *heap, int handle, void **data);
+int heap_build (Heap *heap, void **data, int count, int *handles);
+
+/*
+    Macros
+*/
+#define heap_size(heap) ((heap)->size)
+#define heap_peek(heap) ((heap)->size == 0 ? NULL : (heap)->tree[0].data)
+#define heap_data(heap, handle) ((heap)->tree[(heap)->where[(handle)]].data)
+
+#endif
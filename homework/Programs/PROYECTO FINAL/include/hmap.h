@@ -0,0 +1,67 @@
+/*
+    hmap.h
+*/
+#ifndef HMAP_H
+#define HMAP_H
+
+#include <stdlib.h>
+
+/*
+    Slots scanned together, one SSE2 register of control bytes
+*/
+#define HMAP_GROUP 16
+
+/*
+    Struct for the open-addressed hash map
+    One control byte per slot: HMAP_EMPTY, HMAP_DELETED, or for a used
+    slot 7 bits of the hash of its element. A lookup compares a whole
+    group of control bytes at once and only calls match on the slots
+    whose 7 bits agree. ctrl has HMAP_GROUP more bytes than slots, a
+    copy of the first ones, so a group never wraps around
+*/
+typedef struct HMap_ {
+    int capacity;
+    int size;
+    int growth_left;
+
+    size_t (*hash) (const void *key);
+    int (*match) (const void *key1, const void *key2);
+    void (*destroy) (void *data);
+
+    signed char *ctrl;
+    void **slots;
+} HMap;
+
+/*
+    Public Interfaces
+    As Loudon's ohtbl: the element is its own key, hash and match see
+    the element. hmap_insert returns 1 when a matching element is
+    already in, hmap_lookup and hmap_remove take the key in *data and
+    return the element found there, -1 when there is none. hmap_next
+    walks the elements from *position = 0 until it returns -1
+*/
+int hmap_init (HMap *map, int capacity, size_t (*hash)(const void *key),
+               int (*match)(const void *key1, const void *key2), void (*destroy)(void *data));
+void hmap_destroy (HMap *map);
+
+int hmap_insert (HMap *map, const void *data);
+int hmap_remove (HMap *map, void **data);
+int hmap_lookup (const HMap *map, void **data);
+int hmap_next (const HMap *map, int *position, void **data);
+
+/*
+    For elements that start with a NUL terminated name, a char array
+    first member or the string itself
+*/
+size_t hmap_hash_string (const void *key);
+int hmap_match_string (const void *key1, const void *key2);
+
+/*
+    Macros
+*/
+#define HMAP_EMPTY ((signed char)-128)
+#define HMAP_DELETED ((signed char)-2)
+
+#define hmap_size(map) ((map)->size)
+
+#endif
@@ -0,0 +1,101 @@
+/*
+    ilist.h
+*/
+#ifndef ILIST_H
+#define ILIST_H
+
+#include <stdlib.h>
+#include <stddef.h>
+
+/*
+    Intrusive links, embedded in the element instead of pointing to it
+    The lists never allocate: inserting links the element's own ILink or
+    IDLink, and ilist_entry gets the element back from its link
+*/
+typedef struct ILink_ {
+    struct ILink_ *next;
+} ILink;
+
+typedef struct IDLink_ {
+    struct IDLink_ *prev;
+    struct IDLink_ *next;
+} IDLink;
+
+/*
+    Struct for the intrusive linked list
+    destroy receives each link left in the list by ilist_destroy
+*/
+typedef struct IList_ {
+    int size;
+
+    void (*destroy) (ILink *link);
+
+    ILink *head;
+    ILink *tail;
+} IList;
+
+/*
+    Struct for the intrusive doubly linked list
+*/
+typedef struct IDList_ {
+    int size;
+
+    void (*destroy) (IDLink *link);
+
+    IDLink *head;
+    IDLink *tail;
+} IDList;
+
+/*
+    Public Interfaces
+    Same rules as list.h and dlist.h: a NULL node inserts at the head
+    of an IList, and only into an empty IDList
+*/
+void ilist_init (IList *list, void (*destroy)(ILink *link));
+void ilist_destroy (IList *list);
+
+int ilist_ins_next (IList *list, ILink *node, ILink *link);
+int ilist_rem_next (IList *list, ILink *node, ILink **link);
+
+void idlist_init (IDList *list, void (*destroy)(IDLink *link));
+void idlist_destroy (IDList *list);
+
+int idlist_ins_next (IDList *list, IDLink *node, IDLink *link);
+int idlist_ins_prev (IDList *list, IDLink *node, IDLink *link);
+int idlist_remove (IDList *list, IDLink *link);
+
+/*
+    Macros
+*/
+#define ilist_entry(link, type, member) ((type *)((char *)(link) - offsetof(type, member)))
+
+#define ilist_size(list) ((list)->size)
+#define ilist_head(list) ((list)->head)
+#define ilist_tail(list) ((list)->tail)
+
+#define ilist_is_head(list, link) ((link) == (list)->head ? 1 : 0)
+#define ilist_is_tail(link) ((link)->next == NULL ? 1 : 0)
+
+#define ilist_next(link) ((link)->next)
+
+#define idlist_size(list) ((list)->size)
+#define idlist_head(list) ((list)->head)
+#define idlist_tail(list) ((list)->tail)
+
+#define idlist_is_head(link) ((link)->prev == NULL ? 1 : 0)
+#define idlist_is_tail(link) ((link)->next == NULL ? 1 : 0)
+
+#define idlist_next(link) ((link)->next)
+#define idlist_prev(link) ((link)->prev)
+
+/*
+    Iterate with var pointing to each element, type has its link in member
+    ilist_foreach works on both lists; the link must not be removed
+    while it is the current one
+*/
+#define ilist_foreach(list, var, type, member)                                  \
+    for ((var) = (list)->head == NULL ? NULL : ilist_entry((list)->head, type, member); \
+         (var) != NULL;                                                        \
+         (var) = (var)->member.next == NULL ? NULL : ilist_entry((var)->member.next, type, member))
+
+#endif
@@ -0,0 +1,50 @@
+/*
+    lfstack.h
+*/
+#ifndef LFSTACK_H
+#define LFSTACK_H
+
+#include <stdlib.h>
+
+/*
+    Lock-free stack node
+*/
+typedef struct LFStackNode_ {
+    void *data;
+    struct LFStackNode_ *next;
+
+    /* Link in the retired list while waiting to be freed */
+    struct LFStackNode_ *retired;
+} LFStackNode;
+
+/*
+    Struct for the lock-free (Treiber) stack
+    top packs the top node in the low 48 bits and an ABA tag in the
+    high 16 bits, bumped on every change. Popped nodes are freed with
+    epoch-based reclamation once no thread can still be reading them
+*/
+typedef struct LFStack_ {
+    unsigned long long top;
+    long size;
+
+    void (*destroy) (void *data);
+} LFStack;
+
+/*
+    Public Interfaces
+*/
+void lfstack_init (LFStack *stack, void (*destroy)(void *data));
+void lfstack_destroy (LFStack *stack);
+
+int lfstack_push (LFStack *stack, const void *data);
+int lfstack_pop (LFStack *stack, void **data);
+
+void lfstack_thread_exit (void);
+void lfstack_quiesce (void);
+
+/*
+    Macros
+*/
+#define lfstack_size(stack) __atomic_load_n(&(stack)->size, __ATOMIC_RELAXED)
+
+#endif
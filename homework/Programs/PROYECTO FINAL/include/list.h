@@ -6,12 +6,18 @@
 
 #include <stdlib.h>
 
+#define LIST_CACHE_LINE 64
+
 /*
     Linked list node
+    Nodes made by list_ins_next_copy carry their element in payload,
+    the node and the copy share one cache-line aligned block
 */
 typedef struct ListNode_ {
     void *data;
     struct ListNode_ *next;
+
+    char payload[];
 } ListNode;
 
 /*
@@ -35,6 +41,29 @@ void list_destroy (List *list);
 int list_ins_next (List *list, ListNode *node, const void *data);
 int list_rem_next (List *list, ListNode *node, void **data);
 
+int list_ins_next_copy (List *list, ListNode *node, const void *data, size_t size);
+int list_rem_next_copy (List *list, ListNode *node, void *data, size_t size);
+
+/*
+    The nodes of the _copy operations freed by a thread are kept for
+    that thread to reuse; one that used them calls list_spare_release
+    before it exits, or they are never freed
+*/
+void list_spare_release (void);
+
+/*
+    Bulk operations, none of them allocates
+    The sorts are stable merge sorts; compare returns < 0, 0 or > 0 as
+    in qsort. list_splice moves every node of other after node (at the
+    head when node is NULL), list_concat to the tail; other is left empty
+*/
+void list_sort (List *list, int (*compare)(const void *key1, const void *key2));
+void list_sort_bottom_up (List *list, int (*compare)(const void *key1, const void *key2));
+
+void list_splice (List *list, ListNode *node, List *other);
+void list_concat (List *list, List *other);
+void list_reverse (List *list);
+
 /*
     Macros
 */
@@ -48,5 +77,8 @@ int list_rem_next (List *list, ListNode *node, void **data);
 #define list_data(node) ((node)->data)
 #define list_next(node) ((node)->next)
 
+#define LIST_INLINE_MAX (LIST_CACHE_LINE - sizeof(ListNode))
+#define list_is_inline(node) ((node)->data == (void *)(node)->payload ? 1 : 0)
+
 #endif
     
\ No newline at end of file
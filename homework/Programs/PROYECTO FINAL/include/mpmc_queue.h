@@ -0,0 +1,61 @@
+/*
+    mpmc_queue.h
+*/
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdlib.h>
+
+/*
+    Size of a cache line, used to keep the producer and consumer
+    positions apart
+*/
+#define MPMC_CACHE_LINE 64
+
+/*
+    Ring cell
+    sequence == position: free, a producer may fill it
+    sequence == position + 1: full, a consumer may empty it
+*/
+typedef struct MPMCCell_ {
+    size_t sequence;
+    void *data;
+} MPMCCell;
+
+/*
+    Bounded lock-free multi-producer/multi-consumer queue
+    (sequence-numbered ring). The capacity is a power of two
+*/
+typedef struct MPMCQueue_ {
+    MPMCCell *buffer;
+    size_t mask;
+
+    char pad0[MPMC_CACHE_LINE];
+    size_t enqueue_pos;
+
+    char pad1[MPMC_CACHE_LINE - sizeof(size_t)];
+    size_t dequeue_pos;
+
+    char pad2[MPMC_CACHE_LINE - sizeof(size_t)];
+} MPMCQueue;
+
+/*
+    Public Interfaces
+*/
+int mpmc_queue_init (MPMCQueue *queue, size_t capacity);
+void mpmc_queue_destroy (MPMCQueue *queue);
+
+int mpmc_queue_try_enqueue (MPMCQueue *queue, const void *data);
+int mpmc_queue_try_dequeue (MPMCQueue *queue, void **data);
+
+int mpmc_queue_enqueue (MPMCQueue *queue, const void *data);
+int mpmc_queue_dequeue (MPMCQueue *queue, void **data);
+
+size_t mpmc_queue_size (MPMCQueue *queue);
+
+/*
+    Macros
+*/
+#define mpmc_queue_capacity(queue) ((queue)->mask + 1)
+
+#endif
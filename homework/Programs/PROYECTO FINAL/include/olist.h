@@ -0,0 +1,70 @@
+/*
+    olist.h
+*/
+#ifndef OLIST_H
+#define OLIST_H
+
+#include <stdlib.h>
+
+/*
+    Order-statistic list node
+    The list is an implicit treap: in-order is list order, count is the
+    number of nodes in the subtree, so a position is found by counts
+    alone and no key is stored. priority keeps the tree a heap, and
+    balanced in expectation
+*/
+typedef struct OListNode_ {
+    void *data;
+    struct OListNode_ *left;
+    struct OListNode_ *right;
+    struct OListNode_ *parent;
+
+    unsigned int priority;
+    int count;
+} OListNode;
+
+/*
+    Struct for the order-statistic list
+*/
+typedef struct OList_ {
+    int size;
+
+    void (*destroy) (void *data);
+
+    OListNode *root;
+    unsigned int seed;
+} OList;
+
+/*
+    Public Interfaces
+    Positions go from 0 to size - 1. olist_at, olist_ins_at, olist_remove
+    and olist_index are O(log n) expected, olist_next and olist_prev are
+    O(1) amortized over a full scan. olist_at returns NULL and
+    olist_index -1 out of range; olist_ins_at takes 0 to size, size
+    appends
+*/
+void olist_init (OList *list, void (*destroy)(void *data));
+void olist_destroy (OList *list);
+
+OListNode *olist_at (const OList *list, int index);
+int olist_index (const OListNode *node);
+
+int olist_ins_at (OList *list, int index, const void *data);
+int olist_remove (OList *list, OListNode *node, void **data);
+int olist_remove_at (OList *list, int index, void **data);
+
+OListNode *olist_head (const OList *list);
+OListNode *olist_tail (const OList *list);
+OListNode *olist_next (const OListNode *node);
+OListNode *olist_prev (const OListNode *node);
+
+/*
+    Macros
+*/
+#define olist_size(list) ((list)->size)
+#define olist_data(node) ((node)->data)
+
+#define olist_is_head(node) (olist_prev(node) == NULL ? 1 : 0)
+#define olist_is_tail(node) (olist_next(node) == NULL ? 1 : 0)
+
+#endif
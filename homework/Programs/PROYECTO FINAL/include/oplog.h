@@ -0,0 +1,97 @@
+/*
+    oplog.h
+*/
+#ifndef OPLOG_H
+#define OPLOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+    Longest log path, rotated files kept besides the live one
+*/
+#define OPLOG_PATH 512
+#define OPLOG_KEEP 9
+
+/*
+    Sync policy: leave the data to the system, or fsync every commit
+*/
+#define OPLOG_SYNC_NONE 0
+#define OPLOG_SYNC_COMMIT 1
+
+/*
+    Where a record is: its time, the hash of its key and its bytes in
+    the log. The index of path is path.idx, a header and then these in
+    the order the records were written
+*/
+typedef struct OpLogEntry_ {
+    long long time;
+    unsigned long long hash;
+    long long offset;
+    long long length;
+} OpLogEntry;
+
+/*
+    Struct for the operation log
+    Records are written into a stdio buffer of buffer_size bytes and
+    their entries wait in entries, until group records are in: then
+    the log is flushed before the index, so an entry never points past
+    the data, and with OPLOG_SYNC_COMMIT both are synced. A record that
+    starts past max_size bytes first rotates the log: path becomes
+    path.1, path.1 path.2, and so on up to OPLOG_KEEP, with their
+    indexes
+*/
+typedef struct OpLog_ {
+    char path[OPLOG_PATH];
+    FILE *file;
+    FILE *index;
+    char *buffer;
+    size_t buffer_size;
+
+    int group;
+    int sync;
+    long long max_size;
+
+    long long offset;
+    long long last_time;
+
+    OpLogEntry *entries;
+    int pending;
+    OpLogEntry record;
+} OpLog;
+
+/*
+    Public Interfaces
+    oplog_begin gives the stream to write one record to, time and key
+    are what it is found by; oplog_end closes the record and commits
+    when the group is full. Entry times never go back: a record older
+    than the one before takes its time, which keeps the index sorted.
+    oplog_find_hash and oplog_find_time read only the index of path,
+    calling visit on every entry for key hash or with a time in since
+    to until, both included, until visit returns nonzero. They return
+    the entries visited, -1 when the index cannot be read. oplog_read
+    copies the record of entry into text, cut to size - 1 bytes
+*/
+int oplog_open (OpLog *log, const char *path, size_t buffer_size, int group, int sync, long long max_size);
+int oplog_close (OpLog *log);
+
+FILE *oplog_begin (OpLog *log, time_t time, const char *key);
+int oplog_end (OpLog *log);
+int oplog_commit (OpLog *log);
+
+unsigned long long oplog_hash (const char *key);
+int oplog_find_hash (const char *path, unsigned long long hash, int (*visit)(const OpLogEntry *entry, void *data),
+                     void *data);
+int oplog_find_time (const char *path, long long since, long long until,
+                     int (*visit)(const OpLogEntry *entry, void *data), void *data);
+int oplog_read (const char *path, const OpLogEntry *entry, char *text, size_t size);
+
+/*
+    Macros
+*/
+#define oplog_path(log) ((log)->path)
+#define oplog_pending(log) ((log)->pending)
+#define oplog_size(log) ((log)->offset)
+
+#endif
@@ -0,0 +1,34 @@
+/*
+    pqueue.h
+*/
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include <stdlib.h>
+
+#include <heap.h>
+
+/*
+    pqueue node
+*/
+typedef Heap PQueue;
+
+/*
+    Public Interfaces
+*/
+#define pqueue_init heap_init
+#define pqueue_destroy heap_destroy
+
+#define pqueue_insert heap_insert
+#define pqueue_extract heap_extract
+#define pqueue_update heap_update
+#define pqueue_remove heap_remove
+#define pqueue_build heap_build
+
+/*
+    Macros
+*/
+#define pqueue_peek heap_peek
+#define pqueue_size heap_size
+
+#endif
@@ -0,0 +1,55 @@
+/*
+    pstack.h
+*/
+#ifndef PSTACK_H
+#define PSTACK_H
+
+#include <stdlib.h>
+
+/*
+    pstack node, shared by every version that has it below its top
+*/
+typedef struct PStackNode_ {
+    void *data;
+    struct PStackNode_ *next;
+    int refs;
+} PStackNode;
+
+/*
+    Struct for the persistent stack
+    A version is its top node; pushing puts a new node over the top of
+    another version, popping takes the node under it, so both cost O(1)
+    and never change a node that other versions see. Each node counts
+    the versions and nodes that point at it, and goes away with the
+    last of them
+*/
+typedef struct PStack_ {
+    int size;
+    void (*destroy) (void *data);
+    PStackNode *top;
+} PStack;
+
+/*
+    Public Interfaces
+    to and from may be the same version. to must be initialized, its
+    old contents are released. The data stays in the nodes, pstack_pop
+    only reads it: destroy runs on it when its node goes away, which
+    for a pop with to == from is before pstack_pop returns
+*/
+void pstack_init (PStack *stack, void (*destroy)(void *data));
+void pstack_destroy (PStack *stack);
+
+int pstack_push (PStack *to, const PStack *from, const void *data);
+int pstack_pop (PStack *to, const PStack *from, void **data);
+void pstack_copy (PStack *to, const PStack *from);
+
+/*
+    Macros
+*/
+#define pstack_size(stack) ((stack)->size)
+#define pstack_peek(stack) ((stack)->top == NULL ? NULL : (stack)->top->data)
+#define pstack_head(stack) ((stack)->top)
+#define pstack_next(node) ((node)->next)
+#define pstack_data(node) ((node)->data)
+
+#endif
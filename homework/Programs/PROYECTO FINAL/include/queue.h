@@ -22,6 +22,9 @@ typedef List Queue;
 int queue_enqueue (Queue *queue, const void *data);
 int queue_dequeue (Queue *queue, void **data);
 
+int queue_enqueue_copy (Queue *queue, const void *data, size_t size);
+int queue_dequeue_copy (Queue *queue, void *data, size_t size);
+
 /*
     Macros
 */
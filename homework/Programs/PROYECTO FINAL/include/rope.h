@@ -0,0 +1,63 @@
+/*
+    rope.h
+*/
+#ifndef ROPE_H
+#define ROPE_H
+
+#include <stdlib.h>
+
+/*
+    Bytes of text per chunk
+*/
+#define ROPE_CHUNK 512
+
+/*
+    Rope node, one chunk of text
+    The rope is a treap of chunks: in-order is text order and bytes is
+    the length of the text under the node, so an offset is found by
+    lengths alone. priority keeps the tree balanced in expectation
+*/
+typedef struct RopeNode_ {
+    struct RopeNode_ *left;
+    struct RopeNode_ *right;
+
+    unsigned int priority;
+    int length;
+    size_t bytes;
+
+    char text[ROPE_CHUNK];
+} RopeNode;
+
+/*
+    Struct for the rope
+*/
+typedef struct Rope_ {
+    RopeNode *root;
+    unsigned int seed;
+} Rope;
+
+/*
+    Public Interfaces
+    Offsets are in bytes, the text is not NUL terminated inside the rope.
+    rope_insert, rope_delete and rope_substr are O(log n) expected plus
+    the bytes they move; a short insert into a chunk with room moves
+    only that chunk. rope_substr writes length bytes and a NUL to text.
+    rope_foreach_chunk calls visit on every chunk in order and stops at
+    the first nonzero return, which it returns
+*/
+void rope_init (Rope *rope);
+void rope_destroy (Rope *rope);
+
+int rope_insert (Rope *rope, size_t offset, const char *text, size_t length);
+int rope_delete (Rope *rope, size_t offset, size_t length);
+int rope_substr (const Rope *rope, size_t offset, size_t length, char *text);
+
+int rope_foreach_chunk (const Rope *rope, int (*visit)(void *arg, const char *text, size_t length),
+                        void *arg);
+
+/*
+    Macros
+*/
+#define rope_length(rope) ((rope)->root == NULL ? (size_t)0 : (rope)->root->bytes)
+
+#endif
@@ -0,0 +1,66 @@
+/*
+    sdlist.h
+*/
+#ifndef SDLIST_H
+#define SDLIST_H
+
+#include <stdlib.h>
+
+/*
+    Sentinel doubly linked list node
+*/
+typedef struct SDListNode_ {
+    void *data;
+    struct SDListNode_ *next;
+    struct SDListNode_ *prev;
+} SDListNode;
+
+/*
+    Struct for the circular doubly linked list with a sentinel
+    The sentinel is the node before the head and after the tail, so an
+    empty list, the head and the tail need no special cases. It lives
+    inside the struct: an SDList must not be copied or moved once
+    initialized
+*/
+typedef struct SDList_ {
+    int size;
+
+    void (*destroy) (void *data);
+
+    SDListNode sentinel;
+} SDList;
+
+/*
+    Public Interfaces
+    node may be the sentinel: sdlist_ins_next after sdlist_end inserts
+    at the head and sdlist_ins_prev before it at the tail.
+    sdlist_splice moves every node of other after node, sdlist_concat
+    moves them to the tail; both in constant time, other is left empty
+*/
+void sdlist_init (SDList *list, void (*destroy)(void *data));
+void sdlist_destroy (SDList *list);
+
+int sdlist_ins_next (SDList *list, SDListNode *node, const void *data);
+int sdlist_ins_prev (SDList *list, SDListNode *node, const void *data);
+int sdlist_remove (SDList *list, SDListNode *node, void **data);
+
+void sdlist_splice (SDList *list, SDListNode *node, SDList *other);
+void sdlist_concat (SDList *list, SDList *other);
+
+/*
+    Macros
+    sdlist_head and sdlist_tail are sdlist_end on an empty list
+*/
+#define sdlist_size(list) ((list)->size)
+#define sdlist_end(list) (&(list)->sentinel)
+#define sdlist_head(list) ((list)->sentinel.next)
+#define sdlist_tail(list) ((list)->sentinel.prev)
+
+#define sdlist_is_head(list, node) ((node)->prev == sdlist_end(list) ? 1 : 0)
+#define sdlist_is_tail(list, node) ((node)->next == sdlist_end(list) ? 1 : 0)
+
+#define sdlist_data(node) ((node)->data)
+#define sdlist_next(node) ((node)->next)
+#define sdlist_prev(node) ((node)->prev)
+
+#endif
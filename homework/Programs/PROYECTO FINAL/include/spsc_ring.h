@@ -0,0 +1,63 @@
+/*
+    spsc_ring.h
+*/
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdlib.h>
+
+#define SPSC_CACHE_LINE 64
+
+/*
+    Bounded single-producer/single-consumer ring of pointers
+    The producer and consumer fields live on separate cache lines; each
+    side keeps a cached copy of the other side's index and only reads
+    the shared one when the cached copy says full or empty.
+    full and empty count the times a blocking call had to wait, the
+    backpressure and starvation seen by each side
+*/
+typedef struct SPSCRing_ {
+    void **buffer;
+    size_t mask;
+
+    char pad0[SPSC_CACHE_LINE];
+
+    /* Producer side */
+    size_t head;
+    size_t cached_tail;
+    unsigned long long full;
+
+    char pad1[SPSC_CACHE_LINE];
+
+    /* Consumer side */
+    size_t tail;
+    size_t cached_head;
+    unsigned long long empty;
+
+    char pad2[SPSC_CACHE_LINE];
+
+    int closed;
+} SPSCRing;
+
+/*
+    Public Interfaces
+*/
+int spsc_ring_init (SPSCRing *ring, size_t capacity);
+void spsc_ring_destroy (SPSCRing *ring);
+
+int spsc_ring_try_push (SPSCRing *ring, const void *data);
+int spsc_ring_try_pop (SPSCRing *ring, void **data);
+
+int spsc_ring_push (SPSCRing *ring, const void *data);
+int spsc_ring_pop (SPSCRing *ring, void **data);
+
+void spsc_ring_close (SPSCRing *ring);
+
+/*
+    Macros
+*/
+#define spsc_ring_capacity(ring) ((ring)->mask + 1)
+#define spsc_ring_size(ring) \
+    (__atomic_load_n(&(ring)->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&(ring)->tail, __ATOMIC_ACQUIRE))
+
+#endif
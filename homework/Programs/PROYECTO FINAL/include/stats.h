@@ -0,0 +1,107 @@
+/*
+    stats.h
+*/
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/*
+    Phases measured by the engines
+    Phases may nest (rendering inside a conversion), times are inclusive
+*/
+typedef enum StatsPhase_ {
+    STATS_TOKENIZE,
+    STATS_VALIDATE,
+    STATS_CONVERT,
+    STATS_EVALUATE,
+    STATS_RENDER,
+    STATS_SAVE,
+    STATS_PHASES
+} StatsPhase;
+
+/*
+    Containers whose allocations are counted
+    Stack and queue nodes are list nodes, so they are counted under
+    STATS_LIST too. Nodes released by stack_destroy/queue_destroy are
+    only counted as list frees
+*/
+typedef enum StatsContainer_ {
+    STATS_LIST,
+    STATS_DLIST,
+    STATS_STACK,
+    STATS_QUEUE,
+    STATS_CONTAINERS
+} StatsContainer;
+
+/*
+    Struct for the global counters
+*/
+typedef struct Stats_ {
+    unsigned long long phase_calls[STATS_PHASES];
+    unsigned long long phase_ns[STATS_PHASES];
+
+    unsigned long long allocs[STATS_CONTAINERS];
+    unsigned long long frees[STATS_CONTAINERS];
+    unsigned long long bytes[STATS_CONTAINERS];
+
+    unsigned long long peak_stack_depth;
+    unsigned long long steps;
+    unsigned long long scanned;     /* characters examined by rescans */
+} Stats;
+
+extern Stats stats_counters;
+
+/*
+    Public Interfaces
+*/
+void stats_init (void);
+void stats_reset (void);
+void stats_dump (FILE *out, int json);
+
+unsigned long long stats_now (void);
+unsigned long long stats_phase_begin (StatsPhase phase);
+void stats_phase_end (StatsPhase phase, unsigned long long start);
+
+const char *stats_phase_name (StatsPhase phase);
+
+/*
+    Macros
+    Counters are relaxed atomic adds, cheap enough to leave on.
+    Build with -DSTATS_DISABLE to compile them out.
+*/
+#ifndef STATS_DISABLE
+
+#define stats_add(counter, n) \
+    ((void)__atomic_fetch_add(&(counter), (unsigned long long)(n), __ATOMIC_RELAXED))
+
+#define stats_alloc(kind, n) \
+    (stats_add(stats_counters.allocs[(kind)], 1), stats_add(stats_counters.bytes[(kind)], (n)))
+
+#define stats_free(kind) stats_add(stats_counters.frees[(kind)], 1)
+
+#define stats_steps(n) stats_add(stats_counters.steps, (n))
+
+#define stats_scan(n) stats_add(stats_counters.scanned, (n))
+
+#define stats_stack_depth(depth) \
+    do { \
+        unsigned long long depth_ = (unsigned long long)(depth); \
+        unsigned long long peak_ = __atomic_load_n(&stats_counters.peak_stack_depth, __ATOMIC_RELAXED); \
+        while (depth_ > peak_ && !__atomic_compare_exchange_n(&stats_counters.peak_stack_depth, \
+                &peak_, depth_, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) \
+            ; \
+    } while (0)
+
+#else
+
+#define stats_add(counter, n) ((void)0)
+#define stats_alloc(kind, n) ((void)0)
+#define stats_free(kind) ((void)0)
+#define stats_steps(n) ((void)0)
+#define stats_scan(n) ((void)0)
+#define stats_stack_depth(depth) ((void)0)
+
+#endif
+
+#endif
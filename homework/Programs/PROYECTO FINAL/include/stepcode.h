@@ -0,0 +1,42 @@
+/*
+    stepcode.h
+*/
+#ifndef STEPCODE_H
+#define STEPCODE_H
+
+#include <stdlib.h>
+
+/*
+    Bytes per encoded record at most, and results remembered for
+    operand references
+*/
+#define STEPCODE_MAX 40
+#define STEPCODE_WINDOW 16
+
+/*
+    A step of a two stack evaluator: 'N' pushes result, 'O' pushes
+    operator, 'P' pops a '(' and 'A' applies operator to operand1 and
+    operand2, giving result. Only the fields of its kind are kept
+*/
+typedef struct StepRecord_ {
+    char kind;
+    char operator;
+    double operand1;
+    double operand2;
+    double result;
+} StepRecord;
+
+/*
+    Public Interfaces
+    The codec for steptrace_set_codec. A record is a tag byte with the
+    kind and operator, then for 'N' its result and for 'A' its operands
+    and result. An operand equal to one of the last STEPCODE_WINDOW
+    results is stored as how far back it is; other numbers are varints
+    of their difference from the last whole number, or the 8 bytes of
+    the double when they are not whole. Every block starts afresh, so
+    it can be decoded alone
+*/
+size_t stepcode_encode (const void *records, int count, unsigned char *out);
+int stepcode_decode (const unsigned char *in, size_t length, void *records, int count);
+
+#endif
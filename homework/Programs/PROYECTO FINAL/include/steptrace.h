@@ -0,0 +1,98 @@
+/*
+    steptrace.h
+*/
+#ifndef STEPTRACE_H
+#define STEPTRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+    Records per chunk, a power of two
+*/
+#define STEPTRACE_CHUNK 256
+
+/*
+    A copy of the machine state, taken before record index
+*/
+typedef struct StepCheckpoint_ {
+    int index;
+    size_t length;
+    void *state;
+} StepCheckpoint;
+
+/*
+    Struct for the step trace
+    Records have a fixed size and live in chunks of STEPTRACE_CHUNK, so
+    record k is found with a shift and a mask and the chunks never move
+    once written. Every interval records the caller leaves a checkpoint
+    of its state; the state after any record is the nearest checkpoint
+    before it with at most interval records replayed on top.
+    With a codec, every full chunk is sealed: encoded into lengths[i]
+    bytes, and decoded again into window when one of its records is
+    read. Only the last chunk stays as plain records
+*/
+typedef struct StepTrace_ {
+    int size;
+    int record_size;
+    int interval;
+
+    char **chunks;
+    size_t *lengths;
+    int chunk_count;
+    int chunk_capacity;
+
+    StepCheckpoint *checkpoints;
+    int checkpoint_count;
+    int checkpoint_capacity;
+
+    size_t (*encode) (const void *records, int count, unsigned char *out);
+    int (*decode) (const unsigned char *in, size_t length, void *records, int count);
+    int encoded_max;
+
+    char *window;
+    int window_chunk;
+    unsigned char *scratch;
+} StepTrace;
+
+/*
+    Public Interfaces
+    steptrace_checkpoint copies length bytes of state, the caller lays
+    them out and only has to call it when steptrace_due says so.
+    steptrace_state rebuilds the state after record index into state:
+    restore loads a checkpoint, with NULL and 0 for the state before
+    the first record, then apply replays the records that follow it.
+    steptrace_at gives record index; for a sealed chunk the pointer is
+    good until a record of another sealed chunk is read.
+    steptrace_set_codec must come before the first record: encode
+    writes at most encoded_max bytes per record and returns the bytes
+    written, 0 on error; decode returns 0 when it got count records.
+    steptrace_save writes the records and checkpoints, encoded when
+    there is a codec; steptrace_load reads the next saved trace of in
+    into an empty trace set up the same way, and returns 1 at the end
+    of the file
+*/
+int steptrace_init (StepTrace *trace, int record_size, int interval);
+void steptrace_destroy (StepTrace *trace);
+
+int steptrace_set_codec (StepTrace *trace, size_t (*encode)(const void *records, int count, unsigned char *out),
+                         int (*decode)(const unsigned char *in, size_t length, void *records, int count),
+                         int encoded_max);
+
+int steptrace_append (StepTrace *trace, const void *record);
+void *steptrace_at (StepTrace *trace, int index);
+int steptrace_checkpoint (StepTrace *trace, const void *state, size_t length);
+int steptrace_state (StepTrace *trace, int index, void *state,
+                     int (*restore)(void *state, const void *checkpoint, size_t length),
+                     int (*apply)(void *state, const void *record));
+
+int steptrace_save (StepTrace *trace, FILE *out);
+int steptrace_load (StepTrace *trace, FILE *in);
+
+/*
+    Macros
+*/
+#define steptrace_size(trace) ((trace)->size)
+#define steptrace_due(trace) ((trace)->size > 0 && (trace)->size % (trace)->interval == 0)
+
+#endif
@@ -0,0 +1,71 @@
+/*
+    stepview.h
+*/
+#ifndef STEPVIEW_H
+#define STEPVIEW_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+    Longest row, and longest text searched for
+*/
+#define STEPVIEW_LINE 256
+#define STEPVIEW_QUERY 64
+
+/*
+    stepview_command has been told to stop
+*/
+#define STEPVIEW_QUIT 1
+
+/*
+    Struct for the step viewer
+    A window of height rows over a table of rows rows, top the first
+    one shown. No row is kept as text: render writes row into line when
+    it is drawn or searched, so a table of any length costs the same to
+    look at. found is the row the last search stopped on, -1 before
+*/
+typedef struct StepView_ {
+    int rows;
+    int height;
+    int top;
+
+    int (*render) (void *data, int row, char *line, int size);
+    void *data;
+
+    char query[STEPVIEW_QUERY];
+    int found;
+} StepView;
+
+/*
+    Public Interfaces
+    render returns 0 when it wrote row, at most size bytes with the
+    '\0', and -1 otherwise; it is called with rows in order while a
+    page is drawn or a search goes on, which lets it carry on from the
+    row before. stepview_draw writes the rows of the window to out, one
+    per line. stepview_search looks for text from the row after the
+    last one found, or from top, back to the start past the last row,
+    and moves the window to it. stepview_command does one command:
+    "" or "n" next page, "p" previous page, "g K" to row K, counted from
+    1, "/text" search, "/" search again, "q" quit; the next page after
+    the last one is a quit too. It returns STEPVIEW_QUIT, 0 when done
+    and -1 for a command it does not know or a search with no match
+*/
+int stepview_init (StepView *view, int rows, int height, int (*render)(void *data, int row, char *line, int size),
+                   void *data);
+
+int stepview_draw (StepView *view, FILE *out);
+void stepview_scroll (StepView *view, int delta);
+void stepview_goto (StepView *view, int row);
+int stepview_search (StepView *view, const char *text);
+int stepview_command (StepView *view, const char *command);
+
+/*
+    Macros
+*/
+#define stepview_rows(view) ((view)->rows)
+#define stepview_top(view) ((view)->top)
+#define stepview_bottom(view) ((view)->top + (view)->height < (view)->rows ? (view)->top + (view)->height : (view)->rows)
+#define stepview_found(view) ((view)->found)
+
+#endif
@@ -0,0 +1,63 @@
+/*
+    trace.h
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+/*
+    Trace event, name and category must be string literals
+*/
+typedef struct TraceEvent_ {
+    const char *name;
+    const char *cat;
+    unsigned long long ts;
+    long id;
+    char ph;
+} TraceEvent;
+
+/*
+    Per-thread event buffer, a chain of fixed size chunks
+    Only the owner thread appends, so no locking is needed
+*/
+#define TRACE_CHUNK 4096
+
+typedef struct TraceChunk_ {
+    int size;
+    struct TraceChunk_ *next;
+    TraceEvent events[TRACE_CHUNK];
+} TraceChunk;
+
+typedef struct TraceBuffer_ {
+    int tid;
+    const char *thread_name;
+
+    TraceChunk *head;
+    TraceChunk *tail;
+
+    struct TraceBuffer_ *next;
+} TraceBuffer;
+
+extern int trace_on;
+
+/*
+    Public Interfaces
+*/
+void trace_init (void);
+void trace_enable (const char *path);
+void trace_event (char ph, const char *name, const char *cat, long id);
+void trace_thread_name (const char *name);
+int trace_write (FILE *out);
+
+/*
+    Macros
+    A disabled tracer costs one branch per event
+*/
+#define trace_begin(name, cat, id) \
+    do { if (trace_on) trace_event('B', (name), (cat), (id)); } while (0)
+
+#define trace_end(name, cat) \
+    do { if (trace_on) trace_event('E', (name), (cat), -1); } while (0)
+
+#endif
@@ -0,0 +1,77 @@
+/*
+    ulist.h
+*/
+#ifndef ULIST_H
+#define ULIST_H
+
+#include <stdlib.h>
+
+/*
+    Elements per node: next, count and the data fill 256 bytes, four
+    cache lines, on 64-bit targets
+*/
+#define ULIST_NODE_CAPACITY 30
+
+/*
+    Unrolled linked list node, data[0 .. count - 1] in list order
+*/
+typedef struct UListNode_ {
+    struct UListNode_ *next;
+    int count;
+
+    void *data[ULIST_NODE_CAPACITY];
+} UListNode;
+
+/*
+    Struct for the unrolled linked list
+*/
+typedef struct UList_ {
+    int size;
+
+    void (*destroy) (void *data);
+
+    UListNode *head;
+    UListNode *tail;
+} UList;
+
+/*
+    Position of one element, what a ListNode is for list.h
+    Any insertion or removal invalidates the other positions
+*/
+typedef struct UListPos_ {
+    UListNode *node;
+    int index;
+} UListPos;
+
+/*
+    Public Interfaces
+    Same rules as list.h: a NULL position inserts at the head and
+    removes the head
+*/
+void ulist_init (UList *list, void (*destroy)(void *data));
+void ulist_destroy (UList *list);
+
+int ulist_ins_next (UList *list, const UListPos *pos, const void *data);
+int ulist_rem_next (UList *list, const UListPos *pos, void **data);
+
+int ulist_head (const UList *list, UListPos *pos);
+int ulist_tail (const UList *list, UListPos *pos);
+int ulist_next (UListPos *pos);
+
+/*
+    Macros
+*/
+#define ulist_size(list) ((list)->size)
+#define ulist_data(pos) ((pos)->node->data[(pos)->index])
+
+#define ulist_is_tail(pos) ((pos)->index == (pos)->node->count - 1 && (pos)->node->next == NULL ? 1 : 0)
+
+/*
+    Scan every element, var is a void * set to each one in turn
+    node is a UListNode * and i an int used as cursors
+*/
+#define ulist_foreach(list, node, i, var)                          \
+    for ((node) = (list)->head; (node) != NULL; (node) = (node)->next) \
+        for ((i) = 0; (i) < (node)->count && ((var) = (node)->data[(i)], 1); (i)++)
+
+#endif
@@ -0,0 +1,61 @@
+/*
+    wsdeque.h
+*/
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+#include <stdlib.h>
+
+#define WSDEQUE_CACHE_LINE 64
+
+/*
+    Circular array of the deque, indexed by position & mask
+    Replaced arrays are kept in the retired list until the deque is
+    destroyed, a thief may still be reading one
+*/
+typedef struct WSDequeArray_ {
+    size_t mask;
+    void **buffer;
+
+    struct WSDequeArray_ *retired;
+} WSDequeArray;
+
+/*
+    Struct for the work-stealing (Chase-Lev) deque
+    The owner thread pushes and pops at the bottom, any other thread
+    steals from the top. Only the pop of the last element and the
+    steals race, they are settled with a CAS on top. The array doubles
+    when the owner pushes into a full deque
+*/
+typedef struct WSDeque_ {
+    long top;
+    char pad0[WSDEQUE_CACHE_LINE - sizeof(long)];
+
+    long bottom;
+    WSDequeArray *array;
+    char pad1[WSDEQUE_CACHE_LINE];
+
+    void (*destroy) (void *data);
+} WSDeque;
+
+/*
+    Public Interfaces
+*/
+int wsdeque_init (WSDeque *deque, size_t capacity, void (*destroy)(void *data));
+void wsdeque_destroy (WSDeque *deque);
+
+int wsdeque_push (WSDeque *deque, const void *data);
+int wsdeque_pop (WSDeque *deque, void **data);
+int wsdeque_steal (WSDeque *deque, void **data);
+
+/*
+    Macros
+*/
+#define WSDEQUE_EMPTY -1
+#define WSDEQUE_ABORT 1
+
+#define wsdeque_size(deque) \
+    (__atomic_load_n(&(deque)->bottom, __ATOMIC_ACQUIRE) - __atomic_load_n(&(deque)->top, __ATOMIC_ACQUIRE))
+#define wsdeque_capacity(deque) (__atomic_load_n(&(deque)->array, __ATOMIC_ACQUIRE)->mask + 1)
+
+#endif
@@ -0,0 +1,466 @@
+// BATCH.C - Pipelined batch evaluator
+//
+// Usage: Batch [-e EVALUATORS] [input [output]]
+//
+// Evaluates one infix expression per line (stdin/stdout by default)
+// with a pipeline of threads:
+//
+//   reader -> parser -> N evaluators -> writer
+//
+// Stages pass whole batches of lines through single-producer/
+// single-consumer rings. Batches are dealt to the evaluators in turn
+// and collected in the same order, so the output keeps the input
+// order. The writer gives every batch back to the reader through a
+// free ring, which bounds the memory and makes a slow stage push back
+// on the stages before it. At exit the utilization of every stage is
+// printed to stderr.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "expr.h"
+#include "spsc_ring.h"
+#include "stats.h"
+#include "trace.h"
+
+#define MAX_EXPR 256
+#define BATCH_LINES 64
+#define MAX_EVALUATORS 32
+
+// Batches in flight per evaluator
+#define BATCHES_PER_EVALUATOR 3
+
+// Line status
+#define LINE_OK 0
+#define LINE_SYNTAX -1
+#define LINE_MATH -2
+
+// A batch of lines with their tokens and results
+typedef struct {
+    long sequence;
+    int count;
+
+    char lines[BATCH_LINES][MAX_EXPR];
+    int first[BATCH_LINES];
+    int tokens_count[BATCH_LINES];
+    int status[BATCH_LINES];
+    double results[BATCH_LINES];
+
+    ExprToken tokens[BATCH_LINES * MAX_EXPR];
+} Batch;
+
+// Time split of a stage
+typedef struct {
+    const char *name;
+    unsigned long long busy_ns;
+    unsigned long long starved_ns;   // waiting for input
+    unsigned long long blocked_ns;   // waiting for room downstream
+    long batches;
+    long lines;
+
+    char pad[SPSC_CACHE_LINE];
+} StageStats;
+
+// The pipeline
+typedef struct {
+    FILE *input;
+    FILE *output;
+    int evaluators;
+
+    SPSCRing free_ring;                      // writer -> reader
+    SPSCRing parse_ring;                     // reader -> parser
+    SPSCRing eval_rings[MAX_EVALUATORS];     // parser -> evaluator i
+    SPSCRing write_rings[MAX_EVALUATORS];    // evaluator i -> writer
+    Batch *spare;                            // left unused by the reader at EOF
+
+    StageStats reader;
+    StageStats parser;
+    StageStats evaluator[MAX_EVALUATORS];
+    StageStats writer;
+} Pipeline;
+
+// An evaluator thread and its index
+typedef struct {
+    Pipeline *pipeline;
+    int index;
+} EvaluatorArg;
+
+// Prototypes
+int run_pipeline(Pipeline *pipeline);
+void *reader_stage(void *arg);
+void *parser_stage(void *arg);
+void *evaluator_stage(void *arg);
+void *writer_stage(void *arg);
+void print_stage_stats(Pipeline *pipeline, unsigned long long wall_ns);
+
+// Pop from a ring, adding the wait to the stage's starved time
+static int stage_pop(StageStats *stage, SPSCRing *ring, void **data) {
+    unsigned long long start = stats_now();
+    int retval = spsc_ring_pop(ring, data);
+
+    stage->starved_ns += stats_now() - start;
+    return retval;
+}
+
+// Push to a ring, adding the wait to the stage's blocked time
+static void stage_push(StageStats *stage, SPSCRing *ring, const void *data) {
+    unsigned long long start = stats_now();
+
+    spsc_ring_push(ring, data);
+    stage->blocked_ns += stats_now() - start;
+}
+
+// Reader: fill free batches with lines
+void *reader_stage(void *arg) {
+    Pipeline *pipeline = (Pipeline*)arg;
+    StageStats *stage = &pipeline->reader;
+    Batch *batch;
+    unsigned long long start;
+    long sequence = 0;
+    int done = 0;
+
+    trace_thread_name("reader");
+
+    while(!done && stage_pop(stage, &pipeline->free_ring, (void**)&batch) == 0) {
+        start = stats_now();
+        trace_begin("read", "batch", sequence);
+
+        batch->sequence = sequence;
+        batch->count = 0;
+
+        while(batch->count < BATCH_LINES) {
+            char *line = batch->lines[batch->count];
+
+            if(fgets(line, MAX_EXPR, pipeline->input) == NULL) {
+                done = 1;
+                break;
+            }
+
+            line[strcspn(line, "\r\n")] = '\0';
+            if(line[0] != '\0') batch->count++;
+        }
+
+        trace_end("read", "batch");
+        stage->busy_ns += stats_now() - start;
+
+        if(batch->count == 0) {
+            pipeline->spare = batch;
+            break;
+        }
+
+        stage->batches++;
+        stage->lines += batch->count;
+        sequence++;
+
+        stage_push(stage, &pipeline->parse_ring, batch);
+    }
+
+    spsc_ring_close(&pipeline->parse_ring);
+    return NULL;
+}
+
+// Parser: tokenize and validate, then deal the batches to the evaluators
+void *parser_stage(void *arg) {
+    Pipeline *pipeline = (Pipeline*)arg;
+    StageStats *stage = &pipeline->parser;
+    Batch *batch;
+    unsigned long long start;
+    int i, next = 0, count;
+
+    trace_thread_name("parser");
+
+    while(stage_pop(stage, &pipeline->parse_ring, (void**)&batch) == 0) {
+        start = stats_now();
+        trace_begin("parse", "batch", batch->sequence);
+
+        next = 0;
+        for(i = 0; i < batch->count; i++) {
+            batch->first[i] = next;
+            count = expr_tokenize(batch->lines[i], &batch->tokens[next], MAX_EXPR);
+
+            if(count < 0 || expr_validate(&batch->tokens[next], count) != 0) {
+                batch->status[i] = LINE_SYNTAX;
+                batch->tokens_count[i] = 0;
+                continue;
+            }
+
+            batch->status[i] = LINE_OK;
+            batch->tokens_count[i] = count;
+            next += count;
+        }
+
+        trace_end("parse", "batch");
+        stage->busy_ns += stats_now() - start;
+        stage->batches++;
+        stage->lines += batch->count;
+
+        stage_push(stage, &pipeline->eval_rings[batch->sequence % pipeline->evaluators], batch);
+    }
+
+    for(i = 0; i < pipeline->evaluators; i++)
+        spsc_ring_close(&pipeline->eval_rings[i]);
+
+    return NULL;
+}
+
+// Evaluator: compute the results of the valid lines
+void *evaluator_stage(void *arg) {
+    EvaluatorArg *evaluator = (EvaluatorArg*)arg;
+    Pipeline *pipeline = evaluator->pipeline;
+    StageStats *stage = &pipeline->evaluator[evaluator->index];
+    Batch *batch;
+    unsigned long long start;
+    int i;
+
+    trace_thread_name(stage->name);
+
+    while(stage_pop(stage, &pipeline->eval_rings[evaluator->index], (void**)&batch) == 0) {
+        start = stats_now();
+        trace_begin("evaluate", "batch", batch->sequence);
+
+        for(i = 0; i < batch->count; i++) {
+            if(batch->status[i] != LINE_OK) continue;
+
+            if(expr_evaluate(&batch->tokens[batch->first[i]], batch->tokens_count[i],
+                             &batch->results[i]) != 0)
+                batch->status[i] = LINE_MATH;
+        }
+
+        trace_end("evaluate", "batch");
+        stage->busy_ns += stats_now() - start;
+        stage->batches++;
+        stage->lines += batch->count;
+
+        stage_push(stage, &pipeline->write_rings[evaluator->index], batch);
+    }
+
+    spsc_ring_close(&pipeline->write_rings[evaluator->index]);
+    return NULL;
+}
+
+// Writer: print the results in input order and recycle the batches
+void *writer_stage(void *arg) {
+    Pipeline *pipeline = (Pipeline*)arg;
+    StageStats *stage = &pipeline->writer;
+    Batch *batch;
+    unsigned long long start;
+    long sequence = 0;
+    int i;
+
+    trace_thread_name("writer");
+
+    while(stage_pop(stage, &pipeline->write_rings[sequence % pipeline->evaluators], (void**)&batch) == 0) {
+        start = stats_now();
+        trace_begin("write", "batch", batch->sequence);
+
+        for(i = 0; i < batch->count; i++) {
+            if(batch->status[i] == LINE_OK)
+                fprintf(pipeline->output, "%s = %.4f\n", batch->lines[i], batch->results[i]);
+            else if(batch->status[i] == LINE_MATH)
+                fprintf(pipeline->output, "%s : error: division by zero\n", batch->lines[i]);
+            else
+                fprintf(pipeline->output, "%s : error: invalid syntax\n", batch->lines[i]);
+        }
+
+        trace_end("write", "batch");
+        stage->busy_ns += stats_now() - start;
+        stage->batches++;
+        stage->lines += batch->count;
+        sequence++;
+
+        stage_push(stage, &pipeline->free_ring, batch);
+    }
+
+    // Wakes the reader if it is still waiting for a free batch
+    spsc_ring_close(&pipeline->free_ring);
+    return NULL;
+}
+
+// Print the time split of every stage, the busiest one limits throughput
+void print_stage_stats(Pipeline *pipeline, unsigned long long wall_ns) {
+    StageStats *stages[MAX_EVALUATORS + 3];
+    SPSCRing *inputs[MAX_EVALUATORS + 3];
+    StageStats *bottleneck = NULL;
+    int count = 0, i;
+
+    stages[count] = &pipeline->reader; inputs[count++] = &pipeline->free_ring;
+    stages[count] = &pipeline->parser; inputs[count++] = &pipeline->parse_ring;
+    for(i = 0; i < pipeline->evaluators; i++) {
+        stages[count] = &pipeline->evaluator[i];
+        inputs[count++] = &pipeline->eval_rings[i];
+    }
+    stages[count] = &pipeline->writer; inputs[count++] = &pipeline->write_rings[0];
+
+    fprintf(stderr, "+--------------+---------+----------+--------+-----------+-----------+------------+\n");
+    fprintf(stderr, "| %-12s | %7s | %8s | %6s | %9s | %9s | %10s |\n",
+            "STAGE", "BATCHES", "LINES", "BUSY", "STARVED", "BLOCKED", "RING WAITS");
+    fprintf(stderr, "+--------------+---------+----------+--------+-----------+-----------+------------+\n");
+
+    for(i = 0; i < count; i++) {
+        StageStats *stage = stages[i];
+        unsigned long long waits = inputs[i]->empty;
+
+        // The writer reads every write ring
+        if(stage == &pipeline->writer) {
+            int j;
+            for(waits = 0, j = 0; j < pipeline->evaluators; j++)
+                waits += pipeline->write_rings[j].empty;
+        }
+
+        fprintf(stderr, "| %-12s | %7ld | %8ld | %5.1f%% | %8.1f%% | %8.1f%% | %10llu |\n",
+                stage->name, stage->batches, stage->lines,
+                100.0 * stage->busy_ns / wall_ns, 100.0 * stage->starved_ns / wall_ns,
+                100.0 * stage->blocked_ns / wall_ns, waits);
+
+        if(bottleneck == NULL || stage->busy_ns > bottleneck->busy_ns)
+            bottleneck = stage;
+    }
+
+    fprintf(stderr, "+--------------+---------+----------+--------+-----------+-----------+------------+\n");
+    fprintf(stderr, "  %ld lines in %.3f ms (%.0f lines/s), bottleneck: %s\n",
+            pipeline->writer.lines, wall_ns / 1e6,
+            pipeline->writer.lines / (wall_ns / 1e9), bottleneck->name);
+}
+
+// Build the rings and the batch pool, run every stage and wait
+// -1 when out of memory, -2 when a stage thread could not start
+int run_pipeline(Pipeline *pipeline) {
+    static char names[MAX_EVALUATORS][16];
+    pthread_t reader, parser, writer, evaluators[MAX_EVALUATORS];
+    EvaluatorArg args[MAX_EVALUATORS];
+    Batch *batch;
+    int pool = BATCHES_PER_EVALUATOR * pipeline->evaluators + 3;
+    unsigned long long start;
+    int reader_started, parser_started, writer_started, started;
+    int i;
+
+    if(spsc_ring_init(&pipeline->free_ring, pool) != 0 ||
+       spsc_ring_init(&pipeline->parse_ring, 2) != 0)
+        return -1;
+
+    for(i = 0; i < pipeline->evaluators; i++) {
+        if(spsc_ring_init(&pipeline->eval_rings[i], 2) != 0 ||
+           spsc_ring_init(&pipeline->write_rings[i], 2) != 0)
+            return -1;
+
+        sprintf(names[i], "evaluator %d", i + 1);
+        pipeline->evaluator[i].name = names[i];
+        args[i].pipeline = pipeline;
+        args[i].index = i;
+    }
+
+    pipeline->reader.name = "reader";
+    pipeline->parser.name = "parser";
+    pipeline->writer.name = "writer";
+
+    for(i = 0; i < pool; i++) {
+        if((batch = (Batch*)malloc(sizeof(Batch))) == NULL)
+            return -1;
+        spsc_ring_try_push(&pipeline->free_ring, batch);
+    }
+
+    start = stats_now();
+
+    // Started from the writer back, so no stage runs before the one it
+    // pushes to: if one fails to start, nothing was read yet
+    writer_started = pthread_create(&writer, NULL, writer_stage, pipeline) == 0;
+    for(started = 0; writer_started && started < pipeline->evaluators; started++) {
+        if(pthread_create(&evaluators[started], NULL, evaluator_stage, &args[started]) != 0) break;
+    }
+    parser_started = started == pipeline->evaluators &&
+                     pthread_create(&parser, NULL, parser_stage, pipeline) == 0;
+    reader_started = parser_started && pthread_create(&reader, NULL, reader_stage, pipeline) == 0;
+
+    // The stages that did start find their input closed and stop
+    if(!reader_started) {
+        spsc_ring_close(&pipeline->parse_ring);
+        for(i = 0; i < pipeline->evaluators; i++) {
+            spsc_ring_close(&pipeline->eval_rings[i]);
+            spsc_ring_close(&pipeline->write_rings[i]);
+        }
+    }
+
+    if(reader_started) pthread_join(reader, NULL);
+    if(parser_started) pthread_join(parser, NULL);
+    for(i = 0; i < started; i++)
+        pthread_join(evaluators[i], NULL);
+    if(writer_started) pthread_join(writer, NULL);
+
+    fflush(pipeline->output);
+    if(reader_started) print_stage_stats(pipeline, stats_now() - start);
+
+    // Every batch is back in the free ring
+    while(spsc_ring_try_pop(&pipeline->free_ring, (void**)&batch) == 0)
+        free(batch);
+    free(pipeline->spare);
+
+    spsc_ring_destroy(&pipeline->free_ring);
+    spsc_ring_destroy(&pipeline->parse_ring);
+    for(i = 0; i < pipeline->evaluators; i++) {
+        spsc_ring_destroy(&pipeline->eval_rings[i]);
+        spsc_ring_destroy(&pipeline->write_rings[i]);
+    }
+
+    return reader_started ? 0 : -2;
+}
+
+int main(int argc, char *argv[]) {
+    static Pipeline pipeline;
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    long cpus = 1;
+#endif
+    int i, files = 0;
+    int status;
+
+    stats_init();
+
+    pipeline.input = stdin;
+    pipeline.output = stdout;
+
+    // Reader, parser and writer take three cores
+    pipeline.evaluators = cpus > 4 ? (int)cpus - 3 : 1;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            pipeline.evaluators = atoi(argv[++i]);
+        }
+        else if(files == 0) {
+            if((pipeline.input = fopen(argv[i], "r")) == NULL) {
+                fprintf(stderr, "Could not open '%s'\n", argv[i]);
+                return 1;
+            }
+            files++;
+        }
+        else if(files == 1) {
+            if((pipeline.output = fopen(argv[i], "w")) == NULL) {
+                fprintf(stderr, "Could not create '%s'\n", argv[i]);
+                return 1;
+            }
+            files++;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-e EVALUATORS] [input [output]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(pipeline.evaluators < 1) pipeline.evaluators = 1;
+    if(pipeline.evaluators > MAX_EVALUATORS) pipeline.evaluators = MAX_EVALUATORS;
+
+    status = run_pipeline(&pipeline);
+
+    if(status == -2)
+        fprintf(stderr, "Could not start the pipeline threads\n");
+    else if(status != 0)
+        fprintf(stderr, "Out of memory\n");
+
+    if(pipeline.input != stdin) fclose(pipeline.input);
+    if(pipeline.output != stdout) fclose(pipeline.output);
+
+    return status == 0 ? 0 : 1;
+}
@@ -7,12 +7,22 @@
 #include <time.h>
 #include "list.h"
 #include "stack.h"
-#include "queue.h"
+#include "steptrace.h"
+#include "stepcode.h"
+#include "stepview.h"
+#include "oplog.h"
 #include "dlist.h"
+#include "stats.h"
 
 #define MAX_EXPR 256
 #define MAX_PATH 512
 
+// Saved operations: stdio buffer, records per commit when saving from
+// --headless, and size at which the file is rotated
+#define SAVE_BUFFER (1 << 20)
+#define SAVE_GROUP 64
+#define SAVE_ROTATE (64LL << 20)
+
 // --- VT100 Sequence Definitions ---
 #define RESET_COLOR "\033[0m"
 #define COLOR_RED "\033[1;31m"
@@ -60,46 +70,369 @@ void set_red() {
 
 // Structure for tokens
 typedef struct {
-    char type;      // 'N' = number, 'O' = operator, 'P' = parenthesis
+    char type;      // 'N' = number, 'O' = operator, 'U' = sign, 'P' = parenthesis
     double value;
     char operator;
 } Token;
 
+// Tokens are copied into their nodes, which only hold DLIST_INLINE_MAX
+// bytes without a second allocation: this does not build if one is larger
+typedef char token_fits_inline[sizeof(Token) <= DLIST_INLINE_MAX ? 1 : -1];
+
+// A minus sign is evaluated as 0 NEGATE x: it binds tighter than * and /
+// but not ^, so -2^2 is -4, and it takes the operand after it
+#define NEGATE '~'
+
 // Structure for evaluation steps
+// Every change to the two stacks is a step: 'N' pushes result onto the
+// numbers, 'O' pushes operator, 'P' pops a '(' and 'A' applies operator
+// to the two numbers on top, leaving result. The tables show 'A' steps.
+// Full chunks of the trace are kept encoded by stepcode
+typedef StepRecord Step;
+
+// Both stacks rebuilt from the trace, bottom first
 typedef struct {
-    double operand1;
-    double operand2;
-    char operator;
-    double result;
-} Step;
+    int numbers;
+    int operators;
+    double number[MAX_EXPR];
+    char operator[MAX_EXPR];
+} EvalState;
+
+// Steps between two copies of the stacks in the trace
+#define CHECKPOINT_INTERVAL 64
+
+// Rows of the step table, the 'A' steps of a trace. Every ROW_MARK-th
+// row keeps the index of its step and the others are counted from it,
+// row and index are the last one rendered
+typedef struct {
+    StepTrace *steps;
+    int rows;
+    int *marks;
+    int row;
+    int index;
+} StepRows;
+
+// Rows shown at once, longer tables are paged
+#define ROW_MARK 64
+#define VIEW_HEIGHT 20
 
 // Prototypes
 int validate_syntax(const char *expr);
-void tokenize(const char *expr, DList *tokens);
-double evaluate_expression(DList *tokens, Queue *steps);
+int tokenize(const char *expr, DList *tokens);
+double evaluate_expression(DList *tokens, StepTrace *steps);
 int precedence(char op);
 int is_operator(char c);
 double apply_operation(char op, double a, double b);
-void show_steps(Queue *steps);
-void free_token(void *data);
-void free_step(void *data);
+void show_steps(StepTrace *steps);
+
+// Step trace: record, rebuild and show the stacks at any step
+// steps_lost is set when a step of the trace could not be recorded:
+// the trace is then not inspected or saved
+static int steps_lost = 0;
+int record_step(StepTrace *steps, Stack *number_stack, Stack *operator_stack,
+                 char kind, char operator, double operand1, double operand2, double result);
+int restore_state(void *state, const void *checkpoint, size_t length);
+int apply_step(void *state, const void *record);
+void inspect_steps(StepTrace *steps);
+
+// Step table a page at a time: rows are rendered when they are shown
+int step_rows_init(StepRows *rows, StepTrace *steps);
+void step_rows_destroy(StepRows *rows);
+int render_step_row(void *data, int row, char *line, int size);
+void view_steps(StepTrace *steps);
 
 // NEW FUNCTIONS FOR SAVING FILE
-void save_operations_to_file(Queue *steps, const char *expression, double result, const char *filename);
-void show_steps_in_file(Queue *steps, FILE *file);
+int save_operations_to_file(StepTrace *steps, const char *expression, double result, OpLog *log);
+void show_steps_in_file(StepTrace *steps, FILE *file);
 int get_file_path(char *path);
 
 // Function to show table with format
 void show_evaluation_table(DList *tokens);
 
-// Main function
-int main() {
+// Evaluate stdin without prompts (--headless), the traces and the
+// operations may be saved
+int run_headless(const char *trace_path, const char *save_path, int sync);
+
+// The log being saved to, committed by close_saved on exit() as well
+static OpLog *open_log = NULL;
+int close_saved(void);
+void close_saved_at_exit(void);
+
+// Print the saved operations of an expression, or from a time on
+int find_saved(const char *path, const char *expression, const char *since);
+int print_saved(const OpLogEntry *entry, void *data);
+
+// Print the steps of every trace saved in a file
+int show_trace_file(const char *trace_path);
+
+// Empty trace with its codec, 0 if it can record the steps
+int init_steps(StepTrace *steps);
+
+// Headless mode: evaluate every line of stdin, no banners or prompts
+// With trace_path, the trace of every expression is appended to it;
+// with save_path, its operations are saved as from the prompt, SAVE_GROUP
+// at a time and synced with each group when sync is set
+int run_headless(const char *trace_path, const char *save_path, int sync) {
+    char expression[MAX_EXPR];
+    DList tokens;
+    StepTrace steps;
+    FILE *trace_file = NULL;
+    OpLog saved;
+    double result;
+    unsigned long long phase;
+    int valid, traced;
+
+    if(trace_path != NULL && (trace_file = fopen(trace_path, "ab")) == NULL) {
+        fprintf(stderr, "Error: Could not open the trace file '%s'\n", trace_path);
+        return 1;
+    }
+
+    if(save_path != NULL && oplog_open(&saved, save_path, SAVE_BUFFER, SAVE_GROUP,
+                                       sync ? OPLOG_SYNC_COMMIT : OPLOG_SYNC_NONE, SAVE_ROTATE) != 0) {
+        fprintf(stderr, "Error: Could not open the file '%s'\n", save_path);
+        if(trace_file != NULL) fclose(trace_file);
+        return 1;
+    }
+
+    if(save_path != NULL) open_log = &saved;
+
+    while(fgets(expression, MAX_EXPR, stdin) != NULL) {
+        expression[strcspn(expression, "\n")] = 0;
+
+        if(expression[0] == '\0') continue;
+
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(expression);
+        stats_phase_end(STATS_VALIDATE, phase);
+
+        if(!valid) continue;
+
+        dlist_init(&tokens, NULL);
+        phase = stats_phase_begin(STATS_TOKENIZE);
+        valid = tokenize(expression, &tokens) == 0;
+        stats_phase_end(STATS_TOKENIZE, phase);
+
+        if(!valid) {
+            fprintf(stderr, "Error: Could not tokenize '%s'\n", expression);
+            dlist_destroy(&tokens);
+            continue;
+        }
+
+        traced = init_steps(&steps) == 0;
+        phase = stats_phase_begin(STATS_EVALUATE);
+        result = evaluate_expression(&tokens, traced ? &steps : NULL);
+        stats_phase_end(STATS_EVALUATE, phase);
+
+        phase = stats_phase_begin(STATS_RENDER);
+        if(traced) show_steps(&steps);
+        printf("%s = %.4f\n", expression, result);
+        stats_phase_end(STATS_RENDER, phase);
+
+        if(trace_file != NULL) {
+            phase = stats_phase_begin(STATS_SAVE);
+            if(steps_lost || steptrace_save(&steps, trace_file) != 0) {
+                fprintf(stderr, "Error: Could not write the trace of '%s'\n", expression);
+            }
+            stats_phase_end(STATS_SAVE, phase);
+        }
+
+        if(save_path != NULL) {
+            phase = stats_phase_begin(STATS_SAVE);
+            if(save_operations_to_file(&steps, expression, result, &saved) != 0) {
+                fprintf(stderr, "Error: Could not save the operations of '%s'\n", expression);
+            }
+            stats_phase_end(STATS_SAVE, phase);
+        }
+
+        dlist_destroy(&tokens);
+        if(traced) steptrace_destroy(&steps);
+    }
+
+    if(trace_file != NULL) fclose(trace_file);
+
+    if(save_path != NULL && close_saved() != 0) {
+        fprintf(stderr, "Error: Could not write the file '%s'\n", save_path);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Commit and close the log being saved to, if any
+int close_saved(void) {
+    int status = 0;
+
+    if(open_log != NULL) {
+        status = oplog_close(open_log);
+        open_log = NULL;
+    }
+
+    return status;
+}
+
+// A division by zero ends the program, the records saved so far keep
+// their index
+void close_saved_at_exit(void) {
+    close_saved();
+}
+
+// Print a saved operation, data is the file it is in
+int print_saved(const OpLogEntry *entry, void *data) {
+    char *text = (char*)malloc((size_t)entry->length + 1);
+
+    if(text == NULL) return -1;
+
+    if(oplog_read((const char*)data, entry, text, (size_t)entry->length + 1) == 0) {
+        fputs(text, stdout);
+    }
+
+    free(text);
+    return 0;
+}
+
+// Look through the index of the file and of its rotated copies, oldest
+// first: for the expression, or with since ("YYYY-MM-DD HH:MM:SS") for
+// everything saved from then on
+int find_saved(const char *path, const char *expression, const char *since) {
+    char name[MAX_PATH + 16];
+    struct tm when;
+    long long from = 0;
+    int generation, found, total = 0, indexed = 0;
+
+    if(strlen(path) >= MAX_PATH) {
+        fprintf(stderr, "Error: The path '%s' is too long\n", path);
+        return 1;
+    }
+
+    if(since != NULL) {
+        memset(&when, 0, sizeof(when));
+        if(sscanf(since, "%d-%d-%d %d:%d:%d", &when.tm_year, &when.tm_mon, &when.tm_mday,
+                  &when.tm_hour, &when.tm_min, &when.tm_sec) != 6) {
+            fprintf(stderr, "Error: '%s' is not a time as YYYY-MM-DD HH:MM:SS\n", since);
+            return 1;
+        }
+        when.tm_year -= 1900;
+        when.tm_mon -= 1;
+        when.tm_isdst = -1;
+        from = (long long)mktime(&when);
+    }
+
+    for(generation = OPLOG_KEEP; generation >= 0; generation--) {
+        if(generation == 0) snprintf(name, sizeof(name), "%s", path);
+        else snprintf(name, sizeof(name), "%s.%d", path, generation);
+
+        if(since != NULL) found = oplog_find_time(name, from, 0x7FFFFFFFFFFFFFFFLL, print_saved, name);
+        else found = oplog_find_hash(name, oplog_hash(expression), print_saved, name);
+
+        if(found < 0) continue;
+        indexed++;
+        total += found;
+    }
+
+    if(indexed == 0) {
+        fprintf(stderr, "Error: '%s' has no index of saved operations\n", path);
+        return 1;
+    }
+
+    printf("%d saved operation(s) found\n", total);
+
+    return 0;
+}
+
+// Read back the traces saved by --headless --trace, one after another
+int show_trace_file(const char *trace_path) {
+    FILE *trace_file = fopen(trace_path, "rb");
+    StepTrace steps;
+    int count = 0, status;
+
+    if(trace_file == NULL) {
+        fprintf(stderr, "Error: Could not open the trace file '%s'\n", trace_path);
+        return 1;
+    }
+
+    for(;;) {
+        if(init_steps(&steps) != 0) {
+            fclose(trace_file);
+            return 1;
+        }
+        status = steptrace_load(&steps, trace_file);
+
+        if(status == 0) {
+            printf("Trace %d:\n", ++count);
+            show_steps_in_file(&steps, stdout);
+        }
+
+        steptrace_destroy(&steps);
+        if(status != 0) break;
+    }
+
+    fclose(trace_file);
+
+    if(status < 0) {
+        fprintf(stderr, "Error: The trace file '%s' is damaged\n", trace_path);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Empty trace with its codec, 0 if it can record the steps
+// Without the codec the chunks are kept uncompressed; without a trace
+// the expression is evaluated untraced, as if every step were lost
+int init_steps(StepTrace *steps) {
+    steps_lost = 0;
+
+    if(steptrace_init(steps, sizeof(Step), CHECKPOINT_INTERVAL) != 0) {
+        fprintf(stderr, "Error: Could not start the step trace, the steps are not recorded\n");
+        steps_lost = 1;
+        return -1;
+    }
+
+    if(steptrace_set_codec(steps, stepcode_encode, stepcode_decode, STEPCODE_MAX) != 0) {
+        fprintf(stderr, "Warning: Could not set the step codec, the steps are kept uncompressed\n");
+    }
+
+    return 0;
+}
+
+// Main function (--headless reads expressions from stdin without prompts,
+// with --trace FILE it also saves their traces, with --save FILE their
+// operations and --fsync syncs those; --show-trace FILE prints the steps
+// of the saved traces; --find-saved FILE EXPRESSION and --saved-since
+// FILE "YYYY-MM-DD HH:MM:SS" print saved operations through the index)
+int main(int argc, char *argv[]) {
     char expression[MAX_EXPR];
     char file_path[MAX_PATH];
     DList tokens;
-    Queue steps;
+    StepTrace steps;
+    OpLog saved;
     double result;
+    unsigned long long phase;
+    int i, traced;
+    const char *trace_path = NULL, *save_path = NULL;
+    int sync = 0;
     
+    stats_init();
+    atexit(close_saved_at_exit);
+
+    if(argc > 1 && strcmp(argv[1], "--headless") == 0) {
+        for(i = 2; i < argc; i++) {
+            if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace_path = argv[++i];
+            else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc) save_path = argv[++i];
+            else if(strcmp(argv[i], "--fsync") == 0) sync = 1;
+        }
+        return run_headless(trace_path, save_path, sync);
+    }
+
+    if(argc > 2 && strcmp(argv[1], "--show-trace") == 0)
+        return show_trace_file(argv[2]);
+
+    if(argc > 3 && strcmp(argv[1], "--find-saved") == 0)
+        return find_saved(argv[2], argv[3], NULL);
+
+    if(argc > 3 && strcmp(argv[1], "--saved-since") == 0)
+        return find_saved(argv[2], NULL, argv[3]);
+
     clear_screen();
     
     printf("\n\n");
@@ -171,12 +504,22 @@ int main() {
             break;
         }
 
+        // Dump counters on request
+        if(strcmp(expression, "stats") == 0) {
+            printf("\n");
+            stats_dump(stdout, 0);
+            continue;
+        }
+
         // Validate syntax
         printf("\n");
         set_yellow();
         printf("[1] Validating syntax...\n");
         reset_color();
-        if(!validate_syntax(expression)) {
+        phase = stats_phase_begin(STATS_VALIDATE);
+        int valid = validate_syntax(expression);
+        stats_phase_end(STATS_VALIDATE, phase);
+        if(!valid) {
             set_red();
             printf("    ERROR: The expression has syntax errors.\n\n");
             reset_color();
@@ -203,8 +546,17 @@ int main() {
         set_yellow();
         printf("[2] Tokenizing expression...\n");
         reset_color();
-        dlist_init(&tokens, free_token);
-        tokenize(expression, &tokens);
+        dlist_init(&tokens, NULL);
+        phase = stats_phase_begin(STATS_TOKENIZE);
+        valid = tokenize(expression, &tokens) == 0;
+        stats_phase_end(STATS_TOKENIZE, phase);
+        if(!valid) {
+            set_red();
+            printf("    ERROR: Out of memory while tokenizing.\n\n");
+            reset_color();
+            dlist_destroy(&tokens);
+            continue;
+        }
         set_blue();
         printf("    Tokens processed: %d\n", dlist_size(&tokens));
         reset_color();
@@ -219,8 +571,10 @@ int main() {
         printf("+-------------------------------------------------------------------------------------------------+\n");
         reset_color();
 
-        queue_init(&steps, free_step);
-        result = evaluate_expression(&tokens, &steps);
+        traced = init_steps(&steps) == 0;
+        phase = stats_phase_begin(STATS_EVALUATE);
+        result = evaluate_expression(&tokens, traced ? &steps : NULL);
+        stats_phase_end(STATS_EVALUATE, phase);
 
         printf("\n");
         set_yellow();
@@ -231,7 +585,7 @@ int main() {
         printf("+-------------------------------------------------------------------------------------------------+\n");
         reset_color();
         
-        show_steps(&steps);
+        if(traced) view_steps(&steps);
         
         set_green();
         printf("+-------------------------------------------------------------------------------------------------+\n");
@@ -244,6 +598,8 @@ int main() {
         printf("%.4f\n", result);
         reset_color();
 
+        inspect_steps(&steps);
+
         // NEW FEATURE: SAVE TO FILE
         printf("\n");
         set_yellow();
@@ -256,10 +612,26 @@ int main() {
 
         if(answer == 'y' || answer == 'Y') {
             if(get_file_path(file_path)) {
-                save_operations_to_file(&steps, expression, result, file_path);
-                set_green();
-                printf("Operations saved to: %s\n", file_path);
-                reset_color();
+                // The log stays open until another file is asked for
+                if(open_log != NULL && strcmp(oplog_path(open_log), file_path) != 0) {
+                    close_saved();
+                }
+                if(open_log == NULL &&
+                   oplog_open(&saved, file_path, SAVE_BUFFER, 1, OPLOG_SYNC_NONE, SAVE_ROTATE) == 0) {
+                    open_log = &saved;
+                }
+
+                phase = stats_phase_begin(STATS_SAVE);
+                if(open_log == NULL || save_operations_to_file(&steps, expression, result, &saved) != 0) {
+                    set_red();
+                    printf("Error: Could not create/open the file '%s'\n", file_path);
+                    reset_color();
+                } else {
+                    set_green();
+                    printf("Operations saved to: %s\n", file_path);
+                    reset_color();
+                }
+                stats_phase_end(STATS_SAVE, phase);
             }
         }
         
@@ -269,9 +641,11 @@ int main() {
 
         // Free memory
         dlist_destroy(&tokens);
-        queue_destroy(&steps);
+        if(traced) steptrace_destroy(&steps);
     }
 
+    close_saved();
+
     return 0;
 }
 
@@ -380,8 +754,10 @@ int validate_syntax(const char *expr) {
 }
 
 // Tokenize the expression
-void tokenize(const char *expr, DList *tokens) {
+// Append the tokens of expr to tokens, -1 when one could not be inserted
+int tokenize(const char *expr, DList *tokens) {
     int i = 0, len = strlen(expr);
+    int expect_operand = 1;
 
     while(i < len) {
         if(isspace(expr[i])) {
@@ -389,7 +765,8 @@ void tokenize(const char *expr, DList *tokens) {
             continue;
         }
 
-        Token *token = (Token*)malloc(sizeof(Token));
+        // Copied into the node, one allocation per token
+        Token token = {0};
 
         if(isdigit(expr[i]) || expr[i] == '.') {
             char num_str[50];
@@ -400,33 +777,37 @@ void tokenize(const char *expr, DList *tokens) {
             }
             num_str[j] = '\0';
 
-            token->type = 'N';
-            token->value = atof(num_str);
+            token.type = 'N';
+            token.value = atof(num_str);
+            expect_operand = 0;
 
-            if(dlist_size(tokens) == 0) {
-                dlist_ins_next(tokens, NULL, token);
-            } else {
-                dlist_ins_next(tokens, dlist_tail(tokens), token);
+            if(dlist_ins_next_copy(tokens, dlist_tail(tokens), &token, sizeof(Token)) != 0) {
+                return -1;
             }
         }
         else {
-            token->type = (expr[i] == '(' || expr[i] == ')') ? 'P' : 'O';
-            token->operator = expr[i];
-
-            if(dlist_size(tokens) == 0) {
-                dlist_ins_next(tokens, NULL, token);
-            } else {
-                dlist_ins_next(tokens, dlist_tail(tokens), token);
+            // A sign where an operand is expected
+            if(expr[i] == '(' || expr[i] == ')') token.type = 'P';
+            else if(expect_operand && (expr[i] == '-' || expr[i] == '+')) token.type = 'U';
+            else token.type = 'O';
+            token.operator = expr[i];
+            expect_operand = (expr[i] != ')');
+
+            if(dlist_ins_next_copy(tokens, dlist_tail(tokens), &token, sizeof(Token)) != 0) {
+                return -1;
             }
             i++;
         }
     }
+
+    return 0;
 }
 
 // Evaluate expression using two stacks (numbers and operators)
-double evaluate_expression(DList *tokens, Queue *steps) {
+double evaluate_expression(DList *tokens, StepTrace *steps) {
     Stack number_stack, operator_stack;
     DListNode *current;
+    int operations = 0;
 
     stack_init(&number_stack, NULL);
     stack_init(&operator_stack, NULL);
@@ -441,6 +822,28 @@ double evaluate_expression(DList *tokens, Queue *steps) {
             double *num = (double*)malloc(sizeof(double));
             *num = token->value;
             stack_push(&number_stack, num);
+            if(record_step(steps, &number_stack, &operator_stack, 'N', 0, 0, 0, *num) != 0) {
+                steps_lost = 1;
+            }
+        }
+        else if(token->type == 'U') {
+            // Sign: + changes nothing, - pushes 0 and NEGATE, which
+            // pops nothing as its left operand is that 0
+            if(token->operator == '-') {
+                double *zero = (double*)malloc(sizeof(double));
+                *zero = 0;
+                stack_push(&number_stack, zero);
+                if(record_step(steps, &number_stack, &operator_stack, 'N', 0, 0, 0, 0) != 0) {
+                    steps_lost = 1;
+                }
+
+                char *negate = (char*)malloc(sizeof(char));
+                *negate = NEGATE;
+                stack_push(&operator_stack, negate);
+                if(record_step(steps, &number_stack, &operator_stack, 'O', NEGATE, 0, 0, 0) != 0) {
+                    steps_lost = 1;
+                }
+            }
         }
         else if(token->type == 'O') {
             // Operator: process according to precedence
@@ -465,19 +868,17 @@ double evaluate_expression(DList *tokens, Queue *steps) {
 
                 double result = apply_operation(*op, *num1, *num2);
 
-                // Save step
-                Step *step = (Step*)malloc(sizeof(Step));
-                step->operand1 = *num1;
-                step->operand2 = *num2;
-                step->operator = *op;
-                step->result = result;
-                queue_enqueue(steps, step);
-
                 // Push result
                 double *res = (double*)malloc(sizeof(double));
                 *res = result;
                 stack_push(&number_stack, res);
 
+                // Save step
+                if(record_step(steps, &number_stack, &operator_stack, 'A', *op, *num1, *num2, result) != 0) {
+                    steps_lost = 1;
+                }
+                operations++;
+
                 free(op);
                 free(num1);
                 free(num2);
@@ -486,12 +887,18 @@ double evaluate_expression(DList *tokens, Queue *steps) {
             char *new_op = (char*)malloc(sizeof(char));
             *new_op = token->operator;
             stack_push(&operator_stack, new_op);
+            if(record_step(steps, &number_stack, &operator_stack, 'O', *new_op, 0, 0, 0) != 0) {
+                steps_lost = 1;
+            }
         }
         else if(token->type == 'P') {
             if(token->operator == '(') {
                 char *par = (char*)malloc(sizeof(char));
                 *par = '(';
                 stack_push(&operator_stack, par);
+                if(record_step(steps, &number_stack, &operator_stack, 'O', '(', 0, 0, 0) != 0) {
+                    steps_lost = 1;
+                }
             }
             else if(token->operator == ')') {
                 // Process until '(' is found
@@ -501,6 +908,9 @@ double evaluate_expression(DList *tokens, Queue *steps) {
 
                     if(*op == '(') {
                         free(op);
+                        if(record_step(steps, &number_stack, &operator_stack, 'P', '(', 0, 0, 0) != 0) {
+                            steps_lost = 1;
+                        }
                         break;
                     }
 
@@ -510,18 +920,16 @@ double evaluate_expression(DList *tokens, Queue *steps) {
 
                     double result = apply_operation(*op, *num1, *num2);
 
-                    // Save step
-                    Step *step = (Step*)malloc(sizeof(Step));
-                    step->operand1 = *num1;
-                    step->operand2 = *num2;
-                    step->operator = *op;
-                    step->result = result;
-                    queue_enqueue(steps, step);
-
                     double *res = (double*)malloc(sizeof(double));
                     *res = result;
                     stack_push(&number_stack, res);
 
+                    // Save step
+                    if(record_step(steps, &number_stack, &operator_stack, 'A', *op, *num1, *num2, result) != 0) {
+                        steps_lost = 1;
+                    }
+                    operations++;
+
                     free(op);
                     free(num1);
                     free(num2);
@@ -543,23 +951,23 @@ double evaluate_expression(DList *tokens, Queue *steps) {
 
         double result = apply_operation(*op, *num1, *num2);
 
-        // Save step
-        Step *step = (Step*)malloc(sizeof(Step));
-        step->operand1 = *num1;
-        step->operand2 = *num2;
-        step->operator = *op;
-        step->result = result;
-        queue_enqueue(steps, step);
-
         double *res = (double*)malloc(sizeof(double));
         *res = result;
         stack_push(&number_stack, res);
 
+        // Save step
+        if(record_step(steps, &number_stack, &operator_stack, 'A', *op, *num1, *num2, result) != 0) {
+            steps_lost = 1;
+        }
+        operations++;
+
         free(op);
         free(num1);
         free(num2);
     }
 
+    stats_steps(operations);
+
     // Get final result
     double *final_result;
     stack_pop(&number_stack, (void**)&final_result);
@@ -576,7 +984,8 @@ double evaluate_expression(DList *tokens, Queue *steps) {
 double apply_operation(char op, double a, double b) {
     switch(op) {
         case '+': return a + b;
-        case '-': return a - b;
+        case '-':
+        case NEGATE: return a - b;
         case '*': return a * b;
         case '/':
             if(b == 0) {
@@ -592,8 +1001,8 @@ double apply_operation(char op, double a, double b) {
 }
 
 // Show evaluation steps
-void show_steps(Queue *steps) {
-    ListNode *current = list_head(steps);
+void show_steps(StepTrace *steps) {
+    int i;
     int step_number = 1;
 
     // Table header
@@ -605,9 +1014,9 @@ void show_steps(Queue *steps) {
     printf("+--------+-----------------+------------+-----------------+-----------------+\n");
     reset_color();
 
-    while(current != NULL) {
-        Step *step = (Step*)list_data(current);
-        if (step != NULL) {
+    for(i = 0; i < steptrace_size(steps); i++) {
+        Step *step = (Step*)steptrace_at(steps, i);
+        if (step != NULL && step->kind == 'A') {
             printf("| ");
             set_blue();
             printf("%-6d", step_number++);
@@ -630,7 +1039,276 @@ void show_steps(Queue *steps) {
             reset_color();
             printf(" |\n");
         }
-        current = list_next(current);
+    }
+}
+
+// Find the 'A' steps of a trace, marking every ROW_MARK-th
+int step_rows_init(StepRows *rows, StepTrace *steps) {
+    int i, capacity = 0;
+    int *marks;
+    Step *step;
+
+    rows->steps = steps;
+    rows->rows = 0;
+    rows->marks = NULL;
+    rows->row = -1;
+    rows->index = -1;
+
+    for(i = 0; i < steptrace_size(steps); i++) {
+        if((step = (Step*)steptrace_at(steps, i)) == NULL) return -1;
+        if(step->kind != 'A') continue;
+
+        if(rows->rows % ROW_MARK == 0) {
+            if(rows->rows / ROW_MARK == capacity) {
+                capacity = capacity == 0 ? 16 : capacity * 2;
+                if((marks = (int*)realloc(rows->marks, capacity * sizeof(int))) == NULL) return -1;
+                rows->marks = marks;
+            }
+            rows->marks[rows->rows / ROW_MARK] = i;
+        }
+
+        rows->rows++;
+    }
+
+    return 0;
+}
+
+void step_rows_destroy(StepRows *rows) {
+    free(rows->marks);
+    rows->marks = NULL;
+    rows->rows = 0;
+}
+
+// Format row of the table: from the row before when it was the last one
+// rendered, from its mark otherwise
+int render_step_row(void *data, int row, char *line, int size) {
+    StepRows *rows = (StepRows*)data;
+    Step *step = NULL;
+    int index, skip;
+
+    if(row < 0 || row >= rows->rows) return -1;
+
+    if(row == rows->row + 1 && rows->row >= 0) {
+        index = rows->index + 1;
+        skip = 0;
+    } else {
+        index = rows->marks[row / ROW_MARK];
+        skip = row % ROW_MARK;
+    }
+
+    for(; index < steptrace_size(rows->steps); index++) {
+        if((step = (Step*)steptrace_at(rows->steps, index)) == NULL) return -1;
+        if(step->kind == 'A' && skip-- == 0) break;
+    }
+
+    if(index == steptrace_size(rows->steps)) return -1;
+
+    rows->row = row;
+    rows->index = index;
+    snprintf(line, size, "| %-6d | %-15.4f | %-10c | %-15.4f | %-15.4f |",
+             row + 1, step->operand1, step->operator, step->operand2, step->result);
+
+    return 0;
+}
+
+// Show the steps, a page at a time when they do not fit in one
+void view_steps(StepTrace *steps) {
+    StepRows rows;
+    StepView view;
+    char line[MAX_EXPR];
+    unsigned long long phase;
+    int status = 0;
+
+    if(step_rows_init(&rows, steps) != 0 || rows.rows <= VIEW_HEIGHT) {
+        step_rows_destroy(&rows);
+        phase = stats_phase_begin(STATS_RENDER);
+        show_steps(steps);
+        stats_phase_end(STATS_RENDER, phase);
+        return;
+    }
+
+    stepview_init(&view, rows.rows, VIEW_HEIGHT, render_step_row, &rows);
+
+    while(status != STEPVIEW_QUIT) {
+        set_green();
+        printf("| %-6s | %-15s | %-10s | %-15s | %-15s |\n",
+               "Step", "Operand 1", "Operator", "Operand 2", "Result");
+        printf("+--------+-----------------+------------+-----------------+-----------------+\n");
+        reset_color();
+
+        phase = stats_phase_begin(STATS_RENDER);
+        stepview_draw(&view, stdout);
+        stats_phase_end(STATS_RENDER, phase);
+
+        set_yellow();
+        printf("Rows %d-%d of %d (Enter next page, p previous, g K row K, /text search, q quit): ",
+               stepview_top(&view) + 1, stepview_bottom(&view), stepview_rows(&view));
+        reset_color();
+
+        if(fgets(line, MAX_EXPR, stdin) == NULL) break;
+        line[strcspn(line, "\n")] = 0;
+
+        if((status = stepview_command(&view, line)) < 0) {
+            set_red();
+            printf("    Nothing for '%s'.\n", line);
+            reset_color();
+        }
+    }
+
+    step_rows_destroy(&rows);
+}
+
+// Append a step; at every interval also keep the stacks as they are
+// after it: the counts, the numbers, then the operators, bottom first.
+// -1 when the step or its checkpoint could not be kept
+int record_step(StepTrace *steps, Stack *number_stack, Stack *operator_stack,
+                 char kind, char operator, double operand1, double operand2, double result) {
+    Step step;
+    char checkpoint[2 * sizeof(int) + MAX_EXPR * (sizeof(double) + 1)];
+    double numbers[MAX_EXPR];
+    char operators[MAX_EXPR];
+    ListNode *node;
+    int n, m;
+    size_t length;
+
+    // Untraced evaluation
+    if(steps == NULL) return 0;
+
+    // A negation is shown as the subtraction from 0 it is
+    step.kind = kind;
+    step.operator = (kind == 'A' && operator == NEGATE) ? '-' : operator;
+    step.operand1 = operand1;
+    step.operand2 = operand2;
+    step.result = result;
+
+    if(steptrace_append(steps, &step) != 0) return -1;
+    if(!steptrace_due(steps)) return 0;
+
+    n = stack_size(number_stack);
+    m = stack_size(operator_stack);
+
+    if(n > MAX_EXPR || m > MAX_EXPR) return -1;
+
+    // The stacks are walked from the top
+    for(node = list_head(number_stack); node != NULL; node = list_next(node)) {
+        numbers[--n] = *(double*)list_data(node);
+    }
+    for(node = list_head(operator_stack); node != NULL; node = list_next(node)) {
+        operators[--m] = *(char*)list_data(node);
+    }
+
+    n = stack_size(number_stack);
+    m = stack_size(operator_stack);
+    memcpy(checkpoint, &n, sizeof(int));
+    memcpy(checkpoint + sizeof(int), &m, sizeof(int));
+    length = 2 * sizeof(int);
+    memcpy(checkpoint + length, numbers, n * sizeof(double));
+    length += n * sizeof(double);
+    memcpy(checkpoint + length, operators, m);
+    length += m;
+
+    return steptrace_checkpoint(steps, checkpoint, length);
+}
+
+// Load a checkpoint into an EvalState, empty stacks for NULL
+int restore_state(void *state, const void *checkpoint, size_t length) {
+    EvalState *eval = (EvalState*)state;
+    const char *bytes = (const char*)checkpoint;
+
+    eval->numbers = 0;
+    eval->operators = 0;
+
+    if(checkpoint == NULL) return 0;
+    if(length < 2 * sizeof(int)) return -1;
+
+    memcpy(&eval->numbers, bytes, sizeof(int));
+    memcpy(&eval->operators, bytes + sizeof(int), sizeof(int));
+
+    if(length != 2 * sizeof(int) + eval->numbers * sizeof(double) + eval->operators) return -1;
+
+    memcpy(eval->number, bytes + 2 * sizeof(int), eval->numbers * sizeof(double));
+    memcpy(eval->operator, bytes + 2 * sizeof(int) + eval->numbers * sizeof(double), eval->operators);
+
+    return 0;
+}
+
+// Replay one step on an EvalState
+int apply_step(void *state, const void *record) {
+    EvalState *eval = (EvalState*)state;
+    const Step *step = (const Step*)record;
+
+    switch(step->kind) {
+        case 'N':
+            if(eval->numbers == MAX_EXPR) return -1;
+            eval->number[eval->numbers++] = step->result;
+            return 0;
+        case 'O':
+            if(eval->operators == MAX_EXPR) return -1;
+            eval->operator[eval->operators++] = step->operator;
+            return 0;
+        case 'P':
+            if(eval->operators < 1) return -1;
+            eval->operators--;
+            return 0;
+        case 'A':
+            if(eval->operators < 1 || eval->numbers < 2) return -1;
+            eval->operators--;
+            eval->numbers--;
+            eval->number[eval->numbers - 1] = step->result;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// Show the stacks after any step, asked for by number until Enter
+void inspect_steps(StepTrace *steps) {
+    EvalState state;
+    char line[MAX_EXPR];
+    Step *step;
+    int k, i;
+
+    if(steps_lost) {
+        set_red();
+        printf("\n    Some steps could not be recorded, the stacks cannot be inspected.\n");
+        reset_color();
+        return;
+    }
+
+    while(steptrace_size(steps) > 0) {
+        printf("\n");
+        set_yellow();
+        printf("Inspect the stacks after step (1-%d, Enter to continue): ", steptrace_size(steps));
+        reset_color();
+
+        if(fgets(line, MAX_EXPR, stdin) == NULL || line[0] == '\n') break;
+
+        k = atoi(line);
+        if(k < 1 || k > steptrace_size(steps) ||
+           steptrace_state(steps, k - 1, &state, restore_state, apply_step) != 0) {
+            set_red();
+            printf("    No step %d.\n", k);
+            reset_color();
+            continue;
+        }
+
+        step = (Step*)steptrace_at(steps, k - 1);
+        set_blue();
+        switch(step->kind) {
+            case 'N': printf("    Step %d: push %.4f\n", k, step->result); break;
+            case 'O': printf("    Step %d: push operator %c\n", k, step->operator); break;
+            case 'P': printf("    Step %d: pop (\n", k); break;
+            default:
+                printf("    Step %d: %.4f %c %.4f = %.4f\n", k, step->operand1, step->operator, step->operand2,
+                       step->result);
+        }
+        reset_color();
+
+        printf("    Numbers   (bottom -> top):");
+        for(i = 0; i < state.numbers; i++) printf(" %.4f", state.number[i]);
+        printf("\n    Operators (bottom -> top):");
+        for(i = 0; i < state.operators; i++) printf(" %c", state.operator[i]);
+        printf("\n");
     }
 }
 
@@ -641,7 +1319,8 @@ int precedence(char op) {
         case '-': return 1;
         case '*':
         case '/': return 2;
-        case '^': return 3;
+        case NEGATE: return 3;
+        case '^': return 4;
         default: return 0;
     }
 }
@@ -651,29 +1330,18 @@ int is_operator(char c) {
     return (c == '+' || c == '-' || c == '*' || c == '/' || c == '^');
 }
 
-// Free token
-void free_token(void *data) {
-    free(data);
-}
-
-// Free step
-void free_step(void *data) {
-    free(data);
-}
-
 // NEW FUNCTIONS FOR FILE HANDLING
 
-void save_operations_to_file(Queue *steps, const char *expression, double result, const char *filename) {
-    FILE *file = fopen(filename, "a");
-    if(file == NULL) {
-        set_red();
-        printf("Error: Could not create/open the file '%s'\n", filename);
-        reset_color();
-        return;
-    }
+// Append the operations as one record of the log, found later by the
+// expression or the time
+int save_operations_to_file(StepTrace *steps, const char *expression, double result, OpLog *log) {
+    if(steps_lost) return -1;
 
-    // Write header with date and time
     time_t t = time(NULL);
+    FILE *file = oplog_begin(log, t, expression);
+    if(file == NULL) return -1;
+
+    // Write header with date and time
     struct tm *tm_info = localtime(&t);
     char buffer[80];
     strftime(buffer, 80, "%Y-%m-%d %H:%M:%S", tm_info);
@@ -691,18 +1359,18 @@ void save_operations_to_file(Queue *steps, const char *expression, double result
     fprintf(file, "FINAL RESULT: %.4f\n", result);
     fprintf(file, "==============================================\n\n");
 
-    fclose(file);
+    return oplog_end(log);
 }
 
-void show_steps_in_file(Queue *steps, FILE *file) {
+void show_steps_in_file(StepTrace *steps, FILE *file) {
     if (steps == NULL || file == NULL) return;
 
-    ListNode *current = list_head(steps);
+    int i;
     int step_number = 1;
 
-    while(current != NULL) {
-        Step *step = (Step*)list_data(current);
-        if (step != NULL) {
+    for(i = 0; i < steptrace_size(steps); i++) {
+        Step *step = (Step*)steptrace_at(steps, i);
+        if (step != NULL && step->kind == 'A') {
             fprintf(file, "Step %d: %.4f %c %.4f = %.4f\n",
                    step_number++,
                    step->operand1,
@@ -710,7 +1378,6 @@ void show_steps_in_file(Queue *steps, FILE *file) {
                    step->operand2,
                    step->result);
         }
-        current = list_next(current);
     }
 }
 
@@ -3,12 +3,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 // #include <windows.h> // Eliminado
 #include <math.h>
 #include "stack.h"
+#include "pstack.h"
 #include "dlist.h"
 #include "list.h"
+#include "stats.h"
 #define MAX_EXPR 256
+#define MAX_STEPS (MAX_EXPR * 3)
 
 // --- Definiciones de Secuencias VT100 ---
 #define RESET_COLOR "\033[0m"
@@ -232,6 +236,37 @@ int is_right_associative(char op) {
     return (op == '^');
 }
 
+/*
+    Stack symbol for c
+    The conversion stack points into this table, so its versions can
+    share nodes without owning any memory
+*/
+char *stack_symbol(char c) {
+    static char symbols[] = "()+-*/^";
+
+    return strchr(symbols, c);
+}
+
+/*
+    One row of the conversion table, kept to step back through it
+    stack is the version after the row, it shares its nodes with the
+    rows around it; the output only grows, so length is enough to
+    show it. highlight is 1 for a pushed top, 2 for a popped output
+*/
+typedef struct ConversionStep_ {
+    int step;
+    char action[32];
+    PStack stack;
+    int length;
+    int highlight;
+} ConversionStep;
+
+typedef struct ConversionTrace_ {
+    ConversionStep steps[MAX_STEPS];
+    int count;
+    char output[MAX_EXPR];
+} ConversionTrace;
+
 /*
     Function to evaluate postfix expression step by step - CORRECTED
     Now follows exactly the postfix evaluation algorithm
@@ -291,37 +326,22 @@ void evaluate_postfix_step_by_step(const char *postfix) {
         /* Show current step */
         printf("| %3d  | ", step);
         
-        /* Print stack content */
-        Stack temp_stack;
-        stack_init(&temp_stack, NULL);
-        
-        /* Count elements in stack */
+        /* Print stack content, top first, read in place */
         int stack_count = 0;
-        int *stack_elements[100];
-        
-        while (stack_size(&stack) > 0) {
-            int *elem;
-            stack_pop(&stack, (void **)&elem);
-            stack_elements[stack_count++] = elem;
-            stack_push(&temp_stack, elem);
-        }
-        
-        /* Restore original stack */
-        while (stack_size(&temp_stack) > 0) {
-            int *elem;
-            stack_pop(&temp_stack, (void **)&elem);
-            stack_push(&stack, elem);
+        int *stack_elements[MAX_EXPR];
+        ListNode *node;
+
+        for (node = list_head(&stack); node != NULL; node = list_next(node)) {
+            stack_elements[stack_count++] = (int *)list_data(node);
         }
-        
-        stack_destroy(&temp_stack);
-        
+
         /* Print stack from right to left */
         if (stack_count == 0) {
             printf("%-22s", "[Empty]");
         } else {
-            char stack_str[50] = "";
+            char stack_str[MAX_EXPR * 12] = "";
             for (int k = stack_count - 1; k >= 0; k--) {
-                char num_str[10];
+                char num_str[12];
                 sprintf(num_str, "%d", *stack_elements[k]);
                 strcat(stack_str, num_str);
                 if (k > 0) strcat(stack_str, " ");
@@ -447,38 +467,33 @@ void evaluate_postfix_step_by_step(const char *postfix) {
     printf(" |\n");
     printf("|                                                                                                 |\n");
     printf("+-------------------------------------------------------------------------------------------------+\n");
+
+    stats_steps(step - 1);
 }
 
 /*
     Print stack content
 */
-void print_stack(Stack *stack, char new_element, int highlight) {
-    Stack temp_stack;
-    char *op_ptr;
+void print_stack(const PStack *stack, char new_element, int highlight) {
+    PStackNode *node;
     char elements[MAX_EXPR];
     int count = 0;
     int i;
     int spaces;
     int total_length;
+    unsigned long long phase = stats_phase_begin(STATS_RENDER);
     
-    if (stack_size(stack) == 0) {
+    if (pstack_size(stack) == 0) {
         for (i = 0; i < 25; i++) printf(" ");
+        stats_phase_end(STATS_RENDER, phase);
         return;
     }
-    
-    stack_init(&temp_stack, NULL);
-    
-    while (stack_size(stack) > 0) {
-        stack_pop(stack, (void **)&op_ptr);
-        elements[count++] = *op_ptr;
-        stack_push(&temp_stack, op_ptr);
-    }
-    
-    while (stack_size(&temp_stack) > 0) {
-        stack_pop(&temp_stack, (void **)&op_ptr);
-        stack_push(stack, op_ptr);
+
+    /* The version is never changed, walk it from the top */
+    for (node = pstack_head(stack); node != NULL; node = pstack_next(node)) {
+        elements[count++] = *(char *)pstack_data(node);
     }
-    
+
     total_length = (count * 2) - 1;
     spaces = (25 - total_length) / 2;
     
@@ -504,8 +519,8 @@ void print_stack(Stack *stack, char new_element, int highlight) {
     for (i = 0; i < remaining_spaces; i++) {
         printf(" ");
     }
-    
-    stack_destroy(&temp_stack);
+
+    stats_phase_end(STATS_RENDER, phase);
 }
 
 /*
@@ -547,16 +562,82 @@ void print_colored_operation(const char *operation, int length, int highlight_la
     }
 }
 
+/*
+    Record a row of the conversion, trace may be NULL
+    Keeping the stack is one more reference to its version, O(1)
+*/
+void trace_record(ConversionTrace *trace, int step, const PStack *stack, int length, int highlight,
+                  const char *format, ...) {
+    ConversionStep *row;
+    va_list args;
+
+    if (trace == NULL || trace->count >= MAX_STEPS) return;
+
+    row = &trace->steps[trace->count++];
+    row->step = step;
+    row->length = length;
+    row->highlight = highlight;
+
+    va_start(args, format);
+    vsnprintf(row->action, sizeof(row->action), format, args);
+    va_end(args);
+
+    pstack_init(&row->stack, NULL);
+    pstack_copy(&row->stack, stack);
+}
+
+void trace_destroy(ConversionTrace *trace) {
+    int k;
+
+    for (k = 0; k < trace->count; k++) {
+        pstack_destroy(&trace->steps[k].stack);
+    }
+
+    trace->count = 0;
+}
+
+/*
+    Walk the recorded rows forward and backward
+*/
+void review_conversion(ConversionTrace *trace) {
+    ConversionStep *row;
+    char line[MAX_EXPR];
+    int k = 0;
+
+    while (trace->count > 0) {
+        row = &trace->steps[k];
+
+        printf("\n|  %3d  | %-24s |    ", row->step, row->action);
+        print_stack(&row->stack, row->highlight == 1 ? *(char *)pstack_peek(&row->stack) : '\0', row->highlight == 1);
+        printf(" | ");
+        print_colored_operation(trace->output, row->length, row->highlight == 2);
+        printf(" |\n");
+
+        yellow_color();
+        printf("  Row %d of %d - [n]ext, [p]revious, [q]uit: ", k + 1, trace->count);
+        normal_color();
+
+        if (fgets(line, MAX_EXPR, stdin) == NULL || line[0] == 'q' || line[0] == 'Q') break;
+
+        if (line[0] == 'p' || line[0] == 'P') {
+            if (k > 0) k--;
+        } else if (k < trace->count - 1) {
+            k++;
+        }
+    }
+}
+
 /*
     Convert infix to postfix - CORRECTED for ^ operator associativity
+    Every row goes to trace when it is not NULL
 */
-void infix_to_postfix(const char *infix, char *postfix) {
-    Stack stack;
+void infix_to_postfix(const char *infix, char *postfix, ConversionTrace *trace) {
+    PStack stack;
     int i, j = 0, step = 1;
     char temp_operation[MAX_EXPR] = "";
     int length = strlen(infix);
-    
-    stack_init(&stack, free);
+
+    pstack_init(&stack, NULL);
     
     printf("\n");
     green_color();
@@ -616,12 +697,11 @@ void infix_to_postfix(const char *infix, char *postfix) {
             printf(" | ");
             print_colored_operation(temp_operation, j, 0);
             printf(" |\n");
+            trace_record(trace, step, &stack, j, 0, "ADD [%s]", number);
         }
         /* If it's left parenthesis */
         else if (c == '(') {
-            char *op_ptr = (char *)malloc(sizeof(char));
-            *op_ptr = c;
-            stack_push(&stack, op_ptr);
+            pstack_push(&stack, &stack, stack_symbol(c));
             
             printf("PUSH [%c]            ", c);
             printf("|    ");
@@ -629,6 +709,7 @@ void infix_to_postfix(const char *infix, char *postfix) {
             printf(" | ");
             print_colored_operation(temp_operation, j, 0);
             printf(" |\n");
+            trace_record(trace, step, &stack, j, 1, "PUSH [%c]", c);
         }
         /* If it's right parenthesis */
         else if (c == ')') {
@@ -638,26 +719,27 @@ void infix_to_postfix(const char *infix, char *postfix) {
             printf(" | ");
             print_colored_operation(temp_operation, j, 0);
             printf(" |\n");
+            trace_record(trace, step, &stack, j, 0, "FOUND [%c]", c);
             
             printf("|-------+--------------------------+-------------------------+-----------------------------|\n");
             step++;
             
             /* Empty stack until '(' is found */
             char *op_ptr;
-            while (stack_size(&stack) > 0) {
-                char *top = (char *)stack_peek(&stack);
+            while (pstack_size(&stack) > 0) {
+                char *top = (char *)pstack_peek(&stack);
                 if (top && *top == '(') {
-                    stack_pop(&stack, (void **)&op_ptr);
-                    free(op_ptr);
+                    pstack_pop(&stack, &stack, (void **)&op_ptr);
                     printf("|  %3d  | POP [(]             ", step);
                     printf("|    ");
                     print_stack(&stack, '\0', 0);
                     printf(" | ");
                     print_colored_operation(temp_operation, j, 0);
                     printf(" |\n");
+                    trace_record(trace, step, &stack, j, 0, "POP [(]");
                     break;
                 } else {
-                    stack_pop(&stack, (void **)&op_ptr);
+                    pstack_pop(&stack, &stack, (void **)&op_ptr);
                     temp_operation[j++] = *op_ptr;
                     temp_operation[j++] = ' ';
                     temp_operation[j] = '\0';
@@ -668,8 +750,8 @@ void infix_to_postfix(const char *infix, char *postfix) {
                     printf(" | ");
                     print_colored_operation(temp_operation, j, 1);
                     printf(" |\n");
+                    trace_record(trace, step, &stack, j, 2, "POP [%c] (find '(')", *op_ptr);
                     
-                    free(op_ptr);
                     step++;
                 }
             }
@@ -679,8 +761,8 @@ void infix_to_postfix(const char *infix, char *postfix) {
         /* If it's an operator */
         else if (is_operator(c)) {
             /* For ^ operator (right-associative), special handling */
-            while (stack_size(&stack) > 0) {
-                char *top = (char *)stack_peek(&stack);
+            while (pstack_size(&stack) > 0) {
+                char *top = (char *)pstack_peek(&stack);
                 if (top && *top != '(') {
                     int prec_top = precedence(*top);
                     int prec_current = precedence(c);
@@ -689,7 +771,7 @@ void infix_to_postfix(const char *infix, char *postfix) {
                     if (prec_top > prec_current || 
                         (prec_top == prec_current && !is_right_associative(c))) {
                         char *op_ptr;
-                        stack_pop(&stack, (void **)&op_ptr);
+                        pstack_pop(&stack, &stack, (void **)&op_ptr);
                         temp_operation[j++] = *op_ptr;
                         temp_operation[j++] = ' ';
                         temp_operation[j] = '\0';
@@ -700,9 +782,10 @@ void infix_to_postfix(const char *infix, char *postfix) {
                         printf(" | ");
                         print_colored_operation(temp_operation, j, 1);
                         printf(" |\n");
+                        trace_record(trace, step, &stack, j, 2, "POP [%c] (prec %d>=%d)", *op_ptr,
+                                     precedence(*op_ptr), precedence(c));
                         printf("|  %3d  | ", step + 1);
                         
-                        free(op_ptr);
                         step++;
                     } else {
                         break;
@@ -713,9 +796,7 @@ void infix_to_postfix(const char *infix, char *postfix) {
             }
             
             /* PUSH current operator */
-            char *op_ptr = (char *)malloc(sizeof(char));
-            *op_ptr = c;
-            stack_push(&stack, op_ptr);
+            pstack_push(&stack, &stack, stack_symbol(c));
             
             printf("PUSH [%c]            ", c);
             printf("|    ");
@@ -723,6 +804,7 @@ void infix_to_postfix(const char *infix, char *postfix) {
             printf(" | ");
             print_colored_operation(temp_operation, j, 0);
             printf(" |\n");
+            trace_record(trace, step, &stack, j, 1, "PUSH [%c]", c);
         }
         
         if (i < length - 1) {
@@ -732,7 +814,7 @@ void infix_to_postfix(const char *infix, char *postfix) {
     }
     
     /* Empty remaining stack */
-    if (stack_size(&stack) > 0) {
+    if (pstack_size(&stack) > 0) {
         printf("|-------+--------------------------+-------------------------+-----------------------------|\n");
         yellow_color();
         printf("|       |     EMPTYING STACK       |                         |                             |\n");
@@ -740,9 +822,9 @@ void infix_to_postfix(const char *infix, char *postfix) {
         printf("|-------+--------------------------+-------------------------+-----------------------------|\n");
     }
     
-    while (stack_size(&stack) > 0) {
+    while (pstack_size(&stack) > 0) {
         char *op_ptr;
-        stack_pop(&stack, (void **)&op_ptr);
+        pstack_pop(&stack, &stack, (void **)&op_ptr);
         temp_operation[j++] = *op_ptr;
         temp_operation[j++] = ' ';
         temp_operation[j] = '\0';
@@ -753,17 +835,19 @@ void infix_to_postfix(const char *infix, char *postfix) {
         printf(" | ");
         print_colored_operation(temp_operation, j, 1);
         printf(" |\n");
+        trace_record(trace, step, &stack, j, 2, "FINAL POP [%c]", *op_ptr);
         
-        if (stack_size(&stack) > 0) {
+        if (pstack_size(&stack) > 0) {
             printf("|-------+--------------------------+-------------------------+-----------------------------|\n");
         }
         
-        free(op_ptr);
         step++;
     }
     
     printf("+-----------------------------------------------------------------------------------------------------------------+\n");
     
+    if (trace != NULL) strcpy(trace->output, temp_operation);
+
     /* Remove final space if exists */
     if (j > 0 && temp_operation[j-1] == ' ') {
         temp_operation[j-1] = '\0';
@@ -788,19 +872,63 @@ void infix_to_postfix(const char *infix, char *postfix) {
     printf("|                                                                                                 |\n");
     printf("+-------------------------------------------------------------------------------------------------+\n");
     
-    stack_destroy(&stack);
+    pstack_destroy(&stack);
+
+    stats_steps(step - 1);
+}
+
+/*
+    Headless mode: convert and evaluate every line of stdin
+    No banners or prompts, used by the benchmarks
+*/
+int run_headless(void) {
+    char infix[MAX_EXPR];
+    char postfix[MAX_EXPR];
+    unsigned long long phase;
+    int valid;
+
+    while (fgets(infix, MAX_EXPR, stdin) != NULL) {
+        infix[strcspn(infix, "\n")] = '\0';
+
+        if (infix[0] == '\0') continue;
+
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+
+        if (!valid) continue;
+
+        phase = stats_phase_begin(STATS_CONVERT);
+        infix_to_postfix(infix, postfix, NULL);
+        stats_phase_end(STATS_CONVERT, phase);
+
+        phase = stats_phase_begin(STATS_EVALUATE);
+        evaluate_postfix_step_by_step(postfix);
+        stats_phase_end(STATS_EVALUATE, phase);
+    }
+
+    return 0;
 }
 
 /*
     Main
+    Run with --headless to read expressions from stdin without prompts
 */
-int main(void) {
+int main(int argc, char *argv[]) {
     char infix[MAX_EXPR];
     char postfix[MAX_EXPR];
     char continue_choice;
+    unsigned long long phase;
+    int valid;
+    static ConversionTrace trace;
     
     // init_colors(); // Quitamos la inicialización de Windows
     
+    stats_init();
+
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+        return run_headless();
+
     do {
         clear_screen(); // Limpieza portable
         // system("cls"); // Quitamos dependencia de windows
@@ -842,7 +970,10 @@ int main(void) {
         
         infix[strcspn(infix, "\n")] = '\0';
         
-        if (!validate_syntax(infix)) {
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+        if (!valid) {
             printf("\n");
             red_color();
             printf("  The expression contains errors. Please correct the syntax.\n");
@@ -860,7 +991,9 @@ int main(void) {
             continue;
         }
         
-        infix_to_postfix(infix, postfix);
+        phase = stats_phase_begin(STATS_CONVERT);
+        infix_to_postfix(infix, postfix, &trace);
+        stats_phase_end(STATS_CONVERT, phase);
         
         printf("\n");
         green_color();
@@ -889,16 +1022,25 @@ int main(void) {
         green_color();
         printf("  Conversion completed successfully\n");
         normal_color();
-        
+
         /* Perform step-by-step evaluation */
+        phase = stats_phase_begin(STATS_EVALUATE);
         evaluate_postfix_step_by_step(postfix);
+        stats_phase_end(STATS_EVALUATE, phase);
         
-        printf("\n");
-        yellow_color();
-        printf("  Do you want to convert another expression? (y/n): ");
-        normal_color();
-        continue_choice = getchar();
-        while (getchar() != '\n');
+        /* 'r' steps through the conversion again before asking once more */
+        do {
+            printf("\n");
+            yellow_color();
+            printf("  Do you want to convert another expression? (y/n, r to review the conversion): ");
+            normal_color();
+            continue_choice = getchar();
+            while (getchar() != '\n');
+
+            if (continue_choice == 'r' || continue_choice == 'R')
+                review_conversion(&trace);
+        } while (continue_choice == 'r' || continue_choice == 'R');
+        trace_destroy(&trace);
         
     } while (continue_choice == 'y' || continue_choice == 'Y');
     
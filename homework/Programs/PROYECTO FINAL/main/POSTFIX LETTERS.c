@@ -6,6 +6,7 @@
 #include "stack.h"
 #include "dlist.h"
 #include "list.h"
+#include "stats.h"
 #define MAX_EXPR 256
 
 // --- VT100 Sequence Definitions ---
@@ -203,9 +204,11 @@ void print_stack(Stack *stack, char new_element, int highlight) {
     int i;
     int spaces;
     int total_length;
+    unsigned long long phase = stats_phase_begin(STATS_RENDER);
 
     if (stack_size(stack) == 0) {
         for (i = 0; i < 25; i++) printf(" ");
+        stats_phase_end(STATS_RENDER, phase);
         return;
     }
 
@@ -249,6 +252,7 @@ void print_stack(Stack *stack, char new_element, int highlight) {
     }
 
     stack_destroy(&temp_stack);
+    stats_phase_end(STATS_RENDER, phase);
 }
 
 /*
@@ -513,6 +517,8 @@ void infix_to_postfix(const char *infix, char *postfix) {
     printf("+-------------------------------------------------------------------------------------------------+\n");
 
     stack_destroy(&stack);
+
+    stats_steps(step - 1);
 }
 
 /*
@@ -567,6 +573,9 @@ void verify_postfix(const char *postfix) {
             }
         }
 
+        /* Characters examined by this pass, the whole loop is quadratic */
+        stats_scan(i);
+
         if (!found) {
             /* Check if any unprocessed operator remains */
             for (i = 0; i < len; i++) {
@@ -662,15 +671,67 @@ void verify_postfix(const char *postfix) {
         printf("  WARNING! The expression could not be completely reduced.\n");
         reset_color();
     }
+
+    stats_steps(step - 1);
+}
+
+/*
+    Headless mode: convert and evaluate every line of stdin
+    No banners or prompts, used by the benchmarks
+*/
+int run_headless(void) {
+    char infix[MAX_EXPR];
+    char postfix[MAX_EXPR];
+    unsigned long long phase;
+    int valid;
+    int i;
+
+    while (fgets(infix, MAX_EXPR, stdin) != NULL) {
+        infix[strcspn(infix, "\n")] = '\0';
+
+        if (infix[0] == '\0') continue;
+
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = 1;
+        for (i = 0; infix[i] != '\0'; i++) {
+            if (infix[i] != ' ' && !isalpha(infix[i]) && !is_operator(infix[i]) &&
+                infix[i] != '(' && infix[i] != ')') {
+                valid = 0;
+                break;
+            }
+        }
+        if (valid)
+            valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+
+        if (!valid) continue;
+
+        phase = stats_phase_begin(STATS_CONVERT);
+        infix_to_postfix(infix, postfix);
+        stats_phase_end(STATS_CONVERT, phase);
+
+        phase = stats_phase_begin(STATS_EVALUATE);
+        verify_postfix(postfix);
+        stats_phase_end(STATS_EVALUATE, phase);
+    }
+
+    return 0;
 }
 
 /*
     Main
+    Run with --headless to read expressions from stdin without prompts
 */
-int main(void) {
+int main(int argc, char *argv[]) {
     char infix[MAX_EXPR];
     char postfix[MAX_EXPR];
     char continue_char;
+    unsigned long long phase;
+
+    stats_init();
+
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+        return run_headless();
 
     do {
         clear_screen();
@@ -765,7 +826,10 @@ int main(void) {
             continue;
         }
 
-        if (!validate_syntax(infix)) {
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+        if (!valid) {
             printf("\n");
             set_red();
             printf("  The expression contains errors. Please correct the syntax.\n");
@@ -783,10 +847,14 @@ int main(void) {
             continue;
         }
 
+        phase = stats_phase_begin(STATS_CONVERT);
         infix_to_postfix(infix, postfix);
+        stats_phase_end(STATS_CONVERT, phase);
 
         /* AUTOMATIC VERIFICATION - Always executed */
+        phase = stats_phase_begin(STATS_EVALUATE);
         verify_postfix(postfix);
+        stats_phase_end(STATS_EVALUATE, phase);
 
         printf("\n");
         set_green();
@@ -6,6 +6,7 @@
 #include "stack.h"
 #include "dlist.h"
 #include "list.h"
+#include "stats.h"
 #define MAX_EXPR 256
 
 // --- VT100 Sequence Definitions ---
@@ -223,10 +224,12 @@ void print_stack(Stack *stack, char new_element, int highlight) {
     int i;
     int spaces;
     int total_length;
+    unsigned long long phase = stats_phase_begin(STATS_RENDER);
     
     if (stack_size(stack) == 0) {
         /* When stack is empty, print centered spaces */
         for (i = 0; i < 25; i++) printf(" ");
+        stats_phase_end(STATS_RENDER, phase);
         return;
     }
     
@@ -281,6 +284,7 @@ void print_stack(Stack *stack, char new_element, int highlight) {
     }
     
     stack_destroy(&temp_stack);
+    stats_phase_end(STATS_RENDER, phase);
 }
 
 /*
@@ -579,6 +583,8 @@ void infix_to_prefix(const char *infix, char *prefix) {
     
     /* Destroy stack */
     stack_destroy(&stack);
+
+    stats_steps(step - 1);
 }
 
 /*
@@ -689,6 +695,9 @@ void evaluate_prefix(const char *prefix) {
                 break;  /* Restart search from the beginning */
             }
         }
+
+        /* Characters examined by this pass, the whole loop is quadratic */
+        stats_scan(i);
     }
     
     printf("+-------------------------------------------------------------------------------------------------+\n");
@@ -727,16 +736,59 @@ void evaluate_prefix(const char *prefix) {
     set_green();
     printf("+-------------------------------------------------------------------------------------------------+\n");
     reset_color();
+
+    stats_steps(step - 1);
+}
+
+/*
+    Headless mode: convert and evaluate every line of stdin
+    No banners or prompts, used by the benchmarks
+*/
+int run_headless(void) {
+    char infix[MAX_EXPR];
+    char prefix[MAX_EXPR];
+    unsigned long long phase;
+    int valid;
+
+    while (fgets(infix, MAX_EXPR, stdin) != NULL) {
+        infix[strcspn(infix, "\n")] = '\0';
+
+        if (infix[0] == '\0') continue;
+
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+
+        if (!valid) continue;
+
+        phase = stats_phase_begin(STATS_CONVERT);
+        infix_to_prefix(infix, prefix);
+        stats_phase_end(STATS_CONVERT, phase);
+
+        phase = stats_phase_begin(STATS_EVALUATE);
+        evaluate_prefix(prefix);
+        stats_phase_end(STATS_EVALUATE, phase);
+    }
+
+    return 0;
 }
 
 /*
     Main
+    Run with --headless to read expressions from stdin without prompts
 */
-int main(void) {
+int main(int argc, char *argv[]) {
     char infix[MAX_EXPR];
     char prefix[MAX_EXPR];
     char continue_char;
+    unsigned long long phase;
+    int valid;
     
+    stats_init();
+
+    if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+        return run_headless();
+
     do {
         clear_screen();  /* Clear screen on each iteration - Portable version */
         
@@ -805,7 +857,10 @@ int main(void) {
         infix[strcspn(infix, "\n")] = '\0';
         
         /* VALIDATE SYNTAX BEFORE CONVERTING */
-        if (!validate_syntax(infix)) {
+        phase = stats_phase_begin(STATS_VALIDATE);
+        valid = validate_syntax(infix);
+        stats_phase_end(STATS_VALIDATE, phase);
+        if (!valid) {
             printf("\n");
             set_red();
             printf("  The expression contains errors. Please correct the syntax.\n");
@@ -824,7 +879,9 @@ int main(void) {
         }
         
         /* Convert to prefix */
+        phase = stats_phase_begin(STATS_CONVERT);
         infix_to_prefix(infix, prefix);
+        stats_phase_end(STATS_CONVERT, phase);
         
         printf("\n");
         set_green();
@@ -855,7 +912,9 @@ int main(void) {
         reset_color();
         
         /* Perform prefix expression verification */
+        phase = stats_phase_begin(STATS_EVALUATE);
         evaluate_prefix(prefix);
+        stats_phase_end(STATS_EVALUATE, phase);
         
         printf("\n");
         set_yellow();
@@ -0,0 +1,238 @@
+/*
+    bqueue.c
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "queue.h"
+#include "bqueue.h"
+
+/*
+    Absolute deadline timeout_ms from now, for pthread_cond_timedwait
+*/
+static void bqueue_deadline (struct timespec *deadline, long timeout_ms) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+
+    return;
+}
+
+/*
+    Sleep on cond, returns -1 once the deadline passed
+    Called with the mutex held
+*/
+static int bqueue_wait (BQueue *bqueue, pthread_cond_t *cond, int *waiting,
+                        const struct timespec *deadline) {
+    int retval;
+
+    (*waiting)++;
+
+    if (deadline == NULL)
+        retval = pthread_cond_wait(cond, &bqueue->mutex);
+    else
+        retval = pthread_cond_timedwait(cond, &bqueue->mutex, deadline);
+
+    (*waiting)--;
+
+    return retval == ETIMEDOUT ? -1 : 0;
+}
+
+#define bqueue_full(bqueue) \
+    ((bqueue)->capacity > 0 && queue_size(&(bqueue)->queue) >= (bqueue)->capacity)
+
+/*
+    Pass the wakeup on while there is still something for the next
+    sleeper, so a batch wakes only the threads it can feed
+    Called with the mutex held
+*/
+static void bqueue_wake (BQueue *bqueue) {
+    if (bqueue->waiting_consumers > 0 && queue_size(&bqueue->queue) > 0)
+        pthread_cond_signal(&bqueue->not_empty);
+
+    if (bqueue->waiting_producers > 0 && !bqueue_full(bqueue))
+        pthread_cond_signal(&bqueue->not_full);
+
+    return;
+}
+
+/*
+    Initialize, capacity 0 for an unbounded queue
+*/
+int bqueue_init (BQueue *bqueue, int capacity, void (*destroy)(void *data)) {
+    memset(bqueue, 0, sizeof(BQueue));
+
+    if (pthread_mutex_init(&bqueue->mutex, NULL) != 0)
+        return -1;
+
+    if (pthread_cond_init(&bqueue->not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&bqueue->mutex);
+        return -1;
+    }
+
+    if (pthread_cond_init(&bqueue->not_full, NULL) != 0) {
+        pthread_cond_destroy(&bqueue->not_empty);
+        pthread_mutex_destroy(&bqueue->mutex);
+        return -1;
+    }
+
+    queue_init(&bqueue->queue, destroy);
+    bqueue->capacity = capacity > 0 ? capacity : 0;
+
+    return 0;
+}
+
+/*
+    Destroy, no thread may be waiting on the queue
+*/
+void bqueue_destroy (BQueue *bqueue) {
+    queue_destroy(&bqueue->queue);
+
+    pthread_cond_destroy(&bqueue->not_full);
+    pthread_cond_destroy(&bqueue->not_empty);
+    pthread_mutex_destroy(&bqueue->mutex);
+
+    memset(bqueue, 0, sizeof(BQueue));
+
+    return;
+}
+
+/*
+    Enqueue, waits while the queue is full
+*/
+int bqueue_enqueue (BQueue *bqueue, const void *data, long timeout_ms) {
+    int retval = bqueue_enqueue_many(bqueue, (void **)&data, 1, timeout_ms);
+
+    return retval == 1 ? 0 : retval == 0 ? BQUEUE_TIMEOUT : -1;
+}
+
+/*
+    Dequeue, waits while the queue is empty
+*/
+int bqueue_dequeue (BQueue *bqueue, void **data, long timeout_ms) {
+    int retval = bqueue_dequeue_many(bqueue, data, 1, timeout_ms);
+
+    return retval == 1 ? 0 : retval == 0 ? BQUEUE_TIMEOUT : -1;
+}
+
+/*
+    Enqueue count elements under one lock, waiting for room as needed
+    Returns how many were enqueued before a timeout or close
+*/
+int bqueue_enqueue_many (BQueue *bqueue, void **items, int count, long timeout_ms) {
+    struct timespec deadline;
+    int done = 0;
+
+    if (timeout_ms > 0)
+        bqueue_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&bqueue->mutex);
+
+    while (done < count && !bqueue->closed) {
+        if (bqueue_full(bqueue)) {
+            // Let the consumers in before sleeping on the partial batch
+            bqueue_wake(bqueue);
+
+            if (timeout_ms == 0)
+                break;
+
+            bqueue->producer_waits++;
+
+            if (bqueue_wait(bqueue, &bqueue->not_full, &bqueue->waiting_producers,
+                            timeout_ms < 0 ? NULL : &deadline) != 0)
+                break;
+
+            continue;
+        }
+
+        if (queue_enqueue(&bqueue->queue, items[done]) != 0)
+            break;
+
+        done++;
+    }
+
+    if (done == 0 && bqueue->closed)
+        done = -1;
+
+    bqueue_wake(bqueue);
+    pthread_mutex_unlock(&bqueue->mutex);
+
+    return done;
+}
+
+/*
+    Dequeue up to max elements under one lock, waits for the first one
+    Returns 0 on timeout and -1 once the queue is closed and drained
+*/
+int bqueue_dequeue_many (BQueue *bqueue, void **items, int max, long timeout_ms) {
+    struct timespec deadline;
+    int done = 0;
+
+    if (timeout_ms > 0)
+        bqueue_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&bqueue->mutex);
+
+    while (queue_size(&bqueue->queue) == 0) {
+        if (bqueue->closed) {
+            pthread_mutex_unlock(&bqueue->mutex);
+            return -1;
+        }
+
+        if (timeout_ms == 0)
+            break;
+
+        bqueue->consumer_waits++;
+
+        if (bqueue_wait(bqueue, &bqueue->not_empty, &bqueue->waiting_consumers,
+                        timeout_ms < 0 ? NULL : &deadline) != 0)
+            break;
+    }
+
+    while (done < max && queue_dequeue(&bqueue->queue, &items[done]) == 0)
+        done++;
+
+    bqueue_wake(bqueue);
+    pthread_mutex_unlock(&bqueue->mutex);
+
+    return done;
+}
+
+/*
+    Close, wakes every waiting thread
+*/
+void bqueue_close (BQueue *bqueue) {
+    pthread_mutex_lock(&bqueue->mutex);
+
+    __atomic_store_n(&bqueue->closed, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&bqueue->not_empty);
+    pthread_cond_broadcast(&bqueue->not_full);
+
+    pthread_mutex_unlock(&bqueue->mutex);
+
+    return;
+}
+
+/*
+    Number of elements, a snapshot
+*/
+int bqueue_size (BQueue *bqueue) {
+    int size;
+
+    pthread_mutex_lock(&bqueue->mutex);
+    size = queue_size(&bqueue->queue);
+    pthread_mutex_unlock(&bqueue->mutex);
+
+    return size;
+}
@@ -0,0 +1,299 @@
+/*
+    clist.c
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "clist.h"
+
+#define CLIST_MAGIC 0x54534C43u
+
+/*
+    Image written by clist_save, followed by the node array
+*/
+typedef struct CListImage_ {
+    uint32_t magic;
+    uint32_t elem_size;
+    uint32_t stride;
+    uint32_t size;
+    uint32_t used;
+    CListHandle head;
+    CListHandle tail;
+    CListHandle free;
+} CListImage;
+
+/*
+    A handle an image may hold: none, or a node it has
+*/
+#define clist_valid(list, node) ((node) == CLIST_NIL || (node) < (list)->used)
+
+/*
+    Every link of a loaded clist points at one of its nodes
+*/
+static int clist_check (const CList *list) {
+    CListLink *link;
+    uint32_t node;
+
+    if ((uint32_t)list->size > list->used || !clist_valid(list, list->head) || !clist_valid(list, list->tail)
+        || !clist_valid(list, list->free))
+        return -1;
+
+    for (node = 0; node < list->used; node++) {
+        link = clist_link(list, node);
+
+        if (!clist_valid(list, link->prev) || !clist_valid(list, link->next))
+            return -1;
+    }
+
+    return 0;
+}
+
+/*
+    Take a node from the free list, or the next unused one, growing
+    the array when full
+*/
+static CListHandle clist_alloc (CList *list) {
+    unsigned char *nodes;
+    uint32_t capacity;
+    CListHandle node;
+
+    if (list->free != CLIST_NIL) {
+        node = list->free;
+        list->free = clist_link(list, node)->next;
+        return node;
+    }
+
+    if (list->used == list->capacity) {
+        if (list->capacity >= CLIST_NIL / 2)
+            return CLIST_NIL;
+
+        capacity = list->capacity * 2;
+
+        if ((nodes = (unsigned char *)realloc(list->nodes, (size_t)capacity * list->stride)) == NULL)
+            return CLIST_NIL;
+
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+
+    return list->used++;
+}
+
+/*
+    Initialize for elements of elem_size bytes, room for capacity nodes
+*/
+int clist_init (CList *list, size_t elem_size, uint32_t capacity) {
+    memset(list, 0, sizeof(CList));
+
+    list->elem_size = elem_size;
+
+    // Keep every header aligned to 8 bytes
+    list->stride = (sizeof(CListLink) + elem_size + 7) & ~(size_t)7;
+
+    list->capacity = capacity > 0 ? capacity : 16;
+    list->head = CLIST_NIL;
+    list->tail = CLIST_NIL;
+    list->free = CLIST_NIL;
+
+    if ((list->nodes = (unsigned char *)malloc((size_t)list->capacity * list->stride)) == NULL)
+        return -1;
+
+    return 0;
+}
+
+/*
+    Destroying the clist, a single free
+*/
+void clist_destroy (CList *list) {
+    free(list->nodes);
+    memset(list, 0, sizeof(CList));
+
+    return;
+}
+
+/*
+    Insert next node at the clist
+*/
+int clist_ins_next (CList *list, CListHandle node, const void *data, CListHandle *handle) {
+    CListHandle new_node;
+    CListLink *link;
+
+    // Do not allow a NIL node unless the list is empty
+    if (node == CLIST_NIL && clist_size(list) != 0)
+        return -1;
+
+    if ((new_node = clist_alloc(list)) == CLIST_NIL)
+        return -1;
+
+    memcpy(clist_data(list, new_node), data, list->elem_size);
+    link = clist_link(list, new_node);
+
+    if (clist_size(list) == 0) {
+        link->prev = CLIST_NIL;
+        link->next = CLIST_NIL;
+        list->head = new_node;
+        list->tail = new_node;
+    } else {
+        link->next = clist_next(list, node);
+        link->prev = node;
+
+        if (link->next == CLIST_NIL)
+            list->tail = new_node;
+        else
+            clist_link(list, link->next)->prev = new_node;
+
+        clist_link(list, node)->next = new_node;
+    }
+
+    list->size++;
+
+    if (handle != NULL)
+        *handle = new_node;
+
+    return 0;
+}
+
+/*
+    Insert previous node at the clist
+*/
+int clist_ins_prev (CList *list, CListHandle node, const void *data, CListHandle *handle) {
+    CListHandle new_node;
+    CListLink *link;
+
+    // Do not allow a NIL node unless the list is empty
+    if (node == CLIST_NIL && clist_size(list) != 0)
+        return -1;
+
+    if ((new_node = clist_alloc(list)) == CLIST_NIL)
+        return -1;
+
+    memcpy(clist_data(list, new_node), data, list->elem_size);
+    link = clist_link(list, new_node);
+
+    if (clist_size(list) == 0) {
+        link->prev = CLIST_NIL;
+        link->next = CLIST_NIL;
+        list->head = new_node;
+        list->tail = new_node;
+    } else {
+        link->next = node;
+        link->prev = clist_prev(list, node);
+
+        if (link->prev == CLIST_NIL)
+            list->head = new_node;
+        else
+            clist_link(list, link->prev)->next = new_node;
+
+        clist_link(list, node)->prev = new_node;
+    }
+
+    list->size++;
+
+    if (handle != NULL)
+        *handle = new_node;
+
+    return 0;
+}
+
+/*
+    Remove node at the clist, its handle goes to the free list
+*/
+int clist_remove (CList *list, CListHandle node, void *data) {
+    CListLink *link;
+
+    if (node == CLIST_NIL || clist_size(list) == 0)
+        return -1;
+
+    link = clist_link(list, node);
+
+    if (data != NULL)
+        memcpy(data, clist_data(list, node), list->elem_size);
+
+    if (link->prev == CLIST_NIL)
+        list->head = link->next;
+    else
+        clist_link(list, link->prev)->next = link->next;
+
+    if (link->next == CLIST_NIL)
+        list->tail = link->prev;
+    else
+        clist_link(list, link->next)->prev = link->prev;
+
+    link->prev = CLIST_NIL;
+    link->next = list->free;
+    list->free = node;
+    list->size--;
+
+    return 0;
+}
+
+/*
+    Bytes clist_save writes
+*/
+size_t clist_image_size (const CList *list) {
+    return sizeof(CListImage) + (size_t)list->used * list->stride;
+}
+
+/*
+    Write the clist to image, clist_image_size bytes
+*/
+void clist_save (const CList *list, void *image) {
+    CListImage header;
+
+    header.magic = CLIST_MAGIC;
+    header.elem_size = (uint32_t)list->elem_size;
+    header.stride = (uint32_t)list->stride;
+    header.size = (uint32_t)list->size;
+    header.used = list->used;
+    header.head = list->head;
+    header.tail = list->tail;
+    header.free = list->free;
+
+    memcpy(image, &header, sizeof(CListImage));
+    memcpy((unsigned char *)image + sizeof(CListImage), list->nodes, (size_t)list->used * list->stride);
+
+    return;
+}
+
+/*
+    Initialize the clist from an image made by clist_save
+    Returns -1 when the image is not a clist of the same layout, or
+    holds a handle to a node it does not have
+*/
+int clist_load (CList *list, const void *image, size_t bytes) {
+    CListImage header;
+
+    if (bytes < sizeof(CListImage))
+        return -1;
+
+    memcpy(&header, image, sizeof(CListImage));
+
+    if (header.magic != CLIST_MAGIC || header.used >= CLIST_NIL
+        || bytes != sizeof(CListImage) + (size_t)header.used * header.stride)
+        return -1;
+
+    if (clist_init(list, header.elem_size, header.used) != 0)
+        return -1;
+
+    if (list->stride != header.stride) {
+        clist_destroy(list);
+        return -1;
+    }
+
+    memcpy(list->nodes, (const unsigned char *)image + sizeof(CListImage),
+           (size_t)header.used * header.stride);
+
+    list->size = (int)header.size;
+    list->used = header.used;
+    list->head = header.head;
+    list->tail = header.tail;
+    list->free = header.free;
+
+    if (clist_check(list) != 0) {
+        clist_destroy(list);
+        return -1;
+    }
+
+    return 0;
+}
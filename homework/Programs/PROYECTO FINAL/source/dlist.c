@@ -1,10 +1,114 @@
 /*
     dlist.c
 */
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 #include "dlist.h"
+#include "stats.h"
+
+/*
+    Freed inline nodes kept for reuse by the same thread, an aligned
+    allocation costs several plain mallocs
+*/
+#define DLIST_SPARE_MAX 256
+
+static __thread DListNode *dlist_spare = NULL;
+static __thread int dlist_spare_size = 0;
+
+/*
+    Free a line from dlist_node_alloc
+*/
+static void dlist_block_free (DListNode *node) {
+
+#ifdef _WIN32
+    _aligned_free(node);
+#else
+    free(node);
+#endif
+
+    return;
+}
+
+/*
+    One cache-line aligned line for a node and its payload
+*/
+static DListNode *dlist_node_alloc (void) {
+    void *block;
+
+    if (dlist_spare != NULL) {
+        block = dlist_spare;
+        dlist_spare = dlist_spare->next;
+        dlist_spare_size--;
+        return (DListNode *)block;
+    }
+
+#ifdef _WIN32
+    block = _aligned_malloc(DLIST_CACHE_LINE, DLIST_CACHE_LINE);
+#else
+    if (posix_memalign(&block, DLIST_CACHE_LINE, DLIST_CACHE_LINE) != 0)
+        block = NULL;
+#endif
+
+    return (DListNode *)block;
+}
+
+/*
+    Free a node, with its payload when inline
+*/
+static void dlist_node_free (DListNode *node) {
+
+    if (!dlist_is_inline(node)) {
+        free(node);
+        return;
+    }
+
+    if (dlist_spare_size < DLIST_SPARE_MAX) {
+        node->next = dlist_spare;
+        dlist_spare = node;
+        dlist_spare_size++;
+        return;
+    }
+
+    dlist_block_free(node);
+
+    return;
+}
+
+/*
+    Link new_node after node, node is NULL only for an empty dlist
+*/
+static void dlist_link_next (DList *list, DListNode *node, DListNode *new_node) {
+
+    // The list is empty, insert at the head
+    if (dlist_size(list) == 0){
+        list->head = new_node;
+        list->head->prev = NULL;
+        list->head->next = NULL;
+        list->tail = new_node;
+        
+    } else {
+        new_node->next = node->next;
+        new_node->prev = node;
+
+        if (node->next == NULL)
+            list->tail = new_node;
+        else
+            node->next->prev = new_node;
+
+        node->next = new_node;
+    }
+
+    list->size++;
+
+    return;
+}
 
 /*
     Initialize the dlist
@@ -19,13 +123,16 @@ void dlist_init (DList *list, void (*destroy)(void *data)) {
 }
 
 /*
-    Destroying the dlist
+    Destroying the dlist, inline payloads go with their nodes
 */
 void dlist_destroy (DList *list) {
     void *data;
+    int is_inline;
 
     while(dlist_size(list) > 0) {
-        if (dlist_remove(list, dlist_tail(list), (void **)&data) == 0 && list->destroy != NULL) {
+        is_inline = dlist_is_inline(dlist_tail(list));
+
+        if (dlist_remove(list, dlist_tail(list), (void **)&data) == 0 && list->destroy != NULL && !is_inline) {
             list->destroy(data);
         }
     }    
@@ -46,28 +153,32 @@ int dlist_ins_next (DList *list, DListNode *node, const void *data ) {
     if ((new_node = (DListNode *)malloc(sizeof(DListNode))) == NULL)
         return -1;
 
+    stats_alloc(STATS_DLIST, sizeof(DListNode));
+
     new_node->data = (void *)data;
+    dlist_link_next(list, node, new_node);
 
-    // The list is empty, insert at the head
-    if (dlist_size(list) == 0){
-        list->head = new_node;
-        list->head->prev = NULL;
-        list->head->next = NULL;
-        list->tail = new_node;
-        
-    } else {
-        new_node->next = node->next;
-        new_node->prev = node;
+    return 0;
+}
 
-        if (node->next == NULL)
-            list->tail = new_node;
-        else
-            node->next->prev = new_node;
+/*
+    Insert next node with a copy of size bytes of data inside it
+*/
+int dlist_ins_next_copy (DList *list, DListNode *node, const void *data, size_t size) {
+    DListNode    *new_node;
 
-        node->next = new_node;
-    }
+    // Do not allow a NULL node unless the list is empty
+    if (node == NULL && dlist_size(list) != 0)
+        return -1;
 
-    list->size++;
+    if (size > DLIST_INLINE_MAX || (new_node = dlist_node_alloc()) == NULL)
+        return -1;
+
+    stats_alloc(STATS_DLIST, DLIST_CACHE_LINE);
+
+    memcpy(new_node->payload, data, size);
+    new_node->data = new_node->payload;
+    dlist_link_next(list, node, new_node);
 
     return 0;
 }
@@ -85,6 +196,8 @@ int dlist_ins_prev (DList *list, DListNode *node, const void *data ) {
     if ((new_node = (DListNode *)malloc(sizeof(DListNode))) == NULL)
         return -1;
 
+    stats_alloc(STATS_DLIST, sizeof(DListNode));
+
     new_node->data = (void *)data;
 
     // The list is empty, insert at the head
@@ -113,6 +226,7 @@ int dlist_ins_prev (DList *list, DListNode *node, const void *data ) {
 
 /*
     Remove node at the List
+    data is set to NULL for an inline node, its payload is freed with it
 */
 int dlist_remove (DList *list, DListNode *node, void **data) {
 
@@ -120,7 +234,7 @@ int dlist_remove (DList *list, DListNode *node, void **data) {
     if (node == NULL && dlist_size(list) == 0)
         return -1;
     
-    *data = node->data;
+    *data = dlist_is_inline(node) ? NULL : node->data;
 
     if (node == list->head) {
         list->head = node->next;
@@ -139,9 +253,210 @@ int dlist_remove (DList *list, DListNode *node, void **data) {
             node->next->prev = node->prev;
     }
 
-    free(node);
+    dlist_node_free(node);
+    stats_free(STATS_DLIST);
     list->size--;
 
     return 0;
 }
 
+/*
+    Remove node at the List, copying size bytes of its data out
+*/
+int dlist_remove_copy (DList *list, DListNode *node, void *data, size_t size) {
+    void *unused;
+
+    if (node == NULL || dlist_size(list) == 0)
+        return -1;
+
+    memcpy(data, node->data, size);
+
+    return dlist_remove(list, node, &unused);
+}
+
+/*
+    Free the spare nodes of the calling thread
+*/
+void dlist_spare_release (void) {
+    DListNode *node;
+
+    while ((node = dlist_spare) != NULL) {
+        dlist_spare = node->next;
+        dlist_block_free(node);
+    }
+
+    dlist_spare_size = 0;
+
+    return;
+}
+
+/*
+    Merge two sorted chains by their next links, a before b on ties
+*/
+static DListNode *dlist_merge (DListNode *a, DListNode *b, int (*compare)(const void *key1, const void *key2)) {
+    DListNode *head = NULL, **tail = &head;
+
+    while (a != NULL && b != NULL) {
+        if (compare(a->data, b->data) <= 0) {
+            *tail = a;
+            a = a->next;
+        } else {
+            *tail = b;
+            b = b->next;
+        }
+        tail = &(*tail)->next;
+    }
+
+    *tail = a != NULL ? a : b;
+
+    return head;
+}
+
+/*
+    Sort the first n nodes of a chain, *rest gets the node after them
+*/
+static DListNode *dlist_sort_nodes (DListNode *head, int n, DListNode **rest,
+                                    int (*compare)(const void *key1, const void *key2)) {
+    DListNode *left, *right;
+
+    if (n == 1) {
+        *rest = head->next;
+        head->next = NULL;
+        return head;
+    }
+
+    left = dlist_sort_nodes(head, n / 2, &right, compare);
+    right = dlist_sort_nodes(right, n - n / 2, rest, compare);
+
+    return dlist_merge(left, right, compare);
+}
+
+/*
+    Rebuild the prev links and the tail after sorting by next links
+*/
+static void dlist_fix_links (DList *list, DListNode *head) {
+    DListNode *node, *prev = NULL;
+
+    list->head = head;
+
+    for (node = head; node != NULL; node = node->next) {
+        node->prev = prev;
+        prev = node;
+    }
+
+    list->tail = prev;
+
+    return;
+}
+
+/*
+    Sort, top-down: halves of the dlist are sorted and merged
+*/
+void dlist_sort (DList *list, int (*compare)(const void *key1, const void *key2)) {
+    DListNode *rest;
+
+    if (dlist_size(list) < 2)
+        return;
+
+    dlist_fix_links(list, dlist_sort_nodes(list->head, dlist_size(list), &rest, compare));
+
+    return;
+}
+
+/*
+    Sort, bottom-up with bins of 2^i nodes, see list_sort_bottom_up
+*/
+void dlist_sort_bottom_up (DList *list, int (*compare)(const void *key1, const void *key2)) {
+    DListNode *bins[64], *node, *next, *carry;
+    int i, top = 0;
+
+    if (dlist_size(list) < 2)
+        return;
+
+    for (node = list->head; node != NULL; node = next) {
+        next = node->next;
+        node->next = NULL;
+        carry = node;
+
+        // Older runs go first, the sort stays stable
+        for (i = 0; i < top && bins[i] != NULL; i++) {
+            carry = dlist_merge(bins[i], carry, compare);
+            bins[i] = NULL;
+        }
+
+        if (i == top)
+            top++;
+
+        bins[i] = carry;
+    }
+
+    for (carry = NULL, i = 0; i < top; i++) {
+        if (bins[i] != NULL)
+            carry = carry == NULL ? bins[i] : dlist_merge(bins[i], carry, compare);
+    }
+
+    dlist_fix_links(list, carry);
+
+    return;
+}
+
+/*
+    Move all of other after node
+*/
+void dlist_splice (DList *list, DListNode *node, DList *other) {
+    DListNode *next;
+
+    if (dlist_size(other) == 0)
+        return;
+
+    next = node == NULL ? list->head : node->next;
+
+    other->head->prev = node;
+    other->tail->next = next;
+
+    if (node == NULL)
+        list->head = other->head;
+    else
+        node->next = other->head;
+
+    if (next == NULL)
+        list->tail = other->tail;
+    else
+        next->prev = other->tail;
+
+    list->size += other->size;
+
+    other->size = 0;
+    other->head = NULL;
+    other->tail = NULL;
+
+    return;
+}
+
+/*
+    Move all of other to the tail
+*/
+void dlist_concat (DList *list, DList *other) {
+    dlist_splice(list, dlist_tail(list), other);
+    return;
+}
+
+/*
+    Reverse the order of the nodes
+*/
+void dlist_reverse (DList *list) {
+    DListNode *node = list->head, *next;
+
+    while (node != NULL) {
+        next = node->next;
+        node->next = node->prev;
+        node->prev = next;
+        node = next;
+    }
+
+    node = list->head;
+    list->head = list->tail;
+    list->tail = node;
+
+    return;
+}
@@ -0,0 +1,303 @@
+/*
+    expr.c
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "expr.h"
+
+/* Tokens evaluated with the stacks on the C stack, longer ones use malloc */
+#define EXPR_LOCAL 256
+
+/*
+    Precedence of an operator token, a sign above * and / but below ^
+*/
+static int expr_precedence (char type, char op) {
+    if (type == 'U')
+        return 3;
+
+    switch (op) {
+        case '+':
+        case '-': return 1;
+        case '*':
+        case '/': return 2;
+        case '^': return 4;
+        default: return 0;
+    }
+}
+
+/*
+    Emit the number read so far
+*/
+static void expr_tokenizer_number (ExprTokenizer *tokenizer) {
+    ExprToken *token = &tokenizer->tokens[tokenizer->count++];
+
+    tokenizer->number[tokenizer->number_length] = '\0';
+    token->type = 'N';
+    token->op = '\0';
+    token->value = atof(tokenizer->number);
+
+    tokenizer->in_number = 0;
+    tokenizer->expect_operand = 0;
+
+    return;
+}
+
+/*
+    Start tokenizing into tokens
+*/
+void expr_tokenizer_init (ExprTokenizer *tokenizer, ExprToken *tokens, int capacity) {
+    tokenizer->tokens = tokens;
+    tokenizer->capacity = capacity;
+    tokenizer->count = 0;
+    tokenizer->expect_operand = 1;
+    tokenizer->error = 0;
+    tokenizer->in_number = 0;
+    tokenizer->number_length = 0;
+
+    return;
+}
+
+/*
+    Tokenize the next length bytes of text
+*/
+int expr_tokenizer_feed (ExprTokenizer *tokenizer, const char *text, size_t length) {
+    ExprToken *token;
+    size_t i;
+
+    if (tokenizer->error)
+        return -1;
+
+    for (i = 0; i < length; i++) {
+        char c = text[i];
+
+        if (tokenizer->in_number) {
+            if (isdigit((unsigned char)c) || c == '.') {
+                if (tokenizer->number_length < (int)sizeof(tokenizer->number) - 1)
+                    tokenizer->number[tokenizer->number_length++] = c;
+                continue;
+            }
+
+            expr_tokenizer_number(tokenizer);
+        }
+
+        if (isspace((unsigned char)c))
+            continue;
+
+        if (tokenizer->count == tokenizer->capacity) {
+            tokenizer->error = 1;
+            return -1;
+        }
+
+        token = &tokenizer->tokens[tokenizer->count];
+
+        if (isdigit((unsigned char)c) || c == '.') {
+            // Emitted at the first character after it
+            tokenizer->in_number = 1;
+            tokenizer->number_length = 1;
+            tokenizer->number[0] = c;
+            continue;
+        } else if (c == '(' || c == ')') {
+            token->type = 'P';
+            token->op = c;
+            tokenizer->expect_operand = (c == '(');
+        } else if (strchr("+-*/^", c) != NULL) {
+            // A sign where an operand is expected
+            token->type = (tokenizer->expect_operand && (c == '+' || c == '-')) ? 'U' : 'O';
+            token->op = c;
+            tokenizer->expect_operand = 1;
+        } else {
+            tokenizer->error = 1;
+            return -1;
+        }
+
+        tokenizer->count++;
+    }
+
+    return 0;
+}
+
+/*
+    End of the text, returns the number of tokens or -1
+*/
+int expr_tokenizer_finish (ExprTokenizer *tokenizer) {
+
+    if (tokenizer->error)
+        return -1;
+
+    if (tokenizer->in_number)
+        expr_tokenizer_number(tokenizer);
+
+    return tokenizer->count;
+}
+
+/*
+    Split text into tokens, returns the number of tokens
+    Returns -1 on an invalid character or when capacity is exceeded
+*/
+int expr_tokenize (const char *text, ExprToken *tokens, int capacity) {
+    ExprTokenizer tokenizer;
+
+    expr_tokenizer_init(&tokenizer, tokens, capacity);
+
+    if (expr_tokenizer_feed(&tokenizer, text, strlen(text)) != 0)
+        return -1;
+
+    return expr_tokenizer_finish(&tokenizer);
+}
+
+/*
+    Check the order of the tokens, 0 when valid and -1 otherwise
+*/
+int expr_validate (const ExprToken *tokens, int count) {
+    int expect_operand = 1;
+    int depth = 0;
+    int i;
+
+    if (count <= 0)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        switch (tokens[i].type) {
+            case 'N':
+                if (!expect_operand)
+                    return -1;
+                expect_operand = 0;
+                break;
+
+            case 'U':
+                if (!expect_operand)
+                    return -1;
+                break;
+
+            case 'O':
+                if (expect_operand)
+                    return -1;
+                expect_operand = 1;
+                break;
+
+            default:
+                if (tokens[i].op == '(') {
+                    if (!expect_operand)
+                        return -1;
+                    depth++;
+                } else {
+                    if (expect_operand || --depth < 0)
+                        return -1;
+                }
+                break;
+        }
+    }
+
+    return (depth == 0 && !expect_operand) ? 0 : -1;
+}
+
+/*
+    Apply the operator on top of the operator stack
+*/
+static int expr_apply (const ExprToken *op, double *values, int *size) {
+    double a, b;
+
+    if (op->type == 'U') {
+        if (*size < 1)
+            return -1;
+        if (op->op == '-')
+            values[*size - 1] = -values[*size - 1];
+        return 0;
+    }
+
+    if (*size < 2)
+        return -1;
+
+    b = values[--(*size)];
+    a = values[*size - 1];
+
+    switch (op->op) {
+        case '+': a = a + b; break;
+        case '-': a = a - b; break;
+        case '*': a = a * b; break;
+        case '/':
+            if (b == 0)
+                return -1;
+            a = a / b;
+            break;
+        case '^': a = pow(a, b); break;
+        default: return -1;
+    }
+
+    values[*size - 1] = a;
+
+    return 0;
+}
+
+/*
+    Evaluate validated tokens with two stacks (numbers and operators)
+    Returns -1 on division by zero
+*/
+int expr_evaluate (const ExprToken *tokens, int count, double *result) {
+    double local_values[EXPR_LOCAL];
+    const ExprToken *local_ops[EXPR_LOCAL];
+    double *values = local_values;
+    const ExprToken **ops = local_ops;
+    int values_size = 0, ops_size = 0;
+    int retval = 0;
+    int i, prec;
+
+    if (count > EXPR_LOCAL) {
+        values = (double *)malloc(count * sizeof(double));
+        ops = (const ExprToken **)malloc(count * sizeof(ExprToken *));
+
+        if (values == NULL || ops == NULL) {
+            free(values);
+            free(ops);
+            return -1;
+        }
+    }
+
+    for (i = 0; i < count && retval == 0; i++) {
+        const ExprToken *token = &tokens[i];
+
+        if (token->type == 'N') {
+            values[values_size++] = token->value;
+        } else if (token->type == 'U' || (token->type == 'P' && token->op == '(')) {
+            ops[ops_size++] = token;
+        } else if (token->type == 'O') {
+            prec = expr_precedence('O', token->op);
+
+            // Pop while the top binds tighter; ^ is right associative
+            while (ops_size > 0 && ops[ops_size - 1]->type != 'P' && retval == 0) {
+                int top = expr_precedence(ops[ops_size - 1]->type, ops[ops_size - 1]->op);
+
+                if (top < prec || (top == prec && token->op == '^'))
+                    break;
+
+                retval = expr_apply(ops[--ops_size], values, &values_size);
+            }
+
+            ops[ops_size++] = token;
+        } else {
+            while (ops_size > 0 && ops[ops_size - 1]->type != 'P' && retval == 0)
+                retval = expr_apply(ops[--ops_size], values, &values_size);
+
+            if (ops_size > 0)
+                ops_size--;
+        }
+    }
+
+    while (ops_size > 0 && retval == 0)
+        retval = expr_apply(ops[--ops_size], values, &values_size);
+
+    if (retval == 0 && values_size == 1)
+        *result = values[0];
+    else
+        retval = -1;
+
+    if (values != local_values) {
+        free(values);
+        free(ops);
+    }
+
+    return retval;
+}
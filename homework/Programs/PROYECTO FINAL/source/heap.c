@@ -0,0 +1,271 @@
+/*
+    heap.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "heap.h"
+
+/*
+    Room for at least count elements, the tree and the handles grow
+    together since there are never more live handles than elements
+*/
+static int heap_reserve (Heap *heap, int count) {
+    HeapEntry *tree;
+    int *where, capacity;
+
+    if (count <= heap->capacity)
+        return 0;
+
+    capacity = heap->capacity > 0 ? heap->capacity : 16;
+
+    while (capacity < count)
+        capacity *= 2;
+
+    if ((tree = (HeapEntry *)realloc(heap->tree, (size_t)capacity * sizeof(HeapEntry))) == NULL)
+        return -1;
+
+    heap->tree = tree;
+
+    if ((where = (int *)realloc(heap->where, (size_t)capacity * sizeof(int))) == NULL)
+        return -1;
+
+    heap->where = where;
+    heap->capacity = capacity;
+
+    return 0;
+}
+
+/*
+    A handle from the free chain, or a new one
+*/
+static int heap_new_handle (Heap *heap) {
+    int handle;
+
+    if (heap->free_handle < 0)
+        return heap->handles++;
+
+    handle = heap->free_handle;
+    heap->free_handle = heap->where[handle];
+
+    return handle;
+}
+
+/*
+    Put entry at slot and record the slot under its handle
+*/
+static void heap_place (Heap *heap, int slot, HeapEntry entry) {
+    heap->tree[slot] = entry;
+    heap->where[entry.handle] = slot;
+
+    return;
+}
+
+/*
+    Move the entry at slot up while it goes before its parent
+*/
+static int heap_sift_up (Heap *heap, int slot) {
+    HeapEntry entry = heap->tree[slot];
+    int parent;
+
+    while (slot > 0) {
+        parent = (slot - 1) / heap->arity;
+
+        if (heap->compare(entry.data, heap->tree[parent].data) <= 0)
+            break;
+
+        heap_place(heap, slot, heap->tree[parent]);
+        slot = parent;
+    }
+
+    heap_place(heap, slot, entry);
+
+    return slot;
+}
+
+/*
+    Move the entry at slot down while a child goes before it
+*/
+static int heap_sift_down (Heap *heap, int slot) {
+    HeapEntry entry = heap->tree[slot];
+    int first, last, child, best;
+
+    for (;;) {
+        first = slot * heap->arity + 1;
+
+        if (first >= heap->size)
+            break;
+
+        last = first + heap->arity < heap->size ? first + heap->arity : heap->size;
+
+        for (best = first, child = first + 1; child < last; child++) {
+            if (heap->compare(heap->tree[child].data, heap->tree[best].data) > 0)
+                best = child;
+        }
+
+        if (heap->compare(heap->tree[best].data, entry.data) <= 0)
+            break;
+
+        heap_place(heap, slot, heap->tree[best]);
+        slot = best;
+    }
+
+    heap_place(heap, slot, entry);
+
+    return slot;
+}
+
+/*
+    Take the entry at slot out, the last one fills the hole
+*/
+static void heap_take (Heap *heap, int slot, void **data) {
+    HeapEntry entry = heap->tree[slot];
+
+    *data = entry.data;
+    heap->where[entry.handle] = heap->free_handle;
+    heap->free_handle = entry.handle;
+
+    if (--heap->size > slot) {
+        heap_place(heap, slot, heap->tree[heap->size]);
+
+        if (heap_sift_up(heap, slot) == slot)
+            heap_sift_down(heap, slot);
+    }
+
+    return;
+}
+
+/*
+    Initialize the heap, arity 2 for a binary heap
+*/
+int heap_init (Heap *heap, int arity, int (*compare)(const void *key1, const void *key2),
+               void (*destroy)(void *data)) {
+    heap->size = 0;
+    heap->arity = arity >= 2 ? arity : 2;
+    heap->capacity = 0;
+    heap->compare = compare;
+    heap->destroy = destroy;
+    heap->tree = NULL;
+    heap->where = NULL;
+    heap->handles = 0;
+    heap->free_handle = -1;
+
+    return 0;
+}
+
+/*
+    Destroying the heap
+*/
+void heap_destroy (Heap *heap) {
+    int i;
+
+    if (heap->destroy != NULL) {
+        for (i = 0; i < heap_size(heap); i++)
+            heap->destroy(heap->tree[i].data);
+    }
+
+    free(heap->tree);
+    free(heap->where);
+    memset(heap, 0, sizeof(Heap));
+
+    return;
+}
+
+/*
+    Insert data into the heap
+*/
+int heap_insert (Heap *heap, const void *data, int *handle) {
+    HeapEntry entry;
+
+    if (heap_reserve(heap, heap->size + 1) != 0)
+        return -1;
+
+    entry.data = (void *)data;
+    entry.handle = heap_new_handle(heap);
+
+    heap_place(heap, heap->size, entry);
+    heap_sift_up(heap, heap->size++);
+
+    if (handle != NULL)
+        *handle = entry.handle;
+
+    return 0;
+}
+
+/*
+    Extract the top of the heap
+*/
+int heap_extract (Heap *heap, void **data) {
+
+    if (heap_size(heap) == 0)
+        return -1;
+
+    heap_take(heap, 0, data);
+
+    return 0;
+}
+
+/*
+    Restore the heap after the priority of the element changed
+*/
+int heap_update (Heap *heap, int handle) {
+    int slot;
+
+    if (handle < 0 || handle >= heap->handles)
+        return -1;
+
+    slot = heap->where[handle];
+
+    if (slot < 0 || slot >= heap->size || heap->tree[slot].handle != handle)
+        return -1;
+
+    if (heap_sift_up(heap, slot) == slot)
+        heap_sift_down(heap, slot);
+
+    return 0;
+}
+
+/*
+    Remove the element of handle wherever it is
+*/
+int heap_remove (Heap *heap, int handle, void **data) {
+    int slot;
+
+    if (handle < 0 || handle >= heap->handles)
+        return -1;
+
+    slot = heap->where[handle];
+
+    if (slot < 0 || slot >= heap->size || heap->tree[slot].handle != handle)
+        return -1;
+
+    heap_take(heap, slot, data);
+
+    return 0;
+}
+
+/*
+    Add count elements, then sift down every parent from the last one
+    (Floyd), O(n) instead of O(n log n) for inserting one by one
+*/
+int heap_build (Heap *heap, void **data, int count, int *handles) {
+    HeapEntry entry;
+    int i;
+
+    if (count < 0 || heap_reserve(heap, heap->size + count) != 0)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        entry.data = data[i];
+        entry.handle = heap_new_handle(heap);
+        heap_place(heap, heap->size++, entry);
+
+        if (handles != NULL)
+            handles[i] = entry.handle;
+    }
+
+    for (i = (heap->size - 2) / heap->arity; i >= 0 && heap->size > 1; i--)
+        heap_sift_down(heap, i);
+
+    return 0;
+}
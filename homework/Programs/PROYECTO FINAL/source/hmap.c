@@ -0,0 +1,361 @@
+/*
+    hmap.c
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "hmap.h"
+
+/*
+    Spread the bits of the user's hash: h1, the bits above the low 7,
+    picks the first group and h2, the low 7, goes in the control byte
+*/
+static uint64_t hmap_mix (size_t hash) {
+    uint64_t h = (uint64_t)hash;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+#define hmap_h1(h) ((size_t)((h) >> 7))
+#define hmap_h2(h) ((signed char)((h) & 0x7F))
+
+/*
+    Bit i set when control byte i of the group is h2
+*/
+static unsigned int hmap_group_match (const signed char *group, signed char h2) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+#else
+    unsigned int mask = 0;
+    int i;
+
+    for (i = 0; i < HMAP_GROUP; i++)
+        mask |= (unsigned int)(group[i] == h2) << i;
+
+    return mask;
+#endif
+}
+
+/*
+    Bit i set when slot i of the group is HMAP_EMPTY or HMAP_DELETED,
+    the only negative control bytes
+*/
+static unsigned int hmap_group_free (const signed char *group) {
+#ifdef __SSE2__
+    return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    unsigned int mask = 0;
+    int i;
+
+    for (i = 0; i < HMAP_GROUP; i++)
+        mask |= (unsigned int)(group[i] < 0) << i;
+
+    return mask;
+#endif
+}
+
+/*
+    Bit i set when slot i of the group is HMAP_EMPTY
+*/
+static unsigned int hmap_group_empty (const signed char *group) {
+    return hmap_group_match(group, HMAP_EMPTY);
+}
+
+/*
+    Index of the lowest set bit of a nonzero mask
+*/
+static int hmap_lowest_bit (unsigned int mask) {
+    int i = 0;
+
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        i++;
+    }
+
+    return i;
+}
+
+/*
+    Set the control byte of slot, and its copy past the end
+*/
+static void hmap_set_ctrl (HMap *map, int slot, signed char value) {
+    map->ctrl[slot] = value;
+
+    if (slot < HMAP_GROUP)
+        map->ctrl[map->capacity + slot] = value;
+
+    return;
+}
+
+/*
+    First free slot for hash: groups are probed at triangular steps,
+    which visit every group of a power of two table
+*/
+static int hmap_find_free (const HMap *map, uint64_t h) {
+    size_t mask = (size_t)map->capacity - 1, position = hmap_h1(h) & mask, step = 0;
+    unsigned int free_slots;
+
+    for (;;) {
+        if ((free_slots = hmap_group_free(map->ctrl + position)) != 0)
+            return (int)((position + (size_t)hmap_lowest_bit(free_slots)) & mask);
+
+        step += HMAP_GROUP;
+        position = (position + step) & mask;
+    }
+}
+
+/*
+    Slot of the element matching key, -1 when there is none
+*/
+static int hmap_find (const HMap *map, const void *key, uint64_t h) {
+    size_t mask = (size_t)map->capacity - 1, position = hmap_h1(h) & mask, step = 0;
+    unsigned int candidates;
+    int slot;
+
+    for (;;) {
+        candidates = hmap_group_match(map->ctrl + position, hmap_h2(h));
+
+        while (candidates != 0) {
+            slot = (int)((position + (size_t)hmap_lowest_bit(candidates)) & mask);
+
+            if (map->match(map->slots[slot], key))
+                return slot;
+
+            candidates &= candidates - 1;
+        }
+
+        // An empty slot ends the probe, the element would be before it
+        if (hmap_group_empty(map->ctrl + position) != 0)
+            return -1;
+
+        step += HMAP_GROUP;
+        position = (position + step) & mask;
+    }
+}
+
+/*
+    Room for 7/8 of the slots
+*/
+static int hmap_max_load (int capacity) {
+    return capacity - capacity / 8;
+}
+
+/*
+    Move every element into new arrays of capacity slots, dropping the
+    deleted markers on the way
+*/
+static int hmap_rehash (HMap *map, int capacity) {
+    signed char *old_ctrl = map->ctrl;
+    void **old_slots = map->slots;
+    int old_capacity = map->capacity, i, slot;
+    uint64_t h;
+
+    map->ctrl = (signed char *)malloc((size_t)capacity + HMAP_GROUP);
+    map->slots = (void **)malloc((size_t)capacity * sizeof(void *));
+
+    if (map->ctrl == NULL || map->slots == NULL) {
+        free(map->ctrl);
+        free(map->slots);
+        map->ctrl = old_ctrl;
+        map->slots = old_slots;
+        return -1;
+    }
+
+    memset(map->ctrl, HMAP_EMPTY, (size_t)capacity + HMAP_GROUP);
+    map->capacity = capacity;
+    map->growth_left = hmap_max_load(capacity) - map->size;
+
+    for (i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] < 0)
+            continue;
+
+        h = hmap_mix(map->hash(old_slots[i]));
+        slot = hmap_find_free(map, h);
+        hmap_set_ctrl(map, slot, hmap_h2(h));
+        map->slots[slot] = old_slots[i];
+    }
+
+    free(old_ctrl);
+    free(old_slots);
+
+    return 0;
+}
+
+/*
+    Initialize the hmap with room for capacity elements before growing
+*/
+int hmap_init (HMap *map, int capacity, size_t (*hash)(const void *key),
+               int (*match)(const void *key1, const void *key2), void (*destroy)(void *data)) {
+    int slots = HMAP_GROUP;
+
+    while (hmap_max_load(slots) < capacity && slots < (1 << 30))
+        slots *= 2;
+
+    map->capacity = 0;
+    map->size = 0;
+    map->hash = hash;
+    map->match = match;
+    map->destroy = destroy;
+    map->ctrl = NULL;
+    map->slots = NULL;
+
+    return hmap_rehash(map, slots);
+}
+
+/*
+    Destroying the hmap
+*/
+void hmap_destroy (HMap *map) {
+    int i;
+
+    if (map->destroy != NULL) {
+        for (i = 0; i < map->capacity; i++) {
+            if (map->ctrl[i] >= 0)
+                map->destroy(map->slots[i]);
+        }
+    }
+
+    free(map->ctrl);
+    free(map->slots);
+    memset(map, 0, sizeof(HMap));
+
+    return;
+}
+
+/*
+    Insert data, 1 when a matching element is already in
+*/
+int hmap_insert (HMap *map, const void *data) {
+    uint64_t h = hmap_mix(map->hash(data));
+    int slot, capacity;
+
+    if (hmap_find(map, data, h) >= 0)
+        return 1;
+
+    slot = hmap_find_free(map, h);
+
+    // Taking an empty slot uses up room, a deleted one does not. With
+    // room used up mostly by deleted markers, the elements move to new
+    // arrays of the same capacity, otherwise of twice the capacity
+    if (map->growth_left == 0 && map->ctrl[slot] == HMAP_EMPTY) {
+        if (map->size < hmap_max_load(map->capacity) / 2)
+            capacity = map->capacity;
+        else if (map->capacity < (1 << 30))
+            capacity = map->capacity * 2;
+        else
+            return -1;
+
+        if (hmap_rehash(map, capacity) != 0)
+            return -1;
+
+        slot = hmap_find_free(map, h);
+    }
+
+    if (map->ctrl[slot] == HMAP_EMPTY)
+        map->growth_left--;
+
+    hmap_set_ctrl(map, slot, hmap_h2(h));
+    map->slots[slot] = (void *)data;
+    map->size++;
+
+    return 0;
+}
+
+/*
+    Remove the element matching *data
+    The slot goes back to empty when no probe can have passed over it:
+    fewer than HMAP_GROUP used slots in a row around it
+*/
+int hmap_remove (HMap *map, void **data) {
+    unsigned int empty_before, empty_after;
+    int slot, before, run;
+
+    if ((slot = hmap_find(map, *data, hmap_mix(map->hash(*data)))) < 0)
+        return -1;
+
+    *data = map->slots[slot];
+
+    before = (slot - HMAP_GROUP) & (map->capacity - 1);
+    empty_before = hmap_group_empty(map->ctrl + before);
+    empty_after = hmap_group_empty(map->ctrl + slot);
+    run = HMAP_GROUP;
+
+    if (empty_before != 0 && empty_after != 0) {
+        // Used slots after slot, plus used slots before it
+        run = hmap_lowest_bit(empty_after);
+        while ((empty_before & 0x8000u) == 0) {
+            empty_before <<= 1;
+            run++;
+        }
+    }
+
+    if (run < HMAP_GROUP) {
+        hmap_set_ctrl(map, slot, HMAP_EMPTY);
+        map->growth_left++;
+    } else {
+        hmap_set_ctrl(map, slot, HMAP_DELETED);
+    }
+
+    map->size--;
+
+    return 0;
+}
+
+/*
+    Replace *data with the element matching it
+*/
+int hmap_lookup (const HMap *map, void **data) {
+    int slot;
+
+    if ((slot = hmap_find(map, *data, hmap_mix(map->hash(*data)))) < 0)
+        return -1;
+
+    *data = map->slots[slot];
+
+    return 0;
+}
+
+/*
+    Element at or after *position, which moves past it
+*/
+int hmap_next (const HMap *map, int *position, void **data) {
+
+    while (*position < map->capacity) {
+        if (map->ctrl[(*position)++] >= 0) {
+            *data = map->slots[*position - 1];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+    FNV-1a over the name
+*/
+size_t hmap_hash_string (const void *key) {
+    const unsigned char *name = (const unsigned char *)key;
+    size_t hash = (size_t)14695981039346656037ULL;
+
+    while (*name != '\0')
+        hash = (hash ^ *name++) * (size_t)1099511628211ULL;
+
+    return hash;
+}
+
+int hmap_match_string (const void *key1, const void *key2) {
+    return strcmp((const char *)key1, (const char *)key2) == 0;
+}
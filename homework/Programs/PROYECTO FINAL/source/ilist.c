@@ -0,0 +1,217 @@
+/*
+    ilist.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "ilist.h"
+
+/*
+    Initialize the ilist
+*/
+void ilist_init (IList *list, void (*destroy)(ILink *link)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->head = NULL;
+    list->tail = NULL;
+
+    return;
+}
+
+/*
+    Destroying the ilist, the elements belong to the caller
+*/
+void ilist_destroy (IList *list) {
+    ILink *link;
+
+    while (ilist_size(list) > 0) {
+        if (ilist_rem_next(list, NULL, &link) == 0 && list->destroy != NULL)
+            list->destroy(link);
+    }
+
+    memset(list, 0, sizeof(IList));
+    return;
+}
+
+/*
+    Link after node, at the head when node is NULL
+*/
+int ilist_ins_next (IList *list, ILink *node, ILink *link) {
+
+    if (link == NULL)
+        return -1;
+
+    if (node == NULL) {
+        if (ilist_size(list) == 0)
+            list->tail = link;
+
+        link->next = list->head;
+        list->head = link;
+    } else {
+        if (node->next == NULL)
+            list->tail = link;
+
+        link->next = node->next;
+        node->next = link;
+    }
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Unlink the link after node, the head when node is NULL
+*/
+int ilist_rem_next (IList *list, ILink *node, ILink **link) {
+    ILink *old_link;
+
+    if (ilist_size(list) == 0)
+        return -1;
+
+    if (node == NULL) {
+        old_link = list->head;
+        list->head = old_link->next;
+
+        if (ilist_size(list) == 1)
+            list->tail = NULL;
+    } else {
+        // Can not remove at the end of the list
+        if (node->next == NULL)
+            return -1;
+
+        old_link = node->next;
+        node->next = old_link->next;
+
+        if (node->next == NULL)
+            list->tail = node;
+    }
+
+    old_link->next = NULL;
+    *link = old_link;
+    list->size--;
+
+    return 0;
+}
+
+/*
+    Initialize the idlist
+*/
+void idlist_init (IDList *list, void (*destroy)(IDLink *link)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->head = NULL;
+    list->tail = NULL;
+
+    return;
+}
+
+/*
+    Destroying the idlist, the elements belong to the caller
+*/
+void idlist_destroy (IDList *list) {
+    IDLink *link;
+
+    while (idlist_size(list) > 0) {
+        link = idlist_tail(list);
+
+        if (idlist_remove(list, link) == 0 && list->destroy != NULL)
+            list->destroy(link);
+    }
+
+    memset(list, 0, sizeof(IDList));
+    return;
+}
+
+/*
+    Link after node
+*/
+int idlist_ins_next (IDList *list, IDLink *node, IDLink *link) {
+
+    // Do not allow a NULL node unless the list is empty
+    if (link == NULL || (node == NULL && idlist_size(list) != 0))
+        return -1;
+
+    if (idlist_size(list) == 0) {
+        list->head = link;
+        list->tail = link;
+        link->prev = NULL;
+        link->next = NULL;
+    } else {
+        link->next = node->next;
+        link->prev = node;
+
+        if (node->next == NULL)
+            list->tail = link;
+        else
+            node->next->prev = link;
+
+        node->next = link;
+    }
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Link before node
+*/
+int idlist_ins_prev (IDList *list, IDLink *node, IDLink *link) {
+
+    // Do not allow a NULL node unless the list is empty
+    if (link == NULL || (node == NULL && idlist_size(list) != 0))
+        return -1;
+
+    if (idlist_size(list) == 0) {
+        list->head = link;
+        list->tail = link;
+        link->prev = NULL;
+        link->next = NULL;
+    } else {
+        link->next = node;
+        link->prev = node->prev;
+
+        if (node->prev == NULL)
+            list->head = link;
+        else
+            node->prev->next = link;
+
+        node->prev = link;
+    }
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Unlink link from the idlist
+*/
+int idlist_remove (IDList *list, IDLink *link) {
+
+    if (link == NULL || idlist_size(list) == 0)
+        return -1;
+
+    if (link == list->head) {
+        list->head = link->next;
+
+        if (list->head == NULL)
+            list->tail = NULL;
+        else
+            link->next->prev = NULL;
+    } else {
+        link->prev->next = link->next;
+
+        if (link->next == NULL)
+            list->tail = link->prev;
+        else
+            link->next->prev = link->prev;
+    }
+
+    link->prev = NULL;
+    link->next = NULL;
+    list->size--;
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+    lfstack.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "lfstack.h"
+
+/*
+    Tagged top: pointer in the low 48 bits, tag in the high 16 bits
+    User-space addresses fit in 48 bits on x86-64 and AArch64
+*/
+#define LFSTACK_PTR_BITS 48
+#define LFSTACK_PTR_MASK ((1ULL << LFSTACK_PTR_BITS) - 1)
+
+#define lfstack_ptr(top) ((LFStackNode *)(size_t)((top) & LFSTACK_PTR_MASK))
+#define lfstack_tag(top) ((top) >> LFSTACK_PTR_BITS)
+#define lfstack_pack(node, tag) \
+    (((unsigned long long)(size_t)(node) & LFSTACK_PTR_MASK) | ((unsigned long long)(tag) << LFSTACK_PTR_BITS))
+
+/* Retired nodes a thread collects before trying to advance the epoch */
+#define EPOCH_THRESHOLD 64
+
+/*
+    Per-thread epoch record
+    A thread inside lfstack_pop is active at its local epoch. The global
+    epoch advances only when every active thread has seen it, so nodes
+    retired two epochs ago can no longer be referenced
+*/
+typedef struct EpochRecord_ {
+    unsigned long epoch;
+    int active;
+    int in_use;
+
+    LFStackNode *limbo[3];
+    int limbo_count;
+
+    struct EpochRecord_ *next;
+} EpochRecord;
+
+static EpochRecord *epoch_records = NULL;
+static unsigned long global_epoch = 0;
+static __thread EpochRecord *epoch_self = NULL;
+
+/*
+    Free a list of retired nodes
+*/
+static void epoch_free (LFStackNode *node) {
+    LFStackNode *retired;
+
+    while (node != NULL) {
+        retired = node->retired;
+        free(node);
+        node = retired;
+    }
+
+    return;
+}
+
+/*
+    Record of the calling thread, reusing one released by a finished thread
+*/
+static EpochRecord *epoch_record (void) {
+    EpochRecord *record;
+    int free_record = 0;
+
+    if (epoch_self != NULL)
+        return epoch_self;
+
+    for (record = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE); record != NULL; record = record->next) {
+        free_record = 0;
+
+        if (__atomic_compare_exchange_n(&record->in_use, &free_record, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return epoch_self = record;
+    }
+
+    if ((record = (EpochRecord *)calloc(1, sizeof(EpochRecord))) == NULL)
+        return NULL;
+
+    record->in_use = 1;
+    record->next = __atomic_load_n(&epoch_records, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&epoch_records, &record->next, record, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    return epoch_self = record;
+}
+
+/*
+    Enter a critical section, frees the nodes retired two epochs ago
+*/
+static EpochRecord *epoch_enter (void) {
+    EpochRecord *record;
+    unsigned long epoch;
+
+    if ((record = epoch_record()) == NULL)
+        return NULL;
+
+    // Sequentially consistent with epoch_advance: either the advancing
+    // thread sees this record active, or this thread sees the new epoch
+    __atomic_store_n(&record->active, 1, __ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&record->epoch, epoch, __ATOMIC_SEQ_CST);
+
+    // The bag of epoch - 2 shares its slot with epoch + 1
+    if (record->limbo[(epoch + 1) % 3] != NULL) {
+        epoch_free(record->limbo[(epoch + 1) % 3]);
+        record->limbo[(epoch + 1) % 3] = NULL;
+    }
+
+    return record;
+}
+
+/*
+    Leave a critical section
+*/
+static void epoch_exit (EpochRecord *record) {
+    __atomic_store_n(&record->active, 0, __ATOMIC_RELEASE);
+    return;
+}
+
+/*
+    Advance the global epoch if every active thread has seen it
+*/
+static void epoch_advance (void) {
+    EpochRecord *record;
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+
+    for (record = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE); record != NULL; record = record->next) {
+        if (__atomic_load_n(&record->active, __ATOMIC_SEQ_CST) &&
+            __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST) != epoch)
+            return;
+    }
+
+    __atomic_compare_exchange_n(&global_epoch, &epoch, epoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+
+    return;
+}
+
+/*
+    Retire a node unlinked during the current critical section
+*/
+static void epoch_retire (EpochRecord *record, LFStackNode *node) {
+    unsigned long slot = record->epoch % 3;
+
+    node->retired = record->limbo[slot];
+    record->limbo[slot] = node;
+
+    if (++record->limbo_count >= EPOCH_THRESHOLD) {
+        record->limbo_count = 0;
+        epoch_advance();
+    }
+
+    return;
+}
+
+/*
+    Initialize
+*/
+void lfstack_init (LFStack *stack, void (*destroy)(void *data)) {
+    stack->top = 0;
+    stack->size = 0;
+    stack->destroy = destroy;
+
+    return;
+}
+
+/*
+    Destroy, no thread may be using the stack
+*/
+void lfstack_destroy (LFStack *stack) {
+    LFStackNode *node = lfstack_ptr(stack->top);
+    LFStackNode *next;
+
+    while (node != NULL) {
+        next = node->next;
+
+        if (stack->destroy != NULL)
+            stack->destroy(node->data);
+
+        free(node);
+        node = next;
+    }
+
+    memset(stack, 0, sizeof(LFStack));
+
+    return;
+}
+
+/*
+    Push
+    Never reads another node, so it needs no critical section
+*/
+int lfstack_push (LFStack *stack, const void *data) {
+    LFStackNode *node;
+    unsigned long long top;
+
+    if ((node = (LFStackNode *)malloc(sizeof(LFStackNode))) == NULL)
+        return -1;
+
+    node->data = (void *)data;
+    node->retired = NULL;
+
+    top = __atomic_load_n(&stack->top, __ATOMIC_RELAXED);
+
+    do {
+        node->next = lfstack_ptr(top);
+    } while (!__atomic_compare_exchange_n(&stack->top, &top, lfstack_pack(node, lfstack_tag(top) + 1), 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    __atomic_fetch_add(&stack->size, 1, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+/*
+    Pop, returns -1 when the stack is empty
+*/
+int lfstack_pop (LFStack *stack, void **data) {
+    EpochRecord *record;
+    LFStackNode *node;
+    unsigned long long top;
+
+    if ((record = epoch_enter()) == NULL)
+        return -1;
+
+    top = __atomic_load_n(&stack->top, __ATOMIC_SEQ_CST);
+
+    do {
+        if ((node = lfstack_ptr(top)) == NULL) {
+            epoch_exit(record);
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(&stack->top, &top, lfstack_pack(node->next, lfstack_tag(top) + 1), 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    *data = node->data;
+    __atomic_fetch_sub(&stack->size, 1, __ATOMIC_RELAXED);
+
+    epoch_retire(record, node);
+    epoch_exit(record);
+
+    return 0;
+}
+
+/*
+    Release the calling thread's epoch record for other threads
+    Its retired nodes are freed by the thread that takes it next
+*/
+void lfstack_thread_exit (void) {
+    if (epoch_self == NULL)
+        return;
+
+    __atomic_store_n(&epoch_self->active, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&epoch_self->in_use, 0, __ATOMIC_RELEASE);
+    epoch_self = NULL;
+
+    return;
+}
+
+/*
+    Free every retired node
+    Only when no thread is inside an lfstack call, e.g. after joining
+    the workers
+*/
+void lfstack_quiesce (void) {
+    EpochRecord *record;
+    int i;
+
+    for (record = __atomic_load_n(&epoch_records, __ATOMIC_ACQUIRE); record != NULL; record = record->next) {
+        for (i = 0; i < 3; i++) {
+            epoch_free(record->limbo[i]);
+            record->limbo[i] = NULL;
+        }
+
+        record->limbo_count = 0;
+    }
+
+    return;
+}
@@ -1,48 +1,90 @@
 /*
     list.c
 */
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 #include "list.h"
+#include "stats.h"
 
 /*
-    Initialize the list
+    Freed inline nodes kept for reuse by the same thread, an aligned
+    allocation costs several plain mallocs
 */
-void list_init (List *list, void (*destroy)(void *data)) {
-    list->size = 0;
-    list->destroy = destroy;
-    list->head = NULL;
-    list->tail = NULL;
+#define LIST_SPARE_MAX 256
 
-    return;    
-}
+static __thread ListNode *list_spare = NULL;
+static __thread int list_spare_size = 0;
 
 /*
-    Destroying the list
+    Free a line from list_node_alloc
 */
-void list_destroy (List *list) {
-    void *data;
+static void list_block_free (ListNode *node) {
+
+#ifdef _WIN32
+    _aligned_free(node);
+#else
+    free(node);
+#endif
 
-    while(list_size(list) > 0) {
-        if (list_rem_next(list, NULL, (void **)&data) == 0 && list->destroy != NULL) {
-            list->destroy(data);
-        }
-    }    
-    memset(list, 0, sizeof(List));
     return;
 }
 
 /*
-    Insert next node at the List
+    One cache-line aligned line for a node and its payload
 */
-int list_ins_next (List *list, ListNode *node, const void *data ) {
-    ListNode    *new_node;
+static ListNode *list_node_alloc (void) {
+    void *block;
 
-    if ((new_node = (ListNode *)malloc(sizeof(ListNode))) == NULL)
-        return -1;
+    if (list_spare != NULL) {
+        block = list_spare;
+        list_spare = list_spare->next;
+        list_spare_size--;
+        return (ListNode *)block;
+    }
 
-    new_node->data = (void *)data;
+#ifdef _WIN32
+    block = _aligned_malloc(LIST_CACHE_LINE, LIST_CACHE_LINE);
+#else
+    if (posix_memalign(&block, LIST_CACHE_LINE, LIST_CACHE_LINE) != 0)
+        block = NULL;
+#endif
+
+    return (ListNode *)block;
+}
+
+/*
+    Free a node, with its payload when inline
+*/
+static void list_node_free (ListNode *node) {
+
+    if (!list_is_inline(node)) {
+        free(node);
+        return;
+    }
+
+    if (list_spare_size < LIST_SPARE_MAX) {
+        node->next = list_spare;
+        list_spare = node;
+        list_spare_size++;
+        return;
+    }
+
+    list_block_free(node);
+
+    return;
+}
+
+/*
+    Link new_node after node, at the head when node is NULL
+*/
+static void list_link (List *list, ListNode *node, ListNode *new_node) {
 
     // Handle insertion from head at the list
     if (node == NULL) {
@@ -71,11 +113,77 @@ int list_ins_next (List *list, ListNode *node, const void *data ) {
 
     list->size++;
 
+    return;
+}
+
+/*
+    Initialize the list
+*/
+void list_init (List *list, void (*destroy)(void *data)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->head = NULL;
+    list->tail = NULL;
+
+    return;    
+}
+
+/*
+    Destroying the list, inline payloads go with their nodes
+*/
+void list_destroy (List *list) {
+    void *data;
+    int is_inline;
+
+    while(list_size(list) > 0) {
+        is_inline = list_is_inline(list_head(list));
+
+        if (list_rem_next(list, NULL, (void **)&data) == 0 && list->destroy != NULL && !is_inline) {
+            list->destroy(data);
+        }
+    }    
+    memset(list, 0, sizeof(List));
+    return;
+}
+
+/*
+    Insert next node at the List
+*/
+int list_ins_next (List *list, ListNode *node, const void *data ) {
+    ListNode    *new_node;
+
+    if ((new_node = (ListNode *)malloc(sizeof(ListNode))) == NULL)
+        return -1;
+
+    stats_alloc(STATS_LIST, sizeof(ListNode));
+
+    new_node->data = (void *)data;
+    list_link(list, node, new_node);
+
+    return 0;
+}
+
+/*
+    Insert next node with a copy of size bytes of data inside it
+*/
+int list_ins_next_copy (List *list, ListNode *node, const void *data, size_t size) {
+    ListNode    *new_node;
+
+    if (size > LIST_INLINE_MAX || (new_node = list_node_alloc()) == NULL)
+        return -1;
+
+    stats_alloc(STATS_LIST, LIST_CACHE_LINE);
+
+    memcpy(new_node->payload, data, size);
+    new_node->data = new_node->payload;
+    list_link(list, node, new_node);
+
     return 0;
 }
 
 /*
     Remove Next node at the List
+    data is set to NULL for an inline node, its payload is freed with it
 */
 int list_rem_next (List *list, ListNode *node, void **data) {
     ListNode *old_node;
@@ -87,7 +195,6 @@ int list_rem_next (List *list, ListNode *node, void **data) {
     // Handle removal from head of the list 
     if (node == NULL) {
     
-        *data = list->head->data;
         old_node = list->head;
         list->head = list->head->next;
 
@@ -102,14 +209,222 @@ int list_rem_next (List *list, ListNode *node, void **data) {
         if (node->next == NULL)
             return -1;
 
-        *data = node->next->data;
         old_node = node->next;
         node->next = node->next->next;
+
+        if (node->next == NULL)
+            list->tail = node;
     }
 
-    free(old_node);
+    *data = list_is_inline(old_node) ? NULL : old_node->data;
+
+    list_node_free(old_node);
+    stats_free(STATS_LIST);
     list->size--;
 
     return 0;
 }
 
+/*
+    Remove Next node at the List, copying size bytes of its data out
+*/
+int list_rem_next_copy (List *list, ListNode *node, void *data, size_t size) {
+    ListNode *old_node;
+    void *unused;
+
+    if (list_size(list) == 0 || (node != NULL && node->next == NULL))
+        return -1;
+
+    old_node = node == NULL ? list->head : node->next;
+    memcpy(data, old_node->data, size);
+
+    return list_rem_next(list, node, &unused);
+}
+
+/*
+    Free the spare nodes of the calling thread
+*/
+void list_spare_release (void) {
+    ListNode *node;
+
+    while ((node = list_spare) != NULL) {
+        list_spare = node->next;
+        list_block_free(node);
+    }
+
+    list_spare_size = 0;
+
+    return;
+}
+
+/*
+    Merge two sorted chains, a before b on ties
+*/
+static ListNode *list_merge (ListNode *a, ListNode *b, int (*compare)(const void *key1, const void *key2)) {
+    ListNode *head = NULL, **tail = &head;
+
+    while (a != NULL && b != NULL) {
+        if (compare(a->data, b->data) <= 0) {
+            *tail = a;
+            a = a->next;
+        } else {
+            *tail = b;
+            b = b->next;
+        }
+        tail = &(*tail)->next;
+    }
+
+    *tail = a != NULL ? a : b;
+
+    return head;
+}
+
+/*
+    Sort the first n nodes of a chain, *rest gets the node after them
+*/
+static ListNode *list_sort_nodes (ListNode *head, int n, ListNode **rest,
+                                  int (*compare)(const void *key1, const void *key2)) {
+    ListNode *left, *right;
+
+    if (n == 1) {
+        *rest = head->next;
+        head->next = NULL;
+        return head;
+    }
+
+    left = list_sort_nodes(head, n / 2, &right, compare);
+    right = list_sort_nodes(right, n - n / 2, rest, compare);
+
+    return list_merge(left, right, compare);
+}
+
+/*
+    Point tail at the last node after the links were rebuilt
+*/
+static void list_fix_tail (List *list) {
+    ListNode *node = list->head;
+
+    list->tail = NULL;
+
+    while (node != NULL) {
+        list->tail = node;
+        node = node->next;
+    }
+
+    return;
+}
+
+/*
+    Sort, top-down: halves of the list are sorted and merged
+*/
+void list_sort (List *list, int (*compare)(const void *key1, const void *key2)) {
+    ListNode *rest;
+
+    if (list_size(list) < 2)
+        return;
+
+    list->head = list_sort_nodes(list->head, list_size(list), &rest, compare);
+    list_fix_tail(list);
+
+    return;
+}
+
+/*
+    Sort, bottom-up: bin i holds a sorted run of 2^i nodes, and every
+    node taken from the list is merged up through the full bins. Runs
+    are merged right after they are built, while their nodes are still
+    in cache, instead of after a pass over the whole list
+*/
+void list_sort_bottom_up (List *list, int (*compare)(const void *key1, const void *key2)) {
+    ListNode *bins[64], *node, *next, *carry;
+    int i, top = 0;
+
+    if (list_size(list) < 2)
+        return;
+
+    for (node = list->head; node != NULL; node = next) {
+        next = node->next;
+        node->next = NULL;
+        carry = node;
+
+        // Older runs go first, the sort stays stable
+        for (i = 0; i < top && bins[i] != NULL; i++) {
+            carry = list_merge(bins[i], carry, compare);
+            bins[i] = NULL;
+        }
+
+        if (i == top)
+            top++;
+
+        bins[i] = carry;
+    }
+
+    for (carry = NULL, i = 0; i < top; i++) {
+        if (bins[i] != NULL)
+            carry = carry == NULL ? bins[i] : list_merge(bins[i], carry, compare);
+    }
+
+    list->head = carry;
+    list_fix_tail(list);
+
+    return;
+}
+
+/*
+    Move all of other after node
+*/
+void list_splice (List *list, ListNode *node, List *other) {
+
+    if (list_size(other) == 0)
+        return;
+
+    if (node == NULL) {
+        other->tail->next = list->head;
+        list->head = other->head;
+
+        if (list->tail == NULL)
+            list->tail = other->tail;
+    } else {
+        other->tail->next = node->next;
+        node->next = other->head;
+
+        if (list->tail == node)
+            list->tail = other->tail;
+    }
+
+    list->size += other->size;
+
+    other->size = 0;
+    other->head = NULL;
+    other->tail = NULL;
+
+    return;
+}
+
+/*
+    Move all of other to the tail
+*/
+void list_concat (List *list, List *other) {
+    list_splice(list, list_tail(list), other);
+    return;
+}
+
+/*
+    Reverse the order of the nodes
+*/
+void list_reverse (List *list) {
+    ListNode *node = list->head, *prev = NULL, *next;
+
+    list->tail = node;
+
+    while (node != NULL) {
+        next = node->next;
+        node->next = prev;
+        prev = node;
+        node = next;
+    }
+
+    list->head = prev;
+
+    return;
+}
@@ -0,0 +1,171 @@
+/*
+    mpmc_queue.c
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include "mpmc_queue.h"
+
+/* Failed attempts before a blocking call gives up its time slice */
+#define MPMC_SPINS 64
+
+/*
+    Let other threads run while waiting
+*/
+static void mpmc_yield (void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/*
+    Initialize, the capacity is rounded up to a power of two
+*/
+int mpmc_queue_init (MPMCQueue *queue, size_t capacity) {
+    size_t size = 2;
+    size_t i;
+
+    while (size < capacity)
+        size <<= 1;
+
+    if ((queue->buffer = (MPMCCell *)malloc(size * sizeof(MPMCCell))) == NULL)
+        return -1;
+
+    for (i = 0; i < size; i++)
+        queue->buffer[i].sequence = i;
+
+    queue->mask = size - 1;
+    queue->enqueue_pos = 0;
+    queue->dequeue_pos = 0;
+
+    return 0;
+}
+
+/*
+    Destroy, no thread may be using the queue
+*/
+void mpmc_queue_destroy (MPMCQueue *queue) {
+    free(queue->buffer);
+    queue->buffer = NULL;
+    queue->mask = 0;
+
+    return;
+}
+
+/*
+    Enqueue without waiting, returns -1 when the queue is full
+*/
+int mpmc_queue_try_enqueue (MPMCQueue *queue, const void *data) {
+    MPMCCell *cell;
+    size_t pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+    size_t sequence;
+    long diff;
+
+    for (;;) {
+        cell = &queue->buffer[pos & queue->mask];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        diff = (long)(sequence - pos);
+
+        if (diff == 0) {
+            // Free cell, claim the position
+            if (__atomic_compare_exchange_n(&queue->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            // The cell still holds the value of the previous lap
+            return -1;
+        } else {
+            pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = (void *)data;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+    Dequeue without waiting, returns -1 when the queue is empty
+*/
+int mpmc_queue_try_dequeue (MPMCQueue *queue, void **data) {
+    MPMCCell *cell;
+    size_t pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+    size_t sequence;
+    long diff;
+
+    for (;;) {
+        cell = &queue->buffer[pos & queue->mask];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        diff = (long)(sequence - (pos + 1));
+
+        if (diff == 0) {
+            // Full cell, claim the position
+            if (__atomic_compare_exchange_n(&queue->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    *data = cell->data;
+
+    // Free the cell for the producer of the next lap
+    __atomic_store_n(&cell->sequence, pos + queue->mask + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+    Enqueue, waits while the queue is full
+*/
+int mpmc_queue_enqueue (MPMCQueue *queue, const void *data) {
+    int spins = 0;
+
+    while (mpmc_queue_try_enqueue(queue, data) != 0) {
+        if (++spins >= MPMC_SPINS) {
+            mpmc_yield();
+            spins = 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    Dequeue, waits while the queue is empty
+*/
+int mpmc_queue_dequeue (MPMCQueue *queue, void **data) {
+    int spins = 0;
+
+    while (mpmc_queue_try_dequeue(queue, data) != 0) {
+        if (++spins >= MPMC_SPINS) {
+            mpmc_yield();
+            spins = 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    Number of elements, only a snapshot while other threads run
+*/
+size_t mpmc_queue_size (MPMCQueue *queue) {
+    size_t head = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_ACQUIRE);
+
+    return tail > head ? tail - head : 0;
+}
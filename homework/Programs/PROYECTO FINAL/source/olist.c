@@ -0,0 +1,329 @@
+/*
+    olist.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "olist.h"
+
+#define olist_count(node) ((node) == NULL ? 0 : (node)->count)
+
+/*
+    Next priority, xorshift on the seed of the list
+*/
+static unsigned int olist_priority (OList *list) {
+    list->seed ^= list->seed << 13;
+    list->seed ^= list->seed >> 17;
+    list->seed ^= list->seed << 5;
+
+    return list->seed;
+}
+
+/*
+    Make child take the place of node under node's parent
+*/
+static void olist_replace (OList *list, OListNode *node, OListNode *child) {
+    OListNode *parent = node->parent;
+
+    if (child != NULL)
+        child->parent = parent;
+
+    if (parent == NULL)
+        list->root = child;
+    else if (parent->left == node)
+        parent->left = child;
+    else
+        parent->right = child;
+
+    return;
+}
+
+/*
+    Move node above its parent, keeping the in-order and the counts
+*/
+static void olist_rotate_up (OList *list, OListNode *node) {
+    OListNode *parent = node->parent;
+
+    olist_replace(list, parent, node);
+
+    if (parent->left == node) {
+        parent->left = node->right;
+        if (parent->left != NULL)
+            parent->left->parent = parent;
+        node->right = parent;
+    } else {
+        parent->right = node->left;
+        if (parent->right != NULL)
+            parent->right->parent = parent;
+        node->left = parent;
+    }
+
+    parent->parent = node;
+    node->count = parent->count;
+    parent->count = 1 + olist_count(parent->left) + olist_count(parent->right);
+
+    return;
+}
+
+/*
+    Join two subtrees, every node of a before every node of b
+*/
+static OListNode *olist_merge (OListNode *a, OListNode *b) {
+
+    if (a == NULL)
+        return b;
+
+    if (b == NULL)
+        return a;
+
+    if (a->priority > b->priority) {
+        a->right = olist_merge(a->right, b);
+        a->right->parent = a;
+        a->count = 1 + olist_count(a->left) + olist_count(a->right);
+        return a;
+    }
+
+    b->left = olist_merge(a, b->left);
+    b->left->parent = b;
+    b->count = 1 + olist_count(b->left) + olist_count(b->right);
+
+    return b;
+}
+
+/*
+    Free a subtree, depth is O(log n) expected
+*/
+static void olist_free (OList *list, OListNode *node) {
+
+    if (node == NULL)
+        return;
+
+    olist_free(list, node->left);
+    olist_free(list, node->right);
+
+    if (list->destroy != NULL)
+        list->destroy(node->data);
+
+    free(node);
+
+    return;
+}
+
+/*
+    Initialize the olist
+*/
+void olist_init (OList *list, void (*destroy)(void *data)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->root = NULL;
+    list->seed = 2463534242u;
+
+    return;
+}
+
+/*
+    Destroying the olist
+*/
+void olist_destroy (OList *list) {
+    olist_free(list, list->root);
+    memset(list, 0, sizeof(OList));
+
+    return;
+}
+
+/*
+    Node at position index
+*/
+OListNode *olist_at (const OList *list, int index) {
+    OListNode *node = list->root;
+    int left;
+
+    if (index < 0 || index >= olist_size(list))
+        return NULL;
+
+    while (node != NULL) {
+        left = olist_count(node->left);
+
+        if (index < left) {
+            node = node->left;
+        } else if (index == left) {
+            return node;
+        } else {
+            index -= left + 1;
+            node = node->right;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    Position of node, counting the nodes before it on the way up
+*/
+int olist_index (const OListNode *node) {
+    int index;
+
+    if (node == NULL)
+        return -1;
+
+    index = olist_count(node->left);
+
+    while (node->parent != NULL) {
+        if (node->parent->right == node)
+            index += olist_count(node->parent->left) + 1;
+
+        node = node->parent;
+    }
+
+    return index;
+}
+
+/*
+    Insert data so that it ends up at position index
+*/
+int olist_ins_at (OList *list, int index, const void *data) {
+    OListNode *new_node, *node;
+    int left;
+
+    if (index < 0 || index > olist_size(list))
+        return -1;
+
+    if ((new_node = (OListNode *)malloc(sizeof(OListNode))) == NULL)
+        return -1;
+
+    new_node->data = (void *)data;
+    new_node->left = NULL;
+    new_node->right = NULL;
+    new_node->parent = NULL;
+    new_node->priority = olist_priority(list);
+    new_node->count = 1;
+
+    // Insert as a leaf, counting it in every node on the way down
+    if ((node = list->root) == NULL) {
+        list->root = new_node;
+    } else {
+        for (;;) {
+            node->count++;
+            left = olist_count(node->left);
+
+            if (index <= left) {
+                if (node->left == NULL) {
+                    node->left = new_node;
+                    break;
+                }
+                node = node->left;
+            } else {
+                index -= left + 1;
+                if (node->right == NULL) {
+                    node->right = new_node;
+                    break;
+                }
+                node = node->right;
+            }
+        }
+
+        new_node->parent = node;
+    }
+
+    // Then up while its priority is the higher one
+    while (new_node->parent != NULL && new_node->priority > new_node->parent->priority)
+        olist_rotate_up(list, new_node);
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Remove node at the olist, its subtrees are merged in its place
+*/
+int olist_remove (OList *list, OListNode *node, void **data) {
+    OListNode *parent;
+
+    if (node == NULL || olist_size(list) == 0)
+        return -1;
+
+    *data = node->data;
+    parent = node->parent;
+
+    olist_replace(list, node, olist_merge(node->left, node->right));
+
+    for (; parent != NULL; parent = parent->parent)
+        parent->count--;
+
+    free(node);
+    list->size--;
+
+    return 0;
+}
+
+/*
+    Remove the node at position index
+*/
+int olist_remove_at (OList *list, int index, void **data) {
+    return olist_remove(list, olist_at(list, index), data);
+}
+
+/*
+    First node, NULL when empty
+*/
+OListNode *olist_head (const OList *list) {
+    OListNode *node = list->root;
+
+    while (node != NULL && node->left != NULL)
+        node = node->left;
+
+    return node;
+}
+
+/*
+    Last node, NULL when empty
+*/
+OListNode *olist_tail (const OList *list) {
+    OListNode *node = list->root;
+
+    while (node != NULL && node->right != NULL)
+        node = node->right;
+
+    return node;
+}
+
+/*
+    Node after node, NULL at the tail
+*/
+OListNode *olist_next (const OListNode *node) {
+
+    if (node->right != NULL) {
+        node = node->right;
+
+        while (node->left != NULL)
+            node = node->left;
+
+        return (OListNode *)node;
+    }
+
+    while (node->parent != NULL && node->parent->right == node)
+        node = node->parent;
+
+    return node->parent;
+}
+
+/*
+    Node before node, NULL at the head
+*/
+OListNode *olist_prev (const OListNode *node) {
+
+    if (node->left != NULL) {
+        node = node->left;
+
+        while (node->right != NULL)
+            node = node->right;
+
+        return (OListNode *)node;
+    }
+
+    while (node->parent != NULL && node->parent->left == node)
+        node = node->parent;
+
+    return node->parent;
+}
@@ -0,0 +1,460 @@
+/*
+    oplog.c
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "oplog.h"
+
+/*
+    Index header: a magic and the size of an entry
+*/
+static const char oplog_magic[4] = {'O', 'P', 'I', 'X'};
+
+#define OPLOG_HEADER 8
+
+/*
+    Entries read at once while searching
+*/
+#define OPLOG_BLOCK 256
+
+/*
+    Room for a path with a generation and .idx after it
+*/
+#define OPLOG_NAME (OPLOG_PATH + 16)
+
+/*
+    path for generation 0, the live log, path.generation for the others,
+    and .idx after either for their index
+*/
+static void oplog_name (const char *path, int generation, const char *suffix, char *name) {
+
+    if (generation == 0)
+        snprintf(name, OPLOG_NAME, "%s%s", path, suffix);
+    else
+        snprintf(name, OPLOG_NAME, "%s.%d%s", path, generation, suffix);
+
+    return;
+}
+
+/*
+    Sync what the system holds of file to the disk
+*/
+static int oplog_sync (FILE *file) {
+
+#ifdef _WIN32
+    return _commit(_fileno(file));
+#else
+    return fsync(fileno(file));
+#endif
+}
+
+/*
+    Cut the file at path to size bytes
+*/
+static int oplog_truncate (const char *path, long long size) {
+    FILE *file;
+    int status;
+
+    if ((file = fopen(path, "r+b")) == NULL)
+        return -1;
+
+#ifdef _WIN32
+    status = _chsize(_fileno(file), (long)size);
+#else
+    status = ftruncate(fileno(file), (off_t)size);
+#endif
+
+    fclose(file);
+
+    return status == 0 ? 0 : -1;
+}
+
+/*
+    Open the index of path for reading, the entries it holds or -1
+*/
+static int oplog_index_open (const char *path, FILE **index) {
+    char index_path[OPLOG_NAME], header[OPLOG_HEADER];
+    int entry_size;
+    long size;
+
+    oplog_name(path, 0, ".idx", index_path);
+
+    if ((*index = fopen(index_path, "rb")) == NULL)
+        return -1;
+
+    if (fread(header, 1, OPLOG_HEADER, *index) != OPLOG_HEADER || memcmp(header, oplog_magic, 4) != 0) {
+        fclose(*index);
+        return -1;
+    }
+
+    memcpy(&entry_size, header + 4, sizeof(int));
+
+    if (entry_size != (int)sizeof(OpLogEntry) || fseek(*index, 0, SEEK_END) != 0 || (size = ftell(*index)) < 0) {
+        fclose(*index);
+        return -1;
+    }
+
+    return (int)((size - OPLOG_HEADER) / (long)sizeof(OpLogEntry));
+}
+
+/*
+    Cut an index of size bytes back to its whole entries and take the
+    time of the last one. One that is not an index is left alone
+*/
+static int oplog_index_repair (OpLog *log, const char *index_path, long size) {
+    OpLogEntry last;
+    FILE *index;
+    int entries;
+
+    if (size < OPLOG_HEADER)
+        return oplog_truncate(index_path, 0);
+
+    if ((entries = oplog_index_open(log->path, &index)) < 0)
+        return -1;
+
+    if (entries > 0 && (fseek(index, OPLOG_HEADER + (long)(entries - 1) * (long)sizeof(OpLogEntry), SEEK_SET) != 0 ||
+                        fread(&last, sizeof(OpLogEntry), 1, index) != 1)) {
+        fclose(index);
+        return -1;
+    }
+
+    fclose(index);
+
+    if (entries > 0 && last.time > log->last_time)
+        log->last_time = last.time;
+
+    if (size != OPLOG_HEADER + (long)entries * (long)sizeof(OpLogEntry))
+        return oplog_truncate(index_path, OPLOG_HEADER + (long long)entries * (long long)sizeof(OpLogEntry));
+
+    return 0;
+}
+
+/*
+    Open the live log and its index, writing the header of a new index
+*/
+static int oplog_open_files (OpLog *log) {
+    char index_path[OPLOG_NAME];
+    FILE *index;
+    long size;
+    int entry_size = (int)sizeof(OpLogEntry);
+
+    oplog_name(log->path, 0, ".idx", index_path);
+
+    if ((index = fopen(index_path, "rb")) != NULL) {
+        size = fseek(index, 0, SEEK_END) == 0 ? ftell(index) : -1;
+        fclose(index);
+
+        if (size < 0 || (size > 0 && oplog_index_repair(log, index_path, size) != 0))
+            return -1;
+    }
+
+    if ((log->file = fopen(log->path, "ab")) == NULL)
+        return -1;
+
+    if (setvbuf(log->file, log->buffer, _IOFBF, log->buffer_size) != 0 || fseek(log->file, 0, SEEK_END) != 0 ||
+        (size = ftell(log->file)) < 0 || (log->index = fopen(index_path, "ab")) == NULL) {
+        fclose(log->file);
+        log->file = NULL;
+        return -1;
+    }
+
+    log->offset = size;
+
+    if (fseek(log->index, 0, SEEK_END) == 0 && ftell(log->index) == 0 &&
+        (fwrite(oplog_magic, 1, 4, log->index) != 4 || fwrite(&entry_size, sizeof(int), 1, log->index) != 1 ||
+         fflush(log->index) != 0)) {
+        fclose(log->file);
+        fclose(log->index);
+        log->file = NULL;
+        log->index = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+    Move the live log to path.1, and the older ones one further
+*/
+static int oplog_rotate (OpLog *log) {
+    char from[OPLOG_NAME], to[OPLOG_NAME], from_index[OPLOG_NAME], to_index[OPLOG_NAME];
+    int k;
+
+    if (oplog_commit(log) != 0)
+        return -1;
+
+    fclose(log->file);
+    fclose(log->index);
+    log->file = NULL;
+    log->index = NULL;
+
+    for (k = OPLOG_KEEP; k >= 1; k--) {
+        oplog_name(log->path, k - 1, "", from);
+        oplog_name(log->path, k - 1, ".idx", from_index);
+        oplog_name(log->path, k, "", to);
+        oplog_name(log->path, k, ".idx", to_index);
+
+        remove(to);
+        remove(to_index);
+        rename(from, to);
+        rename(from_index, to_index);
+    }
+
+    return oplog_open_files(log);
+}
+
+/*
+    Open or create the log at path and its index
+*/
+int oplog_open (OpLog *log, const char *path, size_t buffer_size, int group, int sync, long long max_size) {
+
+    if (strlen(path) >= OPLOG_PATH || buffer_size == 0 || group < 1)
+        return -1;
+
+    memset(log, 0, sizeof(OpLog));
+    strcpy(log->path, path);
+    log->buffer_size = buffer_size;
+    log->group = group;
+    log->sync = sync;
+    log->max_size = max_size;
+    log->last_time = 0;
+
+    if ((log->buffer = (char *)malloc(buffer_size)) == NULL)
+        return -1;
+
+    if ((log->entries = (OpLogEntry *)malloc(group * sizeof(OpLogEntry))) == NULL ||
+        oplog_open_files(log) != 0) {
+        free(log->entries);
+        free(log->buffer);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+    Commit what is pending and close the log
+*/
+int oplog_close (OpLog *log) {
+    int status;
+
+    status = oplog_commit(log);
+
+    if (log->file != NULL && fclose(log->file) != 0)
+        status = -1;
+
+    if (log->index != NULL && fclose(log->index) != 0)
+        status = -1;
+
+    free(log->entries);
+    free(log->buffer);
+    memset(log, 0, sizeof(OpLog));
+
+    return status;
+}
+
+/*
+    Start a record, rotating the log first when it is full
+*/
+FILE *oplog_begin (OpLog *log, time_t time, const char *key) {
+
+    if (log->max_size > 0 && log->offset > 0 && log->offset >= log->max_size && oplog_rotate(log) != 0)
+        return NULL;
+
+    if (log->file == NULL)
+        return NULL;
+
+    log->record.time = (long long)time > log->last_time ? (long long)time : log->last_time;
+    log->record.hash = oplog_hash(key);
+    log->record.offset = log->offset;
+
+    return log->file;
+}
+
+/*
+    Close the record started by oplog_begin
+*/
+int oplog_end (OpLog *log) {
+    long end;
+
+    if (log->file == NULL || (end = ftell(log->file)) < 0)
+        return -1;
+
+    log->record.length = end - log->record.offset;
+    log->offset = end;
+    log->last_time = log->record.time;
+
+    // a commit that failed left the group full
+    if (log->pending == log->group && oplog_commit(log) != 0)
+        return -1;
+
+    log->entries[log->pending++] = log->record;
+
+    return log->pending == log->group ? oplog_commit(log) : 0;
+}
+
+/*
+    Write out the records and then their entries
+*/
+int oplog_commit (OpLog *log) {
+
+    if (log->file == NULL || log->index == NULL)
+        return -1;
+
+    if (fflush(log->file) != 0 || (log->sync == OPLOG_SYNC_COMMIT && oplog_sync(log->file) != 0))
+        return -1;
+
+    if (log->pending == 0)
+        return 0;
+
+    if (fwrite(log->entries, sizeof(OpLogEntry), log->pending, log->index) != (size_t)log->pending ||
+        fflush(log->index) != 0 || (log->sync == OPLOG_SYNC_COMMIT && oplog_sync(log->index) != 0))
+        return -1;
+
+    log->pending = 0;
+
+    return 0;
+}
+
+/*
+    64 bit FNV-1a of key
+*/
+unsigned long long oplog_hash (const char *key) {
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+
+    while (*key != '\0') {
+        hash ^= (unsigned char)*key++;
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/*
+    Every entry of the index with hash, in the order written
+*/
+int oplog_find_hash (const char *path, unsigned long long hash, int (*visit)(const OpLogEntry *entry, void *data),
+                     void *data) {
+    OpLogEntry block[OPLOG_BLOCK];
+    FILE *index;
+    int entries, count, i, visited = 0;
+
+    if ((entries = oplog_index_open(path, &index)) < 0)
+        return -1;
+
+    fseek(index, OPLOG_HEADER, SEEK_SET);
+
+    while (entries > 0) {
+        count = entries < OPLOG_BLOCK ? entries : OPLOG_BLOCK;
+
+        if (fread(block, sizeof(OpLogEntry), count, index) != (size_t)count) {
+            fclose(index);
+            return -1;
+        }
+
+        for (i = 0; i < count; i++) {
+            if (block[i].hash != hash)
+                continue;
+
+            visited++;
+
+            if (visit(&block[i], data) != 0) {
+                fclose(index);
+                return visited;
+            }
+        }
+
+        entries -= count;
+    }
+
+    fclose(index);
+
+    return visited;
+}
+
+/*
+    Every entry from since to until: a binary search for the first,
+    since the times never go back, then a read forward
+*/
+int oplog_find_time (const char *path, long long since, long long until,
+                     int (*visit)(const OpLogEntry *entry, void *data), void *data) {
+    OpLogEntry entry;
+    FILE *index;
+    int entries, low, high, middle, visited = 0;
+
+    if ((entries = oplog_index_open(path, &index)) < 0)
+        return -1;
+
+    low = 0;
+    high = entries;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+
+        if (fseek(index, OPLOG_HEADER + (long)middle * (long)sizeof(OpLogEntry), SEEK_SET) != 0 ||
+            fread(&entry, sizeof(OpLogEntry), 1, index) != 1) {
+            fclose(index);
+            return -1;
+        }
+
+        if (entry.time < since)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    fseek(index, OPLOG_HEADER + (long)low * (long)sizeof(OpLogEntry), SEEK_SET);
+
+    for (; low < entries; low++) {
+        if (fread(&entry, sizeof(OpLogEntry), 1, index) != 1) {
+            fclose(index);
+            return -1;
+        }
+
+        if (entry.time > until)
+            break;
+
+        visited++;
+
+        if (visit(&entry, data) != 0)
+            break;
+    }
+
+    fclose(index);
+
+    return visited;
+}
+
+/*
+    The text of the record of entry
+*/
+int oplog_read (const char *path, const OpLogEntry *entry, char *text, size_t size) {
+    FILE *file;
+    size_t length;
+
+    if (size == 0 || entry->offset < 0 || entry->length < 0 || (file = fopen(path, "rb")) == NULL)
+        return -1;
+
+    length = (size_t)entry->length < size - 1 ? (size_t)entry->length : size - 1;
+
+    if (fseek(file, (long)entry->offset, SEEK_SET) != 0 || fread(text, 1, length, file) != length) {
+        fclose(file);
+        return -1;
+    }
+
+    text[length] = '\0';
+    fclose(file);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+    pstack.c
+*/
+#include <stdlib.h>
+
+#include "pstack.h"
+#include "stats.h"
+
+/*
+    Drop one reference to node, and the nodes under it that were only
+    kept by it. A loop and not recursion, the chain can be long
+*/
+static void pstack_release (PStackNode *node, void (*destroy)(void *data)) {
+    PStackNode *next;
+
+    while (node != NULL && --node->refs == 0) {
+        next = node->next;
+
+        if (destroy != NULL)
+            destroy(node->data);
+
+        free(node);
+        stats_free(STATS_STACK);
+        node = next;
+    }
+
+    return;
+}
+
+/*
+    Make to the version with top and size, the reference to top is
+    already taken
+*/
+static void pstack_set (PStack *to, const PStack *from, PStackNode *top, int size) {
+    void (*destroy)(void *data) = from->destroy;
+
+    pstack_release(to->top, to->destroy);
+    to->top = top;
+    to->size = size;
+    to->destroy = destroy;
+
+    return;
+}
+
+/*
+    Initialize an empty version
+*/
+void pstack_init (PStack *stack, void (*destroy)(void *data)) {
+    stack->size = 0;
+    stack->destroy = destroy;
+    stack->top = NULL;
+
+    return;
+}
+
+/*
+    Release this version, the nodes other versions share are kept
+*/
+void pstack_destroy (PStack *stack) {
+    pstack_release(stack->top, stack->destroy);
+    stack->top = NULL;
+    stack->size = 0;
+
+    return;
+}
+
+/*
+    to becomes from with data on top
+*/
+int pstack_push (PStack *to, const PStack *from, const void *data) {
+    PStackNode *node;
+
+    if ((node = (PStackNode *)malloc(sizeof(PStackNode))) == NULL)
+        return -1;
+
+    node->data = (void *)data;
+    node->next = from->top;
+    node->refs = 1;
+
+    if (node->next != NULL)
+        node->next->refs++;
+
+    stats_alloc(STATS_STACK, sizeof(PStackNode));
+    stats_stack_depth(from->size + 1);
+    pstack_set(to, from, node, from->size + 1);
+
+    return 0;
+}
+
+/*
+    to becomes from without its top, whose data goes to *data
+*/
+int pstack_pop (PStack *to, const PStack *from, void **data) {
+    PStackNode *next;
+
+    if (from->top == NULL)
+        return -1;
+
+    *data = from->top->data;
+    next = from->top->next;
+
+    if (next != NULL)
+        next->refs++;
+
+    pstack_set(to, from, next, from->size - 1);
+
+    return 0;
+}
+
+/*
+    to becomes another reference to the version from
+*/
+void pstack_copy (PStack *to, const PStack *from) {
+
+    if (from->top != NULL)
+        from->top->refs++;
+
+    pstack_set(to, from, from->top, from->size);
+
+    return;
+}
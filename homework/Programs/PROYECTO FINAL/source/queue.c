@@ -5,13 +5,19 @@
 
 #include "list.h"
 #include "queue.h"
+#include "stats.h"
 
 /*
     Enqueue
 */
 int queue_enqueue (Queue *queue, const void *data) {
 
-    return list_ins_next(queue, list_tail(queue), data);
+    if (list_ins_next(queue, list_tail(queue), data) != 0)
+        return -1;
+
+    stats_alloc(STATS_QUEUE, sizeof(ListNode));
+
+    return 0;
 }
 
 /*
@@ -19,5 +25,36 @@ int queue_enqueue (Queue *queue, const void *data) {
 */
 int queue_dequeue (Queue *queue, void **data) {
     
-    return list_rem_next(queue, NULL, data);
+    if (list_rem_next(queue, NULL, data) != 0)
+        return -1;
+
+    stats_free(STATS_QUEUE);
+
+    return 0;
+}
+
+/*
+    Enqueue a copy of size bytes of data, stored inside the node
+*/
+int queue_enqueue_copy (Queue *queue, const void *data, size_t size) {
+
+    if (list_ins_next_copy(queue, list_tail(queue), data, size) != 0)
+        return -1;
+
+    stats_alloc(STATS_QUEUE, LIST_CACHE_LINE);
+
+    return 0;
+}
+
+/*
+    Dequeue, copying size bytes of the data out
+*/
+int queue_dequeue_copy (Queue *queue, void *data, size_t size) {
+
+    if (list_rem_next_copy(queue, NULL, data, size) != 0)
+        return -1;
+
+    stats_free(STATS_QUEUE);
+
+    return 0;
 }
@@ -0,0 +1,430 @@
+/*
+    rope.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "rope.h"
+
+#define rope_bytes(node) ((node) == NULL ? (size_t)0 : (node)->bytes)
+
+/*
+    Next priority, xorshift on the seed of the rope
+*/
+static unsigned int rope_priority (Rope *rope) {
+    rope->seed ^= rope->seed << 13;
+    rope->seed ^= rope->seed >> 17;
+    rope->seed ^= rope->seed << 5;
+
+    return rope->seed;
+}
+
+/*
+    Recompute the bytes of node from its chunk and children
+*/
+static void rope_update (RopeNode *node) {
+    node->bytes = (size_t)node->length + rope_bytes(node->left) + rope_bytes(node->right);
+    return;
+}
+
+/*
+    New chunk holding length bytes of text, at most ROPE_CHUNK
+*/
+static RopeNode *rope_node (Rope *rope, const char *text, int length) {
+    RopeNode *node;
+
+    if ((node = (RopeNode *)malloc(sizeof(RopeNode))) == NULL)
+        return NULL;
+
+    node->left = NULL;
+    node->right = NULL;
+    node->priority = rope_priority(rope);
+    node->length = length;
+    node->bytes = (size_t)length;
+    memcpy(node->text, text, (size_t)length);
+
+    return node;
+}
+
+/*
+    Free every node of the tree
+*/
+static void rope_free (RopeNode *node) {
+
+    if (node == NULL)
+        return;
+
+    rope_free(node->left);
+    rope_free(node->right);
+    free(node);
+
+    return;
+}
+
+/*
+    Join two trees, every chunk of a before every chunk of b
+*/
+static RopeNode *rope_merge (RopeNode *a, RopeNode *b) {
+
+    if (a == NULL)
+        return b;
+
+    if (b == NULL)
+        return a;
+
+    if (a->priority > b->priority) {
+        a->right = rope_merge(a->right, b);
+        rope_update(a);
+        return a;
+    }
+
+    b->left = rope_merge(a, b->left);
+    rope_update(b);
+
+    return b;
+}
+
+/*
+    Split node into the first offset bytes, *a, and the rest, *b
+    An offset inside a chunk cuts it, the second half goes in *spare,
+    which is set to NULL once used
+*/
+static void rope_split (RopeNode *node, size_t offset, RopeNode **a, RopeNode **b, RopeNode **spare) {
+    RopeNode *second;
+    size_t left;
+    int cut;
+
+    if (node == NULL) {
+        *a = NULL;
+        *b = NULL;
+        return;
+    }
+
+    left = rope_bytes(node->left);
+
+    if (offset <= left) {
+        rope_split(node->left, offset, a, &node->left, spare);
+        rope_update(node);
+        *b = node;
+    } else if (offset >= left + (size_t)node->length) {
+        rope_split(node->right, offset - left - (size_t)node->length, &node->right, b, spare);
+        rope_update(node);
+        *a = node;
+    } else {
+        // Same priority as node, so node->right can stay under it
+        cut = (int)(offset - left);
+        second = *spare;
+        *spare = NULL;
+
+        second->length = node->length - cut;
+        memcpy(second->text, node->text + cut, (size_t)second->length);
+        second->priority = node->priority;
+        second->left = NULL;
+        second->right = node->right;
+
+        node->length = cut;
+        node->right = NULL;
+
+        rope_update(second);
+        rope_update(node);
+
+        *a = node;
+        *b = second;
+    }
+
+    return;
+}
+
+/*
+    Unlink the first chunk of node into *head
+*/
+static RopeNode *rope_remove_head (RopeNode *node, RopeNode **head) {
+
+    if (node->left == NULL) {
+        *head = node;
+        return node->right;
+    }
+
+    node->left = rope_remove_head(node->left, head);
+    rope_update(node);
+
+    return node;
+}
+
+/*
+    Append length bytes to the last chunk of node
+*/
+static void rope_append_tail (RopeNode *node, const char *text, int length) {
+    node->bytes += (size_t)length;
+
+    if (node->right != NULL) {
+        rope_append_tail(node->right, text, length);
+        return;
+    }
+
+    memcpy(node->text + node->length, text, (size_t)length);
+    node->length += length;
+
+    return;
+}
+
+/*
+    rope_merge, folding the two chunks at the seam into one when they
+    fit, so edits do not leave the rope in ever smaller chunks
+*/
+static RopeNode *rope_join (RopeNode *a, RopeNode *b) {
+    RopeNode *last, *head;
+
+    if (a == NULL || b == NULL)
+        return rope_merge(a, b);
+
+    for (last = a; last->right != NULL; last = last->right)
+        ;
+
+    for (head = b; head->left != NULL; head = head->left)
+        ;
+
+    if (last->length + head->length <= ROPE_CHUNK) {
+        b = rope_remove_head(b, &head);
+        rope_append_tail(a, head->text, head->length);
+        free(head);
+    }
+
+    return rope_merge(a, b);
+}
+
+/*
+    Chunk holding offset, position in it in *index
+    An offset between two chunks is at the end of the first one
+*/
+static RopeNode *rope_find (RopeNode *node, size_t offset, int *index) {
+    size_t left;
+
+    while (node != NULL) {
+        left = rope_bytes(node->left);
+
+        if (offset <= left && node->left != NULL) {
+            node = node->left;
+        } else if (offset <= left + (size_t)node->length) {
+            *index = (int)(offset - left);
+            return node;
+        } else {
+            offset -= left + (size_t)node->length;
+            node = node->right;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    Add delta to the bytes of every node on the way to offset, the
+    same path as rope_find; before the chunk itself changes length
+*/
+static void rope_adjust (RopeNode *node, size_t offset, long delta) {
+    size_t left;
+
+    while (node != NULL) {
+        node->bytes = (size_t)((long)node->bytes + delta);
+        left = rope_bytes(node->left);
+
+        if (offset <= left && node->left != NULL) {
+            node = node->left;
+        } else if (offset <= left + (size_t)node->length) {
+            return;
+        } else {
+            offset -= left + (size_t)node->length;
+            node = node->right;
+        }
+    }
+
+    return;
+}
+
+/*
+    Copy length bytes from offset of the tree into text
+*/
+static void rope_copy (const RopeNode *node, size_t offset, size_t length, char *text) {
+    size_t left, count;
+
+    if (node == NULL || length == 0)
+        return;
+
+    left = rope_bytes(node->left);
+
+    if (offset < left) {
+        count = length < left - offset ? length : left - offset;
+        rope_copy(node->left, offset, count, text);
+        text += count;
+        length -= count;
+        offset = left;
+    }
+
+    if (length > 0 && offset < left + (size_t)node->length) {
+        count = left + (size_t)node->length - offset;
+        count = length < count ? length : count;
+        memcpy(text, node->text + (offset - left), count);
+        text += count;
+        length -= count;
+        offset += count;
+    }
+
+    if (length > 0)
+        rope_copy(node->right, offset - left - (size_t)node->length, length, text);
+
+    return;
+}
+
+/*
+    Hand every chunk of the tree to visit in order, stopping at a nonzero return
+*/
+static int rope_visit (const RopeNode *node, int (*visit)(void *arg, const char *text, size_t length),
+                       void *arg) {
+    int retval;
+
+    if (node == NULL)
+        return 0;
+
+    if ((retval = rope_visit(node->left, visit, arg)) != 0)
+        return retval;
+
+    if ((retval = visit(arg, node->text, (size_t)node->length)) != 0)
+        return retval;
+
+    return rope_visit(node->right, visit, arg);
+}
+
+/*
+    Initialize the rope
+*/
+void rope_init (Rope *rope) {
+    rope->root = NULL;
+    rope->seed = 2463534242u;
+
+    return;
+}
+
+/*
+    Destroying the rope
+*/
+void rope_destroy (Rope *rope) {
+    rope_free(rope->root);
+    memset(rope, 0, sizeof(Rope));
+
+    return;
+}
+
+/*
+    Insert length bytes of text at offset
+*/
+int rope_insert (Rope *rope, size_t offset, const char *text, size_t length) {
+    RopeNode *node, *middle = NULL, *a, *b, *spare;
+    size_t done;
+    int index, count;
+
+    if (offset > rope_length(rope))
+        return -1;
+
+    if (length == 0)
+        return 0;
+
+    // Room in the chunk at offset: shift its tail, nothing else moves
+    node = rope_find(rope->root, offset, &index);
+
+    if (node != NULL && (size_t)(ROPE_CHUNK - node->length) >= length) {
+        rope_adjust(rope->root, offset, (long)length);
+        memmove(node->text + index + length, node->text + index, (size_t)(node->length - index));
+        memcpy(node->text + index, text, length);
+        node->length += (int)length;
+        return 0;
+    }
+
+    // Build the new chunks first, the rope is untouched on failure
+    for (done = 0; done < length; done += (size_t)count) {
+        count = length - done < ROPE_CHUNK ? (int)(length - done) : ROPE_CHUNK;
+
+        if ((node = rope_node(rope, text + done, count)) == NULL) {
+            rope_free(middle);
+            return -1;
+        }
+
+        middle = rope_merge(middle, node);
+    }
+
+    if ((spare = (RopeNode *)malloc(sizeof(RopeNode))) == NULL) {
+        rope_free(middle);
+        return -1;
+    }
+
+    rope_split(rope->root, offset, &a, &b, &spare);
+    rope->root = rope_join(rope_join(a, middle), b);
+    free(spare);
+
+    return 0;
+}
+
+/*
+    Delete length bytes from offset
+*/
+int rope_delete (Rope *rope, size_t offset, size_t length) {
+    RopeNode *node, *a, *b, *middle, *c, *spares[2];
+    int index;
+
+    if (offset > rope_length(rope) || length > rope_length(rope) - offset)
+        return -1;
+
+    if (length == 0)
+        return 0;
+
+    // Inside one chunk, and some of it stays: close the gap in place
+    node = rope_find(rope->root, offset + 1, &index);
+    index--;
+
+    if ((size_t)index + length <= (size_t)node->length && length < (size_t)node->length) {
+        rope_adjust(rope->root, offset + 1, -(long)length);
+        memmove(node->text + index, node->text + index + length, (size_t)node->length - index - length);
+        node->length -= (int)length;
+        return 0;
+    }
+
+    spares[0] = (RopeNode *)malloc(sizeof(RopeNode));
+    spares[1] = (RopeNode *)malloc(sizeof(RopeNode));
+
+    if (spares[0] == NULL || spares[1] == NULL) {
+        free(spares[0]);
+        free(spares[1]);
+        return -1;
+    }
+
+    rope_split(rope->root, offset, &a, &b, &spares[0]);
+    rope_split(b, length, &middle, &c, &spares[1]);
+    rope_free(middle);
+    rope->root = rope_join(a, c);
+
+    free(spares[0]);
+    free(spares[1]);
+
+    return 0;
+}
+
+/*
+    Copy length bytes from offset to text, NUL terminated
+*/
+int rope_substr (const Rope *rope, size_t offset, size_t length, char *text) {
+
+    if (offset > rope_length(rope) || length > rope_length(rope) - offset)
+        return -1;
+
+    rope_copy(rope->root, offset, length, text);
+    text[length] = '\0';
+
+    return 0;
+}
+
+/*
+    Visit the chunks in text order
+*/
+int rope_foreach_chunk (const Rope *rope, int (*visit)(void *arg, const char *text, size_t length),
+                        void *arg) {
+    return rope_visit(rope->root, visit, arg);
+}
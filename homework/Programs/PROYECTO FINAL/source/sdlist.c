@@ -0,0 +1,127 @@
+/*
+    sdlist.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdlist.h"
+
+/*
+    Initialize the sdlist, the sentinel points to itself
+*/
+void sdlist_init (SDList *list, void (*destroy)(void *data)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->sentinel.data = NULL;
+    list->sentinel.next = &list->sentinel;
+    list->sentinel.prev = &list->sentinel;
+
+    return;
+}
+
+/*
+    Destroying the sdlist
+*/
+void sdlist_destroy (SDList *list) {
+    void *data;
+
+    while (sdlist_size(list) > 0) {
+        if (sdlist_remove(list, sdlist_tail(list), &data) == 0 && list->destroy != NULL)
+            list->destroy(data);
+    }
+
+    memset(list, 0, sizeof(SDList));
+    return;
+}
+
+/*
+    Insert next node at the sdlist
+*/
+int sdlist_ins_next (SDList *list, SDListNode *node, const void *data) {
+    SDListNode *new_node;
+
+    if ((new_node = (SDListNode *)malloc(sizeof(SDListNode))) == NULL)
+        return -1;
+
+    new_node->data = (void *)data;
+    new_node->prev = node;
+    new_node->next = node->next;
+    node->next->prev = new_node;
+    node->next = new_node;
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Insert previous node at the sdlist
+*/
+int sdlist_ins_prev (SDList *list, SDListNode *node, const void *data) {
+    SDListNode *new_node;
+
+    if ((new_node = (SDListNode *)malloc(sizeof(SDListNode))) == NULL)
+        return -1;
+
+    new_node->data = (void *)data;
+    new_node->next = node;
+    new_node->prev = node->prev;
+    node->prev->next = new_node;
+    node->prev = new_node;
+
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Remove node at the sdlist, never the sentinel
+*/
+int sdlist_remove (SDList *list, SDListNode *node, void **data) {
+
+    if (node == sdlist_end(list))
+        return -1;
+
+    *data = node->data;
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+
+    free(node);
+    list->size--;
+
+    return 0;
+}
+
+/*
+    Move all of other after node
+*/
+void sdlist_splice (SDList *list, SDListNode *node, SDList *other) {
+    SDListNode *first, *last;
+
+    if (sdlist_size(other) == 0)
+        return;
+
+    first = sdlist_head(other);
+    last = sdlist_tail(other);
+
+    first->prev = node;
+    last->next = node->next;
+    node->next->prev = last;
+    node->next = first;
+
+    list->size += other->size;
+
+    other->size = 0;
+    other->sentinel.next = &other->sentinel;
+    other->sentinel.prev = &other->sentinel;
+
+    return;
+}
+
+/*
+    Move all of other to the tail
+*/
+void sdlist_concat (SDList *list, SDList *other) {
+    sdlist_splice(list, sdlist_tail(list), other);
+    return;
+}
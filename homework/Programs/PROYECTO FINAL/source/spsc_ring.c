@@ -0,0 +1,153 @@
+/*
+    spsc_ring.c
+*/
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include "spsc_ring.h"
+
+/* Failed attempts before a blocking call gives up its time slice */
+#define SPSC_SPINS 64
+
+/*
+    Give up the rest of the time slice
+*/
+static void spsc_yield (void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/*
+    Initialize, the capacity is rounded up to a power of two
+*/
+int spsc_ring_init (SPSCRing *ring, size_t capacity) {
+    size_t size = 2;
+
+    while (size < capacity)
+        size <<= 1;
+
+    memset(ring, 0, sizeof(SPSCRing));
+
+    if ((ring->buffer = (void **)malloc(size * sizeof(void *))) == NULL)
+        return -1;
+
+    ring->mask = size - 1;
+
+    return 0;
+}
+
+/*
+    Destroy, the elements still in the ring are not freed
+*/
+void spsc_ring_destroy (SPSCRing *ring) {
+    free(ring->buffer);
+    memset(ring, 0, sizeof(SPSCRing));
+
+    return;
+}
+
+/*
+    Push without waiting, returns -1 when the ring is full
+    Producer thread only
+*/
+int spsc_ring_try_push (SPSCRing *ring, const void *data) {
+    size_t head = ring->head;
+
+    if (head - ring->cached_tail > ring->mask) {
+        ring->cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        if (head - ring->cached_tail > ring->mask)
+            return -1;
+    }
+
+    ring->buffer[head & ring->mask] = (void *)data;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+    Pop without waiting, returns -1 when the ring is empty
+    Consumer thread only
+*/
+int spsc_ring_try_pop (SPSCRing *ring, void **data) {
+    size_t tail = ring->tail;
+
+    if (tail == ring->cached_head) {
+        ring->cached_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        if (tail == ring->cached_head)
+            return -1;
+    }
+
+    *data = ring->buffer[tail & ring->mask];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+    Push, waits while the ring is full
+*/
+int spsc_ring_push (SPSCRing *ring, const void *data) {
+    int spins = 0;
+
+    if (spsc_ring_try_push(ring, data) == 0)
+        return 0;
+
+    ring->full++;
+
+    while (spsc_ring_try_push(ring, data) != 0) {
+        if (++spins >= SPSC_SPINS) {
+            spsc_yield();
+            spins = 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    Pop, waits while the ring is empty
+    Returns -1 once the ring is closed and drained
+*/
+int spsc_ring_pop (SPSCRing *ring, void **data) {
+    int spins = 0;
+
+    if (spsc_ring_try_pop(ring, data) == 0)
+        return 0;
+
+    ring->empty++;
+
+    while (spsc_ring_try_pop(ring, data) != 0) {
+        // Closed: one last look, the final push may have raced the close
+        if (__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE))
+            return spsc_ring_try_pop(ring, data);
+
+        if (++spins >= SPSC_SPINS) {
+            spsc_yield();
+            spins = 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    Close, the producer will not push any more
+*/
+void spsc_ring_close (SPSCRing *ring) {
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_RELEASE);
+    return;
+}
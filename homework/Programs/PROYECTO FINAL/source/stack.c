@@ -5,13 +5,20 @@
 
 #include "list.h"
 #include "stack.h"
+#include "stats.h"
 
 /*
     Stack push
 */
 int stack_push (Stack *stack, const void *data) {
 
-    return list_ins_next(stack, NULL, data);
+    if (list_ins_next(stack, NULL, data) != 0)
+        return -1;
+
+    stats_alloc(STATS_STACK, sizeof(ListNode));
+    stats_stack_depth(stack_size(stack));
+
+    return 0;
 }
 
 /*
@@ -19,5 +26,10 @@ int stack_push (Stack *stack, const void *data) {
 */
 int stack_pop (Stack *stack, void **data) {
     
-    return list_rem_next(stack, NULL, data);
+    if (list_rem_next(stack, NULL, data) != 0)
+        return -1;
+
+    stats_free(STATS_STACK);
+
+    return 0;
 }
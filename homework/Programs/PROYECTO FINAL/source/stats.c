@@ -0,0 +1,174 @@
+/*
+    stats.c
+*/
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "stats.h"
+#include "trace.h"
+
+Stats stats_counters;
+
+static const char *phase_names[STATS_PHASES] = {
+    "tokenize", "validate_syntax", "conversion", "evaluation", "rendering", "file_save"
+};
+
+static const char *container_names[STATS_CONTAINERS] = {
+    "list", "dlist", "stack", "queue"
+};
+
+/*
+    Output selected with CALC_STATS at startup
+*/
+static int dump_format = -1;
+static const char *dump_path = NULL;
+
+/*
+    Dump the counters at exit
+*/
+static void stats_at_exit (void) {
+    FILE *out = stderr;
+
+    if (dump_path != NULL && (out = fopen(dump_path, "w")) == NULL)
+        return;
+
+    stats_dump(out, dump_format);
+
+    if (out != stderr)
+        fclose(out);
+}
+
+/*
+    Initialize the counters and the tracer
+    CALC_STATS=text|json dumps a summary at exit, to stderr or to the
+    file named by CALC_STATS_FILE
+*/
+void stats_init (void) {
+    const char *format = getenv("CALC_STATS");
+
+    stats_reset();
+    trace_init();
+
+    if (format == NULL || dump_format != -1)
+        return;
+
+    if (strcmp(format, "json") == 0)
+        dump_format = 1;
+    else if (strcmp(format, "text") == 0 || strcmp(format, "1") == 0)
+        dump_format = 0;
+    else
+        return;
+
+    dump_path = getenv("CALC_STATS_FILE");
+    atexit(stats_at_exit);
+
+    return;
+}
+
+/*
+    Clear every counter
+*/
+void stats_reset (void) {
+    memset(&stats_counters, 0, sizeof(Stats));
+    return;
+}
+
+/*
+    Monotonic clock in nanoseconds
+*/
+unsigned long long stats_now (void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+
+    return (unsigned long long)(count.QuadPart / freq.QuadPart) * 1000000000ULL +
+           (unsigned long long)(count.QuadPart % freq.QuadPart) * 1000000000ULL / freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+/*
+    Start timing a phase, returns the start time for stats_phase_end
+*/
+unsigned long long stats_phase_begin (StatsPhase phase) {
+    stats_add(stats_counters.phase_calls[phase], 1);
+    trace_begin(phase_names[phase], "phase", -1);
+
+    return stats_now();
+}
+
+/*
+    Stop timing a phase
+*/
+void stats_phase_end (StatsPhase phase, unsigned long long start) {
+    stats_add(stats_counters.phase_ns[phase], stats_now() - start);
+    trace_end(phase_names[phase], "phase");
+    return;
+}
+
+/*
+    Name of a phase
+*/
+const char *stats_phase_name (StatsPhase phase) {
+    return (phase >= 0 && phase < STATS_PHASES) ? phase_names[phase] : "unknown";
+}
+
+/*
+    Write a summary of the counters as text or JSON
+*/
+void stats_dump (FILE *out, int json) {
+    int i;
+
+    if (json) {
+        fprintf(out, "{\n  \"phases\": {");
+        for (i = 0; i < STATS_PHASES; i++) {
+            fprintf(out, "%s\n    \"%s\": {\"calls\": %llu, \"ns\": %llu}", i ? "," : "",
+                    phase_names[i], stats_counters.phase_calls[i], stats_counters.phase_ns[i]);
+        }
+        fprintf(out, "\n  },\n  \"containers\": {");
+        for (i = 0; i < STATS_CONTAINERS; i++) {
+            fprintf(out, "%s\n    \"%s\": {\"allocs\": %llu, \"frees\": %llu, \"bytes\": %llu}",
+                    i ? "," : "", container_names[i], stats_counters.allocs[i],
+                    stats_counters.frees[i], stats_counters.bytes[i]);
+        }
+        fprintf(out, "\n  },\n  \"peak_stack_depth\": %llu,\n  \"steps\": %llu,\n  \"scanned\": %llu\n}\n",
+                stats_counters.peak_stack_depth, stats_counters.steps, stats_counters.scanned);
+        return;
+    }
+
+    fprintf(out, "+----------------------+------------+------------------+\n");
+    fprintf(out, "| %-20s | %10s | %16s |\n", "PHASE", "CALLS", "TIME (us)");
+    fprintf(out, "+----------------------+------------+------------------+\n");
+    for (i = 0; i < STATS_PHASES; i++) {
+        fprintf(out, "| %-20s | %10llu | %16.1f |\n", phase_names[i],
+                stats_counters.phase_calls[i], stats_counters.phase_ns[i] / 1000.0);
+    }
+    fprintf(out, "+----------------------+------------+------------+-----------+\n");
+    fprintf(out, "| %-20s | %10s | %10s | %9s |\n", "CONTAINER", "ALLOCS", "FREES", "BYTES");
+    fprintf(out, "+----------------------+------------+------------+-----------+\n");
+    for (i = 0; i < STATS_CONTAINERS; i++) {
+        fprintf(out, "| %-20s | %10llu | %10llu | %9llu |\n", container_names[i],
+                stats_counters.allocs[i], stats_counters.frees[i], stats_counters.bytes[i]);
+    }
+    fprintf(out, "+----------------------+------------+------------+-----------+\n");
+    fprintf(out, "  Peak stack depth: %llu\n", stats_counters.peak_stack_depth);
+    fprintf(out, "  Steps emitted:    %llu\n", stats_counters.steps);
+    fprintf(out, "  Chars rescanned:  %llu\n", stats_counters.scanned);
+
+    return;
+}
@@ -0,0 +1,274 @@
+/*
+    stepcode.c
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "stepcode.h"
+
+/*
+    Tag byte: the kind in bits 0-1, the operator in bits 2-4, where 7
+    means the operator byte follows the tag
+*/
+static const char stepcode_kinds[4] = {'N', 'O', 'P', 'A'};
+static const char stepcode_operators[7] = {'\0', '+', '-', '*', '/', '^', '('};
+
+#define STEPCODE_RAW_OPERATOR 7
+
+/*
+    What both sides remember inside a block
+*/
+typedef struct StepCoder_ {
+    double results[STEPCODE_WINDOW];
+    int count;
+    long long whole;
+} StepCoder;
+
+/*
+    Bytes being read, pos moves past what was read
+*/
+typedef struct StepInput_ {
+    const unsigned char *pos;
+    const unsigned char *end;
+} StepInput;
+
+/*
+    Largest magnitude stored as a whole number, 2^52
+*/
+#define STEPCODE_WHOLE_MAX 4503599627370496.0
+
+/*
+    Position of c in the first size entries of table, -1 when absent
+*/
+static int stepcode_index (const char *table, int size, char c) {
+    int i;
+
+    for (i = 0; i < size; i++) {
+        if (table[i] == c)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+    Add result to the window of the last results
+*/
+static void stepcode_remember (StepCoder *coder, double result) {
+    coder->results[coder->count % STEPCODE_WINDOW] = result;
+    coder->count++;
+
+    return;
+}
+
+/*
+    Write value 7 bits a byte, low bits first, the high bit set on all but the last
+*/
+static unsigned char *stepcode_put_varint (unsigned char *out, unsigned long long value) {
+
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    *out++ = (unsigned char)value;
+
+    return out;
+}
+
+/*
+    Read a value written by stepcode_put_varint, -1 when it is cut short or too long
+*/
+static int stepcode_get_varint (StepInput *input, unsigned long long *value) {
+    int shift;
+
+    *value = 0;
+
+    for (shift = 0; shift < 64; shift += 7) {
+        if (input->pos == input->end)
+            return -1;
+
+        *value |= (unsigned long long)(*input->pos & 0x7F) << shift;
+
+        if ((*input->pos++ & 0x80) == 0)
+            return 0;
+    }
+
+    return -1;
+}
+
+/*
+    A whole number as the zigzag of its difference from the last one,
+    shifted left with bit 0 clear; anything else as 1 and its bytes
+*/
+static unsigned char *stepcode_put_number (StepCoder *coder, unsigned char *out, double value) {
+    long long whole, delta;
+    unsigned long long zigzag;
+
+    if (value >= -STEPCODE_WHOLE_MAX && value <= STEPCODE_WHOLE_MAX && value == (double)(long long)value &&
+        !(value == 0 && signbit(value))) {
+        whole = (long long)value;
+        delta = whole - coder->whole;
+        zigzag = delta < 0 ? ~((unsigned long long)delta << 1) : (unsigned long long)delta << 1;
+        coder->whole = whole;
+
+        return stepcode_put_varint(out, zigzag << 1);
+    }
+
+    out = stepcode_put_varint(out, 1);
+    memcpy(out, &value, sizeof(double));
+
+    return out + sizeof(double);
+}
+
+/*
+    Read a number written by stepcode_put_number
+*/
+static int stepcode_get_number (StepCoder *coder, StepInput *input, double *value) {
+    unsigned long long code, zigzag;
+
+    if (stepcode_get_varint(input, &code) != 0)
+        return -1;
+
+    if (code == 1) {
+        if (input->end - input->pos < (long)sizeof(double))
+            return -1;
+
+        memcpy(value, input->pos, sizeof(double));
+        input->pos += sizeof(double);
+
+        return 0;
+    }
+
+    if (code & 1)
+        return -1;
+
+    zigzag = code >> 1;
+    coder->whole += (zigzag & 1) ? (long long)~(zigzag >> 1) : (long long)(zigzag >> 1);
+    *value = (double)coder->whole;
+
+    return 0;
+}
+
+/*
+    An operand found among the last results as its distance back,
+    shifted left with bit 0 clear; anything else as 1 and a number
+*/
+static unsigned char *stepcode_put_operand (StepCoder *coder, unsigned char *out, double value) {
+    int distance, seen = coder->count < STEPCODE_WINDOW ? coder->count : STEPCODE_WINDOW;
+
+    for (distance = 0; distance < seen; distance++) {
+        if (memcmp(&coder->results[(coder->count - 1 - distance) % STEPCODE_WINDOW], &value, sizeof(double)) == 0)
+            return stepcode_put_varint(out, (unsigned long long)distance << 1);
+    }
+
+    out = stepcode_put_varint(out, 1);
+
+    return stepcode_put_number(coder, out, value);
+}
+
+/*
+    Read an operand written by stepcode_put_operand
+*/
+static int stepcode_get_operand (StepCoder *coder, StepInput *input, double *value) {
+    unsigned long long code;
+    int seen = coder->count < STEPCODE_WINDOW ? coder->count : STEPCODE_WINDOW;
+
+    if (stepcode_get_varint(input, &code) != 0)
+        return -1;
+
+    if (code == 1)
+        return stepcode_get_number(coder, input, value);
+
+    if ((code & 1) || (code >> 1) >= (unsigned long long)seen)
+        return -1;
+
+    *value = coder->results[(coder->count - 1 - (int)(code >> 1)) % STEPCODE_WINDOW];
+
+    return 0;
+}
+
+/*
+    Encode count StepRecords into out, at most STEPCODE_MAX bytes each
+*/
+size_t stepcode_encode (const void *records, int count, unsigned char *out) {
+    const StepRecord *record = (const StepRecord *)records;
+    unsigned char *start = out;
+    StepCoder coder;
+    int i, kind, operator;
+
+    memset(&coder, 0, sizeof(StepCoder));
+
+    for (i = 0; i < count; i++, record++) {
+        if ((kind = stepcode_index(stepcode_kinds, 4, record->kind)) < 0)
+            return 0;
+
+        if ((operator = stepcode_index(stepcode_operators, 7, record->operator)) < 0)
+            operator = STEPCODE_RAW_OPERATOR;
+
+        *out++ = (unsigned char)(kind | operator << 2);
+
+        if (operator == STEPCODE_RAW_OPERATOR)
+            *out++ = (unsigned char)record->operator;
+
+        if (record->kind == 'N') {
+            out = stepcode_put_number(&coder, out, record->result);
+            stepcode_remember(&coder, record->result);
+        } else if (record->kind == 'A') {
+            out = stepcode_put_operand(&coder, out, record->operand1);
+            out = stepcode_put_operand(&coder, out, record->operand2);
+            out = stepcode_put_number(&coder, out, record->result);
+            stepcode_remember(&coder, record->result);
+        }
+    }
+
+    return (size_t)(out - start);
+}
+
+/*
+    Decode count StepRecords, 0 when the block held exactly them
+*/
+int stepcode_decode (const unsigned char *in, size_t length, void *records, int count) {
+    StepRecord *record = (StepRecord *)records;
+    StepInput input;
+    StepCoder coder;
+    int i, operator;
+
+    memset(&coder, 0, sizeof(StepCoder));
+    input.pos = in;
+    input.end = in + length;
+
+    for (i = 0; i < count; i++, record++) {
+        if (input.pos == input.end)
+            return -1;
+
+        memset(record, 0, sizeof(StepRecord));
+        record->kind = stepcode_kinds[*input.pos & 3];
+        operator = (*input.pos++ >> 2) & 7;
+
+        if (operator != STEPCODE_RAW_OPERATOR) {
+            record->operator = stepcode_operators[operator];
+        } else if (input.pos == input.end) {
+            return -1;
+        } else {
+            record->operator = (char)*input.pos++;
+        }
+
+        if (record->kind == 'N') {
+            if (stepcode_get_number(&coder, &input, &record->result) != 0)
+                return -1;
+
+            stepcode_remember(&coder, record->result);
+        } else if (record->kind == 'A') {
+            if (stepcode_get_operand(&coder, &input, &record->operand1) != 0 ||
+                stepcode_get_operand(&coder, &input, &record->operand2) != 0 ||
+                stepcode_get_number(&coder, &input, &record->result) != 0)
+                return -1;
+
+            stepcode_remember(&coder, record->result);
+        }
+    }
+
+    return input.pos == input.end ? 0 : -1;
+}
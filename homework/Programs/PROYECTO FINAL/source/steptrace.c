@@ -0,0 +1,433 @@
+/*
+    steptrace.c
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "steptrace.h"
+
+/*
+    Start of every saved trace
+*/
+static const char steptrace_magic[4] = {'S', 'T', 'R', 'C'};
+
+/*
+    Room for one more chunk pointer and length
+*/
+static int steptrace_reserve (StepTrace *trace) {
+    char **chunks;
+    size_t *lengths;
+    int capacity;
+
+    if (trace->chunk_count < trace->chunk_capacity)
+        return 0;
+
+    capacity = trace->chunk_capacity > 0 ? trace->chunk_capacity * 2 : 8;
+
+    if ((chunks = (char **)realloc(trace->chunks, (size_t)capacity * sizeof(char *))) == NULL)
+        return -1;
+
+    trace->chunks = chunks;
+
+    if ((lengths = (size_t *)realloc(trace->lengths, (size_t)capacity * sizeof(size_t))) == NULL)
+        return -1;
+
+    trace->lengths = lengths;
+    trace->chunk_capacity = capacity;
+
+    return 0;
+}
+
+/*
+    Encode the full last chunk into a block of its own size; the plain
+    chunk is handed back in *spare for the next records
+*/
+static int steptrace_seal (StepTrace *trace, char **spare) {
+    int last = trace->chunk_count - 1;
+    size_t length;
+    char *block;
+
+    length = trace->encode(trace->chunks[last], STEPTRACE_CHUNK, trace->scratch);
+
+    if (length == 0 || (block = (char *)malloc(length)) == NULL)
+        return -1;
+
+    memcpy(block, trace->scratch, length);
+    *spare = trace->chunks[last];
+    trace->chunks[last] = block;
+    trace->lengths[last] = length;
+
+    return 0;
+}
+
+/*
+    Keep a copy of the state before record index, replacing one already there
+*/
+static int steptrace_add_checkpoint (StepTrace *trace, int index, const void *state, size_t length) {
+    StepCheckpoint *checkpoints, *checkpoint;
+    void *copy;
+    int capacity;
+
+    if ((copy = malloc(length > 0 ? length : 1)) == NULL)
+        return -1;
+
+    memcpy(copy, state, length);
+
+    if (trace->checkpoint_count > 0 && trace->checkpoints[trace->checkpoint_count - 1].index == index) {
+        checkpoint = &trace->checkpoints[trace->checkpoint_count - 1];
+        free(checkpoint->state);
+    } else {
+        if (trace->checkpoint_count == trace->checkpoint_capacity) {
+            capacity = trace->checkpoint_capacity > 0 ? trace->checkpoint_capacity * 2 : 8;
+
+            if ((checkpoints = (StepCheckpoint *)realloc(trace->checkpoints,
+                    (size_t)capacity * sizeof(StepCheckpoint))) == NULL) {
+                free(copy);
+                return -1;
+            }
+
+            trace->checkpoints = checkpoints;
+            trace->checkpoint_capacity = capacity;
+        }
+
+        checkpoint = &trace->checkpoints[trace->checkpoint_count++];
+        checkpoint->index = index;
+    }
+
+    checkpoint->length = length;
+    checkpoint->state = copy;
+
+    return 0;
+}
+
+/*
+    Write length bytes of data, 0 when all of them are written
+*/
+static int steptrace_write (FILE *out, const void *data, size_t length) {
+    return length == 0 || fwrite(data, 1, length, out) == length ? 0 : -1;
+}
+
+/*
+    Read length bytes into data, 0 when all of them are read
+*/
+static int steptrace_read (FILE *in, void *data, size_t length) {
+    return length == 0 || fread(data, 1, length, in) == length ? 0 : -1;
+}
+
+/*
+    Initialize the trace, a checkpoint every interval records
+*/
+int steptrace_init (StepTrace *trace, int record_size, int interval) {
+
+    if (record_size <= 0)
+        return -1;
+
+    memset(trace, 0, sizeof(StepTrace));
+    trace->record_size = record_size;
+    trace->interval = interval > 0 ? interval : 64;
+    trace->window_chunk = -1;
+
+    return 0;
+}
+
+/*
+    Destroying the trace
+*/
+void steptrace_destroy (StepTrace *trace) {
+    int i;
+
+    for (i = 0; i < trace->chunk_count; i++)
+        free(trace->chunks[i]);
+
+    for (i = 0; i < trace->checkpoint_count; i++)
+        free(trace->checkpoints[i].state);
+
+    free(trace->chunks);
+    free(trace->lengths);
+    free(trace->checkpoints);
+    free(trace->window);
+    free(trace->scratch);
+    memset(trace, 0, sizeof(StepTrace));
+
+    return;
+}
+
+/*
+    Seal full chunks with encode and read them back with decode
+*/
+int steptrace_set_codec (StepTrace *trace, size_t (*encode)(const void *records, int count, unsigned char *out),
+                         int (*decode)(const unsigned char *in, size_t length, void *records, int count),
+                         int encoded_max) {
+
+    if (trace->size > 0 || trace->encode != NULL || encoded_max <= 0)
+        return -1;
+
+    trace->window = (char *)malloc((size_t)STEPTRACE_CHUNK * trace->record_size);
+    trace->scratch = (unsigned char *)malloc((size_t)STEPTRACE_CHUNK * encoded_max);
+
+    if (trace->window == NULL || trace->scratch == NULL) {
+        free(trace->window);
+        free(trace->scratch);
+        trace->window = NULL;
+        trace->scratch = NULL;
+        return -1;
+    }
+
+    trace->encode = encode;
+    trace->decode = decode;
+    trace->encoded_max = encoded_max;
+
+    return 0;
+}
+
+/*
+    Append a copy of record, a new chunk when the last one is full
+*/
+int steptrace_append (StepTrace *trace, const void *record) {
+    char *chunk = NULL;
+
+    if (trace->size == trace->chunk_count * STEPTRACE_CHUNK) {
+        if (steptrace_reserve(trace) != 0)
+            return -1;
+
+        if (trace->encode != NULL && trace->chunk_count > 0) {
+            if (steptrace_seal(trace, &chunk) != 0)
+                return -1;
+        } else if ((chunk = (char *)malloc((size_t)STEPTRACE_CHUNK * trace->record_size)) == NULL) {
+            return -1;
+        }
+
+        trace->chunks[trace->chunk_count] = chunk;
+        trace->lengths[trace->chunk_count] = 0;
+        trace->chunk_count++;
+    }
+
+    memcpy(trace->chunks[trace->chunk_count - 1] + (size_t)(trace->size % STEPTRACE_CHUNK) * trace->record_size,
+           record, (size_t)trace->record_size);
+    trace->size++;
+
+    return 0;
+}
+
+/*
+    Record index, decoding its chunk into the window when it is sealed
+*/
+void *steptrace_at (StepTrace *trace, int index) {
+    int chunk = index / STEPTRACE_CHUNK;
+    size_t offset = (size_t)(index % STEPTRACE_CHUNK) * trace->record_size;
+
+    if (index < 0 || index >= trace->size)
+        return NULL;
+
+    if (trace->lengths[chunk] == 0)
+        return trace->chunks[chunk] + offset;
+
+    if (trace->window_chunk != chunk) {
+        trace->window_chunk = -1;
+
+        if (trace->decode((unsigned char *)trace->chunks[chunk], trace->lengths[chunk], trace->window,
+                          STEPTRACE_CHUNK) != 0)
+            return NULL;
+
+        trace->window_chunk = chunk;
+    }
+
+    return trace->window + offset;
+}
+
+/*
+    Keep a copy of the state before the next record, a second one at
+    the same place replaces the first
+*/
+int steptrace_checkpoint (StepTrace *trace, const void *state, size_t length) {
+    return steptrace_add_checkpoint(trace, trace->size, state, length);
+}
+
+/*
+    State after record index: binary search for the last checkpoint at
+    or before index + 1, then replay from there
+*/
+int steptrace_state (StepTrace *trace, int index, void *state,
+                     int (*restore)(void *state, const void *checkpoint, size_t length),
+                     int (*apply)(void *state, const void *record)) {
+    const StepCheckpoint *checkpoint = NULL;
+    int low = 0, high = trace->checkpoint_count - 1, middle, i;
+    void *record;
+
+    if (index < 0 || index >= trace->size)
+        return -1;
+
+    while (low <= high) {
+        middle = low + (high - low) / 2;
+
+        if (trace->checkpoints[middle].index <= index + 1) {
+            checkpoint = &trace->checkpoints[middle];
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    if (checkpoint == NULL) {
+        if (restore(state, NULL, 0) != 0)
+            return -1;
+
+        i = 0;
+    } else {
+        if (restore(state, checkpoint->state, checkpoint->length) != 0)
+            return -1;
+
+        i = checkpoint->index;
+    }
+
+    for (; i <= index; i++) {
+        if ((record = steptrace_at(trace, i)) == NULL || apply(state, record) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/*
+    Header, then per chunk its record count, whether it is encoded and
+    its length, then per checkpoint its index and length; in the byte
+    order of the machine that wrote it
+*/
+int steptrace_save (StepTrace *trace, FILE *out) {
+    int header[4], head[2], i, count;
+    unsigned int length;
+    const void *bytes;
+
+    header[0] = trace->record_size;
+    header[1] = trace->interval;
+    header[2] = trace->size;
+    header[3] = trace->checkpoint_count;
+
+    if (steptrace_write(out, steptrace_magic, sizeof(steptrace_magic)) != 0 ||
+        steptrace_write(out, header, sizeof(header)) != 0)
+        return -1;
+
+    for (i = 0; i < trace->chunk_count; i++) {
+        count = i < trace->chunk_count - 1 ? STEPTRACE_CHUNK : trace->size - i * STEPTRACE_CHUNK;
+        bytes = trace->chunks[i];
+
+        if (trace->lengths[i] > 0) {
+            length = (unsigned int)trace->lengths[i];
+        } else if (trace->encode != NULL) {
+            if ((length = (unsigned int)trace->encode(trace->chunks[i], count, trace->scratch)) == 0)
+                return -1;
+
+            bytes = trace->scratch;
+        } else {
+            length = (unsigned int)count * trace->record_size;
+        }
+
+        head[0] = count;
+        head[1] = trace->encode != NULL;
+
+        if (steptrace_write(out, head, sizeof(head)) != 0 || steptrace_write(out, &length, sizeof(length)) != 0 ||
+            steptrace_write(out, bytes, length) != 0)
+            return -1;
+    }
+
+    for (i = 0; i < trace->checkpoint_count; i++) {
+        length = (unsigned int)trace->checkpoints[i].length;
+
+        if (steptrace_write(out, &trace->checkpoints[i].index, sizeof(int)) != 0 ||
+            steptrace_write(out, &length, sizeof(length)) != 0 ||
+            steptrace_write(out, trace->checkpoints[i].state, length) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/*
+    One saved chunk of count records, its records go through
+    steptrace_append so that they are sealed again
+*/
+static int steptrace_load_chunk (StepTrace *trace, FILE *in, char *plain, int *count) {
+    int head[2], k, status = 0;
+    unsigned int length;
+    unsigned char *bytes;
+
+    if (steptrace_read(in, head, sizeof(head)) != 0 || steptrace_read(in, &length, sizeof(length)) != 0 ||
+        head[0] <= 0 || head[0] > STEPTRACE_CHUNK || (head[1] && trace->decode == NULL) ||
+        (!head[1] && length != (unsigned int)head[0] * trace->record_size))
+        return -1;
+
+    if ((bytes = (unsigned char *)malloc(length > 0 ? length : 1)) == NULL)
+        return -1;
+
+    if (steptrace_read(in, bytes, length) != 0 || (head[1] && trace->decode(bytes, length, plain, head[0]) != 0))
+        status = -1;
+
+    for (k = 0; k < head[0] && status == 0; k++) {
+        if (steptrace_append(trace, (head[1] ? plain : (char *)bytes) + (size_t)k * trace->record_size) != 0)
+            status = -1;
+    }
+
+    free(bytes);
+    *count = head[0];
+
+    return status;
+}
+
+/*
+    Read one saved checkpoint and add it to the trace
+*/
+static int steptrace_load_checkpoint (StepTrace *trace, FILE *in) {
+    unsigned int length;
+    unsigned char *bytes;
+    int index, status = 0;
+
+    if (steptrace_read(in, &index, sizeof(int)) != 0 || steptrace_read(in, &length, sizeof(length)) != 0)
+        return -1;
+
+    if ((bytes = (unsigned char *)malloc(length > 0 ? length : 1)) == NULL)
+        return -1;
+
+    if (steptrace_read(in, bytes, length) != 0 || steptrace_add_checkpoint(trace, index, bytes, length) != 0)
+        status = -1;
+
+    free(bytes);
+
+    return status;
+}
+
+/*
+    Read the next trace written by steptrace_save
+*/
+int steptrace_load (StepTrace *trace, FILE *in) {
+    char magic[sizeof(steptrace_magic)];
+    int header[4], i, count, records = 0, status = 0;
+    char *plain;
+
+    if (trace->size > 0)
+        return -1;
+
+    if (fread(magic, 1, sizeof(magic), in) == 0 && feof(in))
+        return 1;
+
+    if (memcmp(magic, steptrace_magic, sizeof(magic)) != 0 || steptrace_read(in, header, sizeof(header)) != 0 ||
+        header[0] != trace->record_size || header[1] <= 0 || header[2] < 0 || header[3] < 0)
+        return -1;
+
+    trace->interval = header[1];
+
+    if ((plain = (char *)malloc((size_t)STEPTRACE_CHUNK * trace->record_size)) == NULL)
+        return -1;
+
+    while (records < header[2] && status == 0) {
+        status = steptrace_load_chunk(trace, in, plain, &count);
+        records += count;
+    }
+
+    for (i = 0; i < header[3] && status == 0; i++)
+        status = steptrace_load_checkpoint(trace, in);
+
+    free(plain);
+
+    return status;
+}
@@ -0,0 +1,147 @@
+/*
+    stepview.c
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stepview.h"
+
+/*
+    Initialize the viewer on its first page
+*/
+int stepview_init (StepView *view, int rows, int height, int (*render)(void *data, int row, char *line, int size),
+                   void *data) {
+
+    if (rows < 0 || height < 1 || render == NULL)
+        return -1;
+
+    view->rows = rows;
+    view->height = height;
+    view->top = 0;
+    view->render = render;
+    view->data = data;
+    view->query[0] = '\0';
+    view->found = -1;
+
+    return 0;
+}
+
+/*
+    Render the rows of the window, the number drawn or -1
+*/
+int stepview_draw (StepView *view, FILE *out) {
+    char line[STEPVIEW_LINE];
+    int row;
+
+    for (row = view->top; row < stepview_bottom(view); row++) {
+        if (view->render(view->data, row, line, STEPVIEW_LINE) != 0)
+            return -1;
+
+        fprintf(out, "%s\n", line);
+    }
+
+    return row - view->top;
+}
+
+/*
+    Move the window by delta rows, keeping it inside the table
+*/
+void stepview_scroll (StepView *view, int delta) {
+
+    stepview_goto(view, view->top + delta);
+
+    return;
+}
+
+/*
+    Put row at the top of the window, or the last page when it is near
+    the end
+*/
+void stepview_goto (StepView *view, int row) {
+
+    if (row > view->rows - view->height)
+        row = view->rows - view->height;
+
+    view->top = row < 0 ? 0 : row;
+
+    return;
+}
+
+/*
+    Search for text one row at a time, wrapping around once
+*/
+int stepview_search (StepView *view, const char *text) {
+    char line[STEPVIEW_LINE];
+    int start, i, row;
+
+    if (text[0] == '\0' || view->rows == 0)
+        return -1;
+
+    if (text != view->query) {
+        strncpy(view->query, text, STEPVIEW_QUERY - 1);
+        view->query[STEPVIEW_QUERY - 1] = '\0';
+    }
+
+    start = view->found >= 0 ? view->found + 1 : view->top;
+
+    for (i = 0; i < view->rows; i++) {
+        row = (start + i) % view->rows;
+
+        if (view->render(view->data, row, line, STEPVIEW_LINE) != 0)
+            return -1;
+
+        if (strstr(line, view->query) != NULL) {
+            view->found = row;
+            stepview_goto(view, row);
+            return row;
+        }
+    }
+
+    return -1;
+}
+
+/*
+    Do one command typed by the user
+*/
+int stepview_command (StepView *view, const char *command) {
+
+    while (*command == ' ')
+        command++;
+
+    switch (command[0]) {
+        case '\0':
+        case 'n':
+            if (command[0] != '\0' && command[1] != '\0')
+                return -1;
+
+            if (stepview_bottom(view) >= view->rows)
+                return STEPVIEW_QUIT;
+
+            stepview_scroll(view, view->height);
+            return 0;
+
+        case 'p':
+            if (command[1] != '\0')
+                return -1;
+
+            stepview_scroll(view, -view->height);
+            return 0;
+
+        case 'g':
+            if (atoi(command + 1) < 1 || atoi(command + 1) > view->rows)
+                return -1;
+
+            stepview_goto(view, atoi(command + 1) - 1);
+            return 0;
+
+        case '/':
+            return stepview_search(view, command[1] != '\0' ? command + 1 : view->query) < 0 ? -1 : 0;
+
+        case 'q':
+            return command[1] == '\0' ? STEPVIEW_QUIT : -1;
+
+        default:
+            return -1;
+    }
+}
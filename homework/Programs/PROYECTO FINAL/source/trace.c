@@ -0,0 +1,185 @@
+/*
+    trace.c
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "trace.h"
+
+int trace_on = 0;
+
+/*
+    Every thread buffer, pushed lock-free at registration
+*/
+static TraceBuffer *buffers = NULL;
+static int next_tid = 0;
+static const char *trace_path = NULL;
+static unsigned long long trace_epoch = 0;
+
+static __thread TraceBuffer *local_buffer = NULL;
+
+/*
+    Get the buffer of the calling thread, registering it on first use
+*/
+static TraceBuffer *trace_buffer (void) {
+    TraceBuffer *buffer;
+
+    if (local_buffer != NULL)
+        return local_buffer;
+
+    if ((buffer = (TraceBuffer *)calloc(1, sizeof(TraceBuffer))) == NULL)
+        return NULL;
+
+    buffer->tid = __atomic_add_fetch(&next_tid, 1, __ATOMIC_RELAXED);
+    buffer->next = __atomic_load_n(&buffers, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&buffers, &buffer->next, buffer, 1,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    local_buffer = buffer;
+
+    return buffer;
+}
+
+/*
+    Write the trace at exit
+*/
+static void trace_at_exit (void) {
+    FILE *out;
+
+    if ((out = fopen(trace_path, "w")) == NULL)
+        return;
+
+    trace_write(out);
+    fclose(out);
+}
+
+/*
+    Enable the tracer when CALC_TRACE names an output file
+*/
+void trace_init (void) {
+    const char *path = getenv("CALC_TRACE");
+
+    if (path != NULL && *path != '\0')
+        trace_enable(path);
+
+    return;
+}
+
+/*
+    Enable the tracer, the Chrome trace JSON is written to path at exit
+*/
+void trace_enable (const char *path) {
+    if (trace_on)
+        return;
+
+    trace_path = path;
+    trace_epoch = stats_now();
+    trace_on = 1;
+
+    atexit(trace_at_exit);
+
+    return;
+}
+
+/*
+    Record an event in the buffer of the calling thread
+*/
+void trace_event (char ph, const char *name, const char *cat, long id) {
+    TraceBuffer *buffer;
+    TraceChunk *chunk;
+    TraceEvent *event;
+
+    if ((buffer = trace_buffer()) == NULL)
+        return;
+
+    chunk = buffer->tail;
+
+    if (chunk == NULL || chunk->size == TRACE_CHUNK) {
+        if ((chunk = (TraceChunk *)malloc(sizeof(TraceChunk))) == NULL)
+            return;
+
+        chunk->size = 0;
+        chunk->next = NULL;
+
+        // Publish the chunk after it is initialized
+        if (buffer->tail == NULL)
+            __atomic_store_n(&buffer->head, chunk, __ATOMIC_RELEASE);
+        else
+            __atomic_store_n(&buffer->tail->next, chunk, __ATOMIC_RELEASE);
+
+        buffer->tail = chunk;
+    }
+
+    event = &chunk->events[chunk->size];
+    event->name = name;
+    event->cat = cat;
+    event->ts = stats_now();
+    event->id = id;
+    event->ph = ph;
+
+    __atomic_store_n(&chunk->size, chunk->size + 1, __ATOMIC_RELEASE);
+
+    return;
+}
+
+/*
+    Name the calling thread in the trace viewer
+*/
+void trace_thread_name (const char *name) {
+    TraceBuffer *buffer;
+
+    if (!trace_on || (buffer = trace_buffer()) == NULL)
+        return;
+
+    buffer->thread_name = name;
+
+    return;
+}
+
+/*
+    Write every buffer as Chrome trace JSON
+*/
+int trace_write (FILE *out) {
+    TraceBuffer *buffer;
+    TraceChunk *chunk;
+    TraceEvent *event;
+    int first = 1;
+    int i, size;
+
+    fprintf(out, "{\"traceEvents\":[");
+
+    for (buffer = __atomic_load_n(&buffers, __ATOMIC_ACQUIRE); buffer != NULL; buffer = buffer->next) {
+        if (buffer->thread_name != NULL) {
+            fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}", first ? "" : ",", buffer->tid, buffer->thread_name);
+            first = 0;
+        }
+
+        for (chunk = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE); chunk != NULL;
+             chunk = __atomic_load_n(&chunk->next, __ATOMIC_ACQUIRE)) {
+            size = __atomic_load_n(&chunk->size, __ATOMIC_ACQUIRE);
+
+            for (i = 0; i < size; i++) {
+                event = &chunk->events[i];
+
+                fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                        first ? "" : ",", event->name, event->cat, event->ph, buffer->tid,
+                        (event->ts - trace_epoch) / 1000.0);
+
+                if (event->id >= 0)
+                    fprintf(out, ",\"args\":{\"id\":%ld}", event->id);
+
+                fprintf(out, "}");
+                first = 0;
+            }
+        }
+    }
+
+    fprintf(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    return ferror(out) ? -1 : 0;
+}
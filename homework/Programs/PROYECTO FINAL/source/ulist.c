@@ -0,0 +1,226 @@
+/*
+    ulist.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "ulist.h"
+
+/*
+    New empty node linked after node, at the head when node is NULL
+*/
+static UListNode *ulist_node_after (UList *list, UListNode *node) {
+    UListNode *new_node;
+
+    if ((new_node = (UListNode *)malloc(sizeof(UListNode))) == NULL)
+        return NULL;
+
+    new_node->count = 0;
+
+    if (node == NULL) {
+        new_node->next = list->head;
+        list->head = new_node;
+    } else {
+        new_node->next = node->next;
+        node->next = new_node;
+    }
+
+    if (new_node->next == NULL)
+        list->tail = new_node;
+
+    return new_node;
+}
+
+/*
+    Unlink and free an empty node, prev is the node before it or NULL
+*/
+static void ulist_node_remove (UList *list, UListNode *prev, UListNode *node) {
+    if (prev == NULL)
+        list->head = node->next;
+    else
+        prev->next = node->next;
+
+    if (list->tail == node)
+        list->tail = prev;
+
+    free(node);
+
+    return;
+}
+
+/*
+    Initialize the ulist
+*/
+void ulist_init (UList *list, void (*destroy)(void *data)) {
+    list->size = 0;
+    list->destroy = destroy;
+    list->head = NULL;
+    list->tail = NULL;
+
+    return;
+}
+
+/*
+    Destroying the ulist
+*/
+void ulist_destroy (UList *list) {
+    UListNode *node, *next;
+    int i;
+
+    for (node = list->head; node != NULL; node = next) {
+        next = node->next;
+
+        if (list->destroy != NULL) {
+            for (i = 0; i < node->count; i++)
+                list->destroy(node->data[i]);
+        }
+
+        free(node);
+    }
+
+    memset(list, 0, sizeof(UList));
+    return;
+}
+
+/*
+    Insert after the element at pos, at the head when pos is NULL
+    A full node is split in half, except when appending at its end
+*/
+int ulist_ins_next (UList *list, const UListPos *pos, const void *data) {
+    UListNode *node, *new_node;
+    int index, half;
+
+    if (pos == NULL) {
+        node = list->head;
+        index = 0;
+    } else {
+        node = pos->node;
+        index = pos->index + 1;
+    }
+
+    if (node == NULL) {
+        if ((node = ulist_node_after(list, NULL)) == NULL)
+            return -1;
+    } else if (node->count == ULIST_NODE_CAPACITY) {
+        if ((new_node = ulist_node_after(list, node)) == NULL)
+            return -1;
+
+        if (index == ULIST_NODE_CAPACITY) {
+            node = new_node;
+            index = 0;
+        } else {
+            half = ULIST_NODE_CAPACITY / 2;
+
+            memcpy(new_node->data, node->data + half, (ULIST_NODE_CAPACITY - half) * sizeof(void *));
+            new_node->count = ULIST_NODE_CAPACITY - half;
+            node->count = half;
+
+            if (index > half) {
+                node = new_node;
+                index -= half;
+            }
+        }
+    }
+
+    memmove(node->data + index + 1, node->data + index, (node->count - index) * sizeof(void *));
+    node->data[index] = (void *)data;
+    node->count++;
+    list->size++;
+
+    return 0;
+}
+
+/*
+    Remove the element after pos, the head when pos is NULL
+    A node left under a quarter full absorbs its successor when they fit
+*/
+int ulist_rem_next (UList *list, const UListPos *pos, void **data) {
+    UListNode *prev = NULL, *node, *next;
+    int index;
+
+    if (ulist_size(list) == 0)
+        return -1;
+
+    if (pos == NULL) {
+        node = list->head;
+        index = 0;
+    } else if (pos->index + 1 < pos->node->count) {
+        node = pos->node;
+        index = pos->index + 1;
+    } else {
+        // Can not remove at the end of the list
+        if (pos->node->next == NULL)
+            return -1;
+
+        prev = pos->node;
+        node = prev->next;
+        index = 0;
+    }
+
+    *data = node->data[index];
+
+    memmove(node->data + index, node->data + index + 1, (node->count - index - 1) * sizeof(void *));
+    node->count--;
+    list->size--;
+
+    if (node->count == 0) {
+        ulist_node_remove(list, prev, node);
+        return 0;
+    }
+
+    next = node->next;
+
+    if (node->count < ULIST_NODE_CAPACITY / 4 && next != NULL
+        && node->count + next->count <= ULIST_NODE_CAPACITY) {
+        memcpy(node->data + node->count, next->data, next->count * sizeof(void *));
+        node->count += next->count;
+        next->count = 0;
+        ulist_node_remove(list, node, next);
+    }
+
+    return 0;
+}
+
+/*
+    Position of the first element, -1 when the ulist is empty
+*/
+int ulist_head (const UList *list, UListPos *pos) {
+    if (list->head == NULL)
+        return -1;
+
+    pos->node = list->head;
+    pos->index = 0;
+
+    return 0;
+}
+
+/*
+    Position of the last element, -1 when the ulist is empty
+*/
+int ulist_tail (const UList *list, UListPos *pos) {
+    if (list->tail == NULL)
+        return -1;
+
+    pos->node = list->tail;
+    pos->index = list->tail->count - 1;
+
+    return 0;
+}
+
+/*
+    Move pos to the next element, -1 at the end of the ulist
+*/
+int ulist_next (UListPos *pos) {
+    if (pos->index + 1 < pos->node->count) {
+        pos->index++;
+        return 0;
+    }
+
+    if (pos->node->next == NULL)
+        return -1;
+
+    pos->node = pos->node->next;
+    pos->index = 0;
+
+    return 0;
+}
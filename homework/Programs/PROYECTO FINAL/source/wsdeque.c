@@ -0,0 +1,191 @@
+/*
+    wsdeque.c
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "wsdeque.h"
+
+/*
+    Slots are read by thieves while the owner may write the same slot of
+    a wrapped array; the CAS on top decides who keeps the value, so the
+    slot accesses only need to be atomic, not ordered
+*/
+#define wsdeque_get(array, i) \
+    __atomic_load_n(&(array)->buffer[(size_t)(i) & (array)->mask], __ATOMIC_RELAXED)
+#define wsdeque_set(array, i, data) \
+    __atomic_store_n(&(array)->buffer[(size_t)(i) & (array)->mask], (data), __ATOMIC_RELAXED)
+
+/*
+    Allocate an array of size slots
+*/
+static WSDequeArray *wsdeque_array (size_t size) {
+    WSDequeArray *array;
+
+    if ((array = (WSDequeArray *)malloc(sizeof(WSDequeArray))) == NULL)
+        return NULL;
+
+    if ((array->buffer = (void **)malloc(size * sizeof(void *))) == NULL) {
+        free(array);
+        return NULL;
+    }
+
+    array->mask = size - 1;
+    array->retired = NULL;
+
+    return array;
+}
+
+/*
+    Double the array, copying the elements from top to bottom
+    Owner thread only
+*/
+static WSDequeArray *wsdeque_grow (WSDeque *deque, WSDequeArray *old, long top, long bottom) {
+    WSDequeArray *array;
+    long i;
+
+    if ((array = wsdeque_array((old->mask + 1) * 2)) == NULL)
+        return NULL;
+
+    for (i = top; i < bottom; i++)
+        wsdeque_set(array, i, wsdeque_get(old, i));
+
+    array->retired = old;
+    __atomic_store_n(&deque->array, array, __ATOMIC_RELEASE);
+
+    return array;
+}
+
+/*
+    Initialize, the capacity is rounded up to a power of two
+*/
+int wsdeque_init (WSDeque *deque, size_t capacity, void (*destroy)(void *data)) {
+    size_t size = 2;
+
+    while (size < capacity)
+        size <<= 1;
+
+    memset(deque, 0, sizeof(WSDeque));
+
+    if ((deque->array = wsdeque_array(size)) == NULL)
+        return -1;
+
+    deque->destroy = destroy;
+
+    return 0;
+}
+
+/*
+    Destroy, no thread may be using the deque
+*/
+void wsdeque_destroy (WSDeque *deque) {
+    WSDequeArray *array, *retired;
+    long i;
+
+    array = deque->array;
+
+    if (deque->destroy != NULL) {
+        for (i = deque->top; i < deque->bottom; i++)
+            deque->destroy(wsdeque_get(array, i));
+    }
+
+    while (array != NULL) {
+        retired = array->retired;
+        free(array->buffer);
+        free(array);
+        array = retired;
+    }
+
+    memset(deque, 0, sizeof(WSDeque));
+
+    return;
+}
+
+/*
+    Push at the bottom, grows the array when full
+    Owner thread only
+*/
+int wsdeque_push (WSDeque *deque, const void *data) {
+    WSDequeArray *array;
+    long bottom, top;
+
+    bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+
+    if ((size_t)(bottom - top) > array->mask) {
+        if ((array = wsdeque_grow(deque, array, top, bottom)) == NULL)
+            return -1;
+    }
+
+    wsdeque_set(array, bottom, (void *)data);
+
+    // Publishes the slot to the thieves
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+    Pop from the bottom, the most recently pushed element
+    Returns WSDEQUE_EMPTY when there is nothing left for the owner
+    Owner thread only
+*/
+int wsdeque_pop (WSDeque *deque, void **data) {
+    WSDequeArray *array;
+    long bottom, top;
+    int retval = 0;
+
+    bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+
+    // Claim the slot before looking at top; pairs with the loads in steal
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_SEQ_CST);
+    top = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+
+    if (top > bottom) {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return WSDEQUE_EMPTY;
+    }
+
+    *data = wsdeque_get(array, bottom);
+
+    if (top == bottom) {
+        // Last element, race the thieves for it
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            retval = WSDEQUE_EMPTY;
+
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+
+    return retval;
+}
+
+/*
+    Steal from the top, the oldest element
+    Returns WSDEQUE_EMPTY when the deque is empty and WSDEQUE_ABORT when
+    another thread took the element first, worth retrying
+*/
+int wsdeque_steal (WSDeque *deque, void **data) {
+    WSDequeArray *array;
+    long bottom, top;
+    void *value;
+
+    top = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+    bottom = __atomic_load_n(&deque->bottom, __ATOMIC_SEQ_CST);
+
+    if (top >= bottom)
+        return WSDEQUE_EMPTY;
+
+    array = __atomic_load_n(&deque->array, __ATOMIC_ACQUIRE);
+    value = wsdeque_get(array, top);
+
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return WSDEQUE_ABORT;
+
+    *data = value;
+
+    return 0;
+}